@@ -25,6 +25,7 @@
 #include "SampleBuffer.h"
 #include "Position.h"
 #include "tinyxml2.h"
+#include "../../plugins/physics/odor_physics/ArenaGeometry.h"
 
 #define PI 3.14159265359
 #define TIME_STEP           64 //adjusts the speed (ms)
@@ -57,8 +58,7 @@ vector<double> sensor_measurements;
 Position source_position;
 
 int map_nbr = 0;
-int nbr_obstacle=0;
-float **obstacles = NULL;
+ArenaGeometry arena; // obstacles (for in_obstacle)
 
 // log files names
 char folder_name[256];
@@ -119,22 +119,13 @@ void init(){
         //set other sensors position to 0
         place_sensor_to_zero(i);
     }
-    //read and save the obstacle list
-    // open file
-	std::ifstream obstacle_file("../../data/obstacle_list.txt");
-	// first line is the number of obstacles
-	obstacle_file >> nbr_obstacle;
-	printf("There is %d obsatcle in total:\n",nbr_obstacle);
-	// allocate memory for obstacle list array
-	obstacles = new float*[nbr_obstacle];
-	//read all obstacles now
-	for(int i = 0; i < nbr_obstacle; i++){
-		obstacles[i] = new float[4];
-		obstacle_file >> obstacles[i][0] >> obstacles[i][1] >> obstacles[i][2] >> obstacles[i][3];
-	}
-
-	for(int i = 0; i < nbr_obstacle; i++){
-		printf("obstacle %d: %f %f %f %f\n", i, obstacles[i][0], obstacles[i][1], obstacles[i][2], obstacles[i][3]);
+    //read the obstacle list
+	arena.ReadObstacleFile("../../data/obstacle_list.txt");
+	arena.Build();
+	printf("There is %d obsatcle in total:\n", arena.GetObstacleCount());
+	for(int i = 0; i < arena.GetObstacleCount(); i++){
+		const ArenaGeometry::tObstacle &o = arena.GetObstacle(i);
+		printf("obstacle %d: %f %f %f %f\n", i, o.xmin, o.ymin, o.xmax, o.ymax);
 	}
 
     // set the source position randomly (on upperwind half on x)
@@ -192,7 +183,7 @@ void setup_log_folder(){
 }
 
 bool in_obstacle(Position pos){
-    // returns true if position in inside obstacle
+    // returns true if position in inside obstacle (borders included)
     float x = pos.x;
     float y = pos.y;
     //obstacles (traning_map1, 4 rectangles)
@@ -204,12 +195,7 @@ bool in_obstacle(Position pos){
     //     return true;
     // if(x >= 5 && x <= 5.5 && y >= 2.5 && y <= 4)
     //     return true;
-    for(int i = 0; i < nbr_obstacle; i++){
-        if(x >= obstacles[i][0] && y >= obstacles[i][1] && x <= obstacles[i][2] && y <= obstacles[i][3])
-            return true;
-    }
-    // if none of the above, then out of obstacle
-    return false;
+    return arena.InsideObstacle(x, y, ArenaGeometry::sBordersClosed) != -1;
 }
 
 void read_sensor_positions_from_file(){
@@ -412,6 +398,9 @@ int main() {
     int i = 0;
     int n_samples = 0;
     int wait = 200;
+    if (getenv("CHECKPOINT_LOAD") != NULL) {
+        wait = 0; //the odor plugin continues from a checkpoint with an established plume
+    }
 
     init();
     printf("Finish init\n");
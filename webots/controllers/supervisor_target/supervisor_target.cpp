@@ -20,6 +20,7 @@
 #include <webots/supervisor.h>
 #include <webots/robot.h>
 #include "../controller_STE_clean/Message.h"
+#include "../../plugins/physics/odor_physics/ArenaGeometry.h"
 
 #define MAX_NB_ROBOTS   3
 #define STEP_SIZE       64
@@ -45,9 +46,8 @@ struct message{
 char ID_name[50];
 
 // obstacles definitions
-int nbr_obs = 4;
 float margin = 0.2;
-float ** obstacles = NULL;
+ArenaGeometry arena; // obstacles (including the margin)
 
 char* strcat_robot_ID(char * str, int ID){
     sprintf(ID_name, "%s%d",  str, ID);
@@ -63,43 +63,20 @@ long long current_timestamp(){
 }
 
 void read_obstacle_list(){
-    // open file
-    std::ifstream infile("../../data/obstacle_list.txt");
-    // first line is the number of obstacles
-    infile >> nbr_obs;
-    // allocate memory for obstacle list array
-    obstacles = new float*[nbr_obs];
-    // read all obstacles now
-    for(int i = 0; i < nbr_obs; i++){
-        obstacles[i] = new float[4];
-        infile >> obstacles[i][0] >> obstacles[i][1] >> obstacles[i][2] >> obstacles[i][3];
-        obstacles[i][0] -= margin;
-        obstacles[i][1] -= margin;
-        obstacles[i][2] += margin;
-        obstacles[i][3] += margin;
-    }
+    // first line is the number of obstacles, then one obstacle per line
+    arena.ReadObstacleFile("../../data/obstacle_list.txt", margin);
+    arena.Build();
 
-    for(int i = 0; i < nbr_obs; i++){
-        printf("obstacle %d: %f %f %f %f\n", i, obstacles[i][0], obstacles[i][1], obstacles[i][2], obstacles[i][3]);
+    for(int i = 0; i < arena.GetObstacleCount(); i++){
+        const ArenaGeometry::tObstacle &o = arena.GetObstacle(i);
+        printf("obstacle %d: %f %f %f %f\n", i, o.xmin, o.ymin, o.xmax, o.ymax);
     }
 }
 
-bool is_in_obstacle(float x, float y, float obs_xmin, float obs_xmax, float obs_ymin, float obs_ymax){
-    if(x > obs_xmin && x < obs_xmax && y > obs_ymin && y < obs_ymax)
-        return true;
-    else
-        return false;
-}
-
-int is_in_obstacle_list(float x, float y, float ** obs_list, int nbr_obs){
-    // gets an obstacle list and number of obstacles as input
-    // returns the index of the obstacle that the position is in 
+int is_in_obstacle_list(float x, float y){
+    // returns the index of the obstacle that the position is in (strictly inside, borders excluded)
     // if the position is not in any obstacles, then -1 is returned
-    for(int i = 0; i < nbr_obs; i++){
-        if(is_in_obstacle(x, y, obs_list[i][0], obs_list[i][2], obs_list[i][1], obs_list[i][3]))
-            return i;
-    }
-    return -1;
+    return arena.InsideObstacle(x, y, ArenaGeometry::sBordersOpen);
 }
 
 // _________main___________
@@ -141,13 +118,13 @@ int main(void){
         fclose(sim_param_file);  
     }
     //make sure the source is not in an obstacle
-    if (is_in_obstacle_list(source_position[0], source_position[1], obstacles, nbr_obs) != -1){
+    if (is_in_obstacle_list(source_position[0], source_position[1]) != -1){
         printf("The source is in an obstacle, randomizing the position!!!\n");
         do{
             source_position[0] = 12.7;
             source_position[1] = (((double)rand() / (double)RAND_MAX) * (YMAX - YMIN - SAFETY_MARGIN*2)) + SAFETY_MARGIN + YMIN;
             source_position[2] = 0.13;
-        }while(is_in_obstacle_list(source_position[0], source_position[1], obstacles, nbr_obs) != -1);
+        }while(is_in_obstacle_list(source_position[0], source_position[1]) != -1);
     }
     wb_supervisor_field_set_sf_vec3f(wb_supervisor_node_get_field(wb_supervisor_node_get_from_def("SOURCE_ODOR_0"),"translation"), source_position);
     //wb_emitter_send(emitter, source_position, sizeof(double)*3);
@@ -165,7 +142,7 @@ int main(void){
             robot_position[0] = (((double)rand() / (double)RAND_MAX) * (5 - XMIN - SAFETY_MARGIN*2)) + SAFETY_MARGIN + XMIN;
             robot_position[1] = (((double)rand() / (double)RAND_MAX) * (YMAX - YMIN - SAFETY_MARGIN*2)) + SAFETY_MARGIN + YMIN;
             robot_position[2] = 0;
-        }while(is_in_obstacle_list(robot_position[0], robot_position[1], obstacles, nbr_obs) != -1);
+        }while(is_in_obstacle_list(robot_position[0], robot_position[1]) != -1);
         wb_supervisor_field_set_sf_vec3f(wb_supervisor_node_get_field(wb_supervisor_node_get_from_def(strcat_robot_ID("n",i+101)),"translation"), robot_position);
         wb_supervisor_field_set_sf_vec3f(wb_supervisor_node_get_field(wb_supervisor_node_get_from_def(strcat_robot_ID("goal_",i+101)),"translation"), robot_position);
     
@@ -229,10 +206,6 @@ int main(void){
     rename("../../../Results/current", folder_name);
 
     //clean up and exit
-    //free the allocated memory to obstacle array
-    for(int i = 0; i < nbr_obs; i++)
-        delete[] obstacles[i];
-    delete[] obstacles;
     // wb_supervisor_world_reload(); 
     wb_supervisor_simulation_quit(EXIT_SUCCESS);
     wb_robot_cleanup();
@@ -0,0 +1,359 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classArenaGeometry
+#define classArenaGeometry
+
+class ArenaGeometry;
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include "ObstacleBVH.h"
+
+//!	The 2D geometry of the arena: its outer boundary (a polygon) and the obstacles (rectangles).
+/*!
+	The boundary is read from an environment file (e.g. data/test_map.environment: one "x y" point per line, counterclockwise, lines starting with "//" are comments), and the obstacles from an obstacle file (e.g. data/obstacle_list.txt: the number of obstacles, followed by "xmin ymin xmax ymax" for each obstacle).
+	Build rasterizes the boundary into a grid of cells, which are classified as inside, outside, or crossed by an edge (with a scanline over the cell centres). InsideArena then needs a single table lookup for most points, and only tests the few edges spanning the point's grid row otherwise.
+	Obstacle lookups use a bounding volume hierarchy (see ObstacleBVH).
+	Like ObstacleBVH, this class only depends on the standard library, so that controllers can include it as well (e.g. with #include "../../plugins/physics/odor_physics/ArenaGeometry.h").
+
+	Usage:
+		ArenaGeometry arena;
+		arena.ReadEnvironmentFile("../../data/test_map.environment");
+		arena.ReadObstacleFile("../../data/obstacle_list.txt");
+		arena.Build();
+		bool free = arena.IsFree(x, y);					// inside the arena, and not in an obstacle
+*/
+class ArenaGeometry {
+
+public:
+	//! A point of the boundary.
+	struct tPoint {
+		double x;
+		double y;
+	};
+	//! An obstacle (rectangle).
+	struct tObstacle {
+		double xmin;
+		double ymin;
+		double xmax;
+		double ymax;
+	};
+	//! Which borders of an obstacle belong to it.
+	enum eBorders {
+		sBordersHalfOpen,				//!< [min, max), as the boxes of ObstacleList.
+		sBordersClosed,					//!< [min, max].
+		sBordersOpen					//!< (min, max).
+	};
+
+protected:
+	//! Classification of the grid cells.
+	enum eCell {
+		sCellOutside = 0,				//!< Entirely outside of the arena.
+		sCellInside,					//!< Entirely inside the arena.
+		sCellEdge,						//!< Crossed (or touched) by an edge of the boundary.
+	};
+
+	//! The outer boundary (counterclockwise, the last point is connected to the first).
+	std::vector<tPoint> mBoundary;
+	//! The obstacles.
+	std::vector<tObstacle> mObstacles;
+	//! Bounding volume hierarchy over the obstacles.
+	ObstacleBVH mObstacleBVH;
+
+	//! First cell of the grid (the minimum corner of the boundary).
+	tPoint mOrigin;
+	//! Edge length of the cells, and its inverse.
+	double mCellSize;
+	double mCellSizeInv;
+	//! Number of cells on each axis (0 if there is no boundary).
+	int mCellsX;
+	int mCellsY;
+	//! Classification of each cell (x varies fastest).
+	std::vector<unsigned char> mCells;
+	//! First entry of each grid row in mRowEdges, followed by the total number of entries.
+	std::vector<int> mRowEdgeStart;
+	//! Edges (index of their first point) spanning each grid row.
+	std::vector<int> mRowEdges;
+
+	//! Returns true if the ray from (x, y) towards +x crosses the edge from a to b. Vertices are counted for the edge above them only, such that the crossing number of a closed polygon is exact.
+	static bool Crosses(const tPoint &a, const tPoint &b, double x, double y) {
+		return ((a.y > y) != (b.y > y)) && (x < a.x + (b.x - a.x) * (y - a.y) / (b.y - a.y));
+	}
+
+	//! Returns the edge from point i to the next point.
+	void GetEdge(int i, tPoint &a, tPoint &b) const {
+		a = mBoundary[i];
+		b = mBoundary[i + 1 < (int)mBoundary.size() ? i + 1 : 0];
+	}
+
+	//! Returns true if the edge from a to b touches the rectangle [x0, x1] x [y0, y1]. The bounding boxes are assumed to overlap.
+	static bool EdgeTouchesRectangle(const tPoint &a, const tPoint &b, double x0, double y0, double x1, double y1) {
+		// The edge misses the rectangle if all corners are strictly on the same side of its line
+		double ex = b.x - a.x;
+		double ey = b.y - a.y;
+		double c00 = ex * (y0 - a.y) - ey * (x0 - a.x);
+		double c10 = ex * (y0 - a.y) - ey * (x1 - a.x);
+		double c01 = ex * (y1 - a.y) - ey * (x0 - a.x);
+		double c11 = ex * (y1 - a.y) - ey * (x1 - a.x);
+		return ! (((c00 > 0) && (c10 > 0) && (c01 > 0) && (c11 > 0)) || ((c00 < 0) && (c10 < 0) && (c01 < 0) && (c11 < 0)));
+	}
+
+	//! Returns the grid rows [first, last] spanned by the interval [a, b] along y.
+	void RowRange(double a, double b, int &first, int &last) const {
+		first = (int)floor((a - mOrigin.y) * mCellSizeInv);
+		last = (int)floor((b - mOrigin.y) * mCellSizeInv);
+		first = (first < 0 ? 0 : first);
+		last = (last >= mCellsY ? mCellsY - 1 : last);
+	}
+
+public:
+	//! Constructor.
+	ArenaGeometry(): mBoundary(), mObstacles(), mObstacleBVH(), mCellSize(0), mCellSizeInv(0), mCellsX(0), mCellsY(0), mCells(), mRowEdgeStart(), mRowEdges() {
+		mOrigin.x = 0;
+		mOrigin.y = 0;
+	}
+
+	//! Removes the boundary and all obstacles.
+	void Clear() {
+		mBoundary.clear();
+		mObstacles.clear();
+		mObstacleBVH.Clear();
+		Build();
+	}
+
+	//! Appends a point to the boundary. Build must be called before the next query.
+	void AddBoundaryPoint(double x, double y) {
+		tPoint p = {x, y};
+		mBoundary.push_back(p);
+	}
+	//! Adds an obstacle, and returns its index. Build must be called before the next query.
+	int AddObstacle(double xmin, double ymin, double xmax, double ymax) {
+		tObstacle o = {xmin, ymin, xmax, ymax};
+		mObstacles.push_back(o);
+		return mObstacleBVH.Add(xmin, ymin, -1e9, xmax, ymax, 1e9);
+	}
+
+	//! Reads the boundary from an environment file (replacing the current boundary). Returns false if the file could not be read.
+	bool ReadEnvironmentFile(const std::string &filename) {
+		std::ifstream file(filename.c_str());
+		if (! file) {
+			return false;
+		}
+		mBoundary.clear();
+		std::string line;
+		while (std::getline(file, line)) {
+			std::istringstream istr(line);
+			std::string first;
+			double x, y;
+			if ((! (istr >> first)) || (first.compare(0, 2, "//") == 0)) {
+				continue;
+			}
+			std::istringstream ifirst(first);
+			if ((ifirst >> x) && (istr >> y)) {
+				AddBoundaryPoint(x, y);
+			}
+		}
+		return true;
+	}
+	//! Reads obstacles from an obstacle file, and enlarges them by margin on each side. Returns false if the file could not be read.
+	bool ReadObstacleFile(const std::string &filename, double margin = 0) {
+		std::ifstream file(filename.c_str());
+		int count = 0;
+		if (! (file >> count)) {
+			return false;
+		}
+		for (int i = 0; i < count; i++) {
+			double xmin, ymin, xmax, ymax;
+			if (! (file >> xmin >> ymin >> xmax >> ymax)) {
+				return false;
+			}
+			AddObstacle(xmin - margin, ymin - margin, xmax + margin, ymax + margin);
+		}
+		return true;
+	}
+
+	//! Builds the lookup structures. If cellsize is 0, the cells are chosen such that the longer side of the boundary spans about 256 cells.
+	void Build(double cellsize = 0) {
+		mObstacleBVH.Build();
+		mCellsX = 0;
+		mCellsY = 0;
+		mCells.clear();
+		mRowEdgeStart.clear();
+		mRowEdges.clear();
+		int n = mBoundary.size();
+		if (n < 3) {
+			return;
+		}
+
+		// Grid covering the bounding box of the boundary
+		tPoint a = mBoundary[0];
+		tPoint b = mBoundary[0];
+		for (int i = 1; i < n; i++) {
+			a.x = std::min(a.x, mBoundary[i].x);
+			a.y = std::min(a.y, mBoundary[i].y);
+			b.x = std::max(b.x, mBoundary[i].x);
+			b.y = std::max(b.y, mBoundary[i].y);
+		}
+		mCellSize = (cellsize > 0 ? cellsize : std::max(b.x - a.x, b.y - a.y) / 256);
+		if (mCellSize <= 0) {
+			return;
+		}
+		mCellSizeInv = 1 / mCellSize;
+		mOrigin = a;
+		mCellsX = (int)floor((b.x - a.x) * mCellSizeInv) + 1;
+		mCellsY = (int)floor((b.y - a.y) * mCellSizeInv) + 1;
+		mCells.assign(mCellsX * mCellsY, sCellOutside);
+
+		// Edges spanning each row (two passes: count, then fill)
+		mRowEdgeStart.assign(mCellsY + 1, 0);
+		for (int pass = 0; pass < 2; pass++) {
+			for (int i = 0; i < n; i++) {
+				tPoint p, q;
+				GetEdge(i, p, q);
+				int first, last;
+				RowRange(std::min(p.y, q.y), std::max(p.y, q.y), first, last);
+				for (int row = first; row <= last; row++) {
+					if (pass == 0) {
+						mRowEdgeStart[row + 1]++;
+					} else {
+						mRowEdges[mRowEdgeStart[row]++] = i;
+					}
+				}
+			}
+			if (pass == 0) {
+				for (int row = 0; row < mCellsY; row++) {
+					mRowEdgeStart[row + 1] += mRowEdgeStart[row];
+				}
+				mRowEdges.resize(mRowEdgeStart[mCellsY]);
+			} else {
+				// Filling advanced each start to the start of the next row
+				for (int row = mCellsY; row > 0; row--) {
+					mRowEdgeStart[row] = mRowEdgeStart[row - 1];
+				}
+				mRowEdgeStart[0] = 0;
+			}
+		}
+
+		// Scanline through the cell centres of each row: cells between an odd number of crossings are inside
+		std::vector<double> crossings;
+		for (int row = 0; row < mCellsY; row++) {
+			double y = mOrigin.y + (row + 0.5) * mCellSize;
+			crossings.clear();
+			for (int e = mRowEdgeStart[row]; e < mRowEdgeStart[row + 1]; e++) {
+				tPoint p, q;
+				GetEdge(mRowEdges[e], p, q);
+				if ((p.y > y) != (q.y > y)) {
+					crossings.push_back(p.x + (q.x - p.x) * (y - p.y) / (q.y - p.y));
+				}
+			}
+			std::sort(crossings.begin(), crossings.end());
+			unsigned int k = 0;
+			for (int col = 0; col < mCellsX; col++) {
+				double x = mOrigin.x + (col + 0.5) * mCellSize;
+				while ((k < crossings.size()) && (crossings[k] <= x)) {
+					k++;
+				}
+				mCells[col + mCellsX * row] = (((crossings.size() - k) & 1) ? sCellInside : sCellOutside);
+			}
+		}
+
+		// Cells touched by an edge (slightly enlarged to be safe against rounding) need the exact test
+		double eps = 1e-9 * mCellSize;
+		for (int i = 0; i < n; i++) {
+			tPoint p, q;
+			GetEdge(i, p, q);
+			int x0 = (int)floor((std::min(p.x, q.x) - mOrigin.x) * mCellSizeInv) - 1;
+			int x1 = (int)floor((std::max(p.x, q.x) - mOrigin.x) * mCellSizeInv) + 1;
+			int y0, y1;
+			RowRange(std::min(p.y, q.y) - mCellSize, std::max(p.y, q.y) + mCellSize, y0, y1);
+			x0 = (x0 < 0 ? 0 : x0);
+			x1 = (x1 >= mCellsX ? mCellsX - 1 : x1);
+			for (int row = y0; row <= y1; row++) {
+				double cy0 = mOrigin.y + row * mCellSize - eps;
+				double cy1 = mOrigin.y + (row + 1) * mCellSize + eps;
+				for (int col = x0; col <= x1; col++) {
+					double cx0 = mOrigin.x + col * mCellSize - eps;
+					double cx1 = mOrigin.x + (col + 1) * mCellSize + eps;
+					if (EdgeTouchesRectangle(p, q, cx0, cy0, cx1, cy1)) {
+						mCells[col + mCellsX * row] = sCellEdge;
+					}
+				}
+			}
+		}
+	}
+
+	//! Returns the number of boundary points.
+	int GetBoundaryCount() const {
+		return mBoundary.size();
+	}
+	//! Returns a boundary point.
+	const tPoint &GetBoundaryPoint(int i) const {
+		return mBoundary[i];
+	}
+	//! Returns the number of obstacles.
+	int GetObstacleCount() const {
+		return mObstacles.size();
+	}
+	//! Returns an obstacle.
+	const tObstacle &GetObstacle(int i) const {
+		return mObstacles[i];
+	}
+	//! Returns the number of grid cells on each axis.
+	void GetGridSize(int &x, int &y) const {
+		x = mCellsX;
+		y = mCellsY;
+	}
+
+	//! Returns true if the point is inside the boundary (or if there is no boundary).
+	bool InsideArena(double x, double y) const {
+		if (mCells.empty()) {
+			return mBoundary.size() < 3;
+		}
+		double fx = (x - mOrigin.x) * mCellSizeInv;
+		double fy = (y - mOrigin.y) * mCellSizeInv;
+		if (! ((fx >= 0) && (fy >= 0) && (fx < mCellsX) && (fy < mCellsY))) {
+			return false;
+		}
+		int row = (int)fy;
+		unsigned char cell = mCells[(int)fx + mCellsX * row];
+		if (cell != sCellEdge) {
+			return (cell == sCellInside);
+		}
+
+		// Crossing number over the edges of this row
+		bool inside = false;
+		for (int e = mRowEdgeStart[row]; e < mRowEdgeStart[row + 1]; e++) {
+			tPoint p, q;
+			GetEdge(mRowEdges[e], p, q);
+			if (Crosses(p, q, x, y)) {
+				inside = ! inside;
+			}
+		}
+		return inside;
+	}
+	//! Returns the index of an obstacle containing the point, or -1 if there is none. Closed and open borders are tested against each obstacle in turn (returning the first one), and are therefore only meant for short obstacle lists.
+	int InsideObstacle(double x, double y, eBorders borders = sBordersHalfOpen) {
+		if (borders == sBordersHalfOpen) {
+			return mObstacleBVH.Inside(x, y, 0);
+		}
+		for (unsigned int i = 0; i < mObstacles.size(); i++) {
+			const tObstacle &o = mObstacles[i];
+			bool inside = (borders == sBordersClosed ? (x >= o.xmin) && (x <= o.xmax) && (y >= o.ymin) && (y <= o.ymax) : (x > o.xmin) && (x < o.xmax) && (y > o.ymin) && (y < o.ymax));
+			if (inside) {
+				return i;
+			}
+		}
+		return -1;
+	}
+	//! Returns true if the point is inside the arena, and not in an obstacle.
+	bool IsFree(double x, double y) {
+		return InsideArena(x, y) && (InsideObstacle(x, y) < 0);
+	}
+};
+
+#endif
@@ -46,6 +46,18 @@ public:
 		return mFile.gcount();
 	}
 
+	//! Returns the number of bytes left between the current position and the end of the file (0 after a failed read).
+	off_t Remaining() {
+		if (! mFile.good()) {
+			return 0;
+		}
+		std::streampos pos = mFile.tellg();
+		mFile.seekg(0, std::ios::end);
+		std::streampos end = mFile.tellg();
+		mFile.seekg(pos);
+		return end - pos;
+	}
+
 	bool Bool() {
 		bool i = 0;
 		mFile.read((char*)&i, sizeof(bool));
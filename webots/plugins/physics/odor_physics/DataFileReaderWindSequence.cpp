@@ -0,0 +1,97 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#include "DataFileReaderWindSequence.h"
+#include "DataFileWriterWindSequence.h"
+#define THISCLASS DataFileReaderWindSequence
+
+THISCLASS::DataFileReaderWindSequence(const std::string &filename):
+		DataFileReader(filename), mCellCount(0), mStep(1), mKeyframeInterval(1), mPrevious(), mPayload() {
+
+	if (mError) {
+		return;
+	}
+	int format = Int();
+	int version = Int();
+	if ((format != DataFileWriterWindSequence::FILEFORMAT) || (version != DataFileWriterWindSequence::VERSION)) {
+		mError = ERROR_FORMAT;
+		return;
+	}
+	mCellCount = Int();
+	mStep = Double();
+	mKeyframeInterval = Int();
+	if ((! mFile) || (mCellCount < 0)) {
+		mError = ERROR_FORMAT;
+		return;
+	}
+	mPrevious.assign(3 * mCellCount, 0);
+}
+
+// Decodes a zigzag-encoded variable-length integer. Returns false if the payload ends prematurely.
+static inline bool GetVarint(const unsigned char *&p, const unsigned char *end, int &value) {
+	unsigned int u = 0;
+	for (int shift = 0; shift < 35; shift += 7) {
+		if (p == end) {
+			return false;
+		}
+		unsigned char b = *p++;
+		u |= (unsigned int)(b & 0x7f) << shift;
+		if (b < 0x80) {
+			value = (int)(u >> 1) ^ -(int)(u & 1);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool THISCLASS::ReadFrame(double &time, Point3 *wind) {
+	if (mError) {
+		return false;
+	}
+
+	// Frame header
+	time = Double();
+	bool keyframe = (Char() != 0);
+	int len = Int();
+	if ((! mFile) || (len < 0)) {
+		return false;
+	}
+
+	// Payload
+	mPayload.resize(len);
+	if (len > 0) {
+		mFile.read((char*)&mPayload[0], len);
+		if (mFile.gcount() != len) {
+			return false;
+		}
+	}
+
+	// Decode
+	const unsigned char *p = len > 0 ? &mPayload[0] : NULL;
+	const unsigned char *end = p + len;
+	for (int i = 0; i < mCellCount; i++) {
+		int *q = &mPrevious[3 * i];
+		for (int c = 0; c < 3; c++) {
+			int value;
+			if (! GetVarint(p, end, value)) {
+				mError = ERROR_FORMAT;
+				return false;
+			}
+			q[c] = keyframe ? value : q[c] + value;
+		}
+		wind[i] = Point3(q[0] * mStep, q[1] * mStep, q[2] * mStep);
+	}
+	return true;
+}
+
+bool THISCLASS::ReadFrame(WindFieldSnapshot *wfs) {
+	if ((! wfs->mWind) || (wfs->GetCellCount() != mCellCount)) {
+		return false;
+	}
+	double time;
+	if (! ReadFrame(time, wfs->mWind)) {
+		return false;
+	}
+	wfs->mTime = time;
+	return true;
+}
@@ -0,0 +1,52 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classDataFileReaderWindSequence
+#define classDataFileReaderWindSequence
+
+class DataFileReaderWindSequence;
+
+#include <string>
+#include <vector>
+#include "DataFileReader.h"
+#include "WindFieldSnapshot.h"
+
+//!	Reads a compressed sequence of wind snapshots written by DataFileWriterWindSequence, one frame at a time.
+class DataFileReaderWindSequence: public DataFileReader {
+
+protected:
+	//! Number of cells per frame.
+	int mCellCount;
+	//! Quantization step.
+	double mStep;
+	//! Keyframe interval.
+	int mKeyframeInterval;
+	//! Quantized values of the previous frame.
+	std::vector<int> mPrevious;
+	//! Payload of the current frame.
+	std::vector<unsigned char> mPayload;
+
+public:
+	//! Constructor. Opens the file and reads the sequence header (Error() returns ERROR_FORMAT if this is not a wind sequence).
+	DataFileReaderWindSequence(const std::string &filename);
+
+	//! Reads the next frame into the cell wind speeds of a snapshot (which must have GetCellCount() cells) and sets its time. Call ResampleGrid afterwards. Returns false at the end of the file.
+	bool ReadFrame(WindFieldSnapshot *wfs);
+	//! Reads the next frame into wind (GetCellCount() elements). Returns false at the end of the file.
+	bool ReadFrame(double &time, Point3 *wind);
+
+	//! Returns the number of cells per frame.
+	int GetCellCount() const {
+		return mCellCount;
+	}
+	//! Returns the quantization step.
+	double GetQuantizationStep() const {
+		return mStep;
+	}
+	//! Returns the keyframe interval.
+	int GetKeyframeInterval() const {
+		return mKeyframeInterval;
+	}
+};
+
+#endif
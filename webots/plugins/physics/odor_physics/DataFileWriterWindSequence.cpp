@@ -0,0 +1,54 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#include "DataFileWriterWindSequence.h"
+#define THISCLASS DataFileWriterWindSequence
+
+#include <math.h>
+
+THISCLASS::DataFileWriterWindSequence(const std::string &filename, int cellcount, double step, int keyframeinterval):
+		DataFileWriter(filename), mCellCount(cellcount), mStep(step), mKeyframeInterval(keyframeinterval), mFrameCount(0), mPrevious(3 * cellcount, 0), mPayload(), mPayloadBytes(0) {
+
+	if (mKeyframeInterval < 1) {
+		mKeyframeInterval = 1;
+	}
+	Int(FILEFORMAT);
+	Int(VERSION);
+	Int(mCellCount);
+	Double(mStep);
+	Int(mKeyframeInterval);
+}
+
+// Appends a zigzag-encoded variable-length integer.
+static inline void PutVarint(std::vector<unsigned char> &buffer, int value) {
+	unsigned int u = ((unsigned int)value << 1) ^ (unsigned int)(value >> 31);
+	while (u >= 0x80) {
+		buffer.push_back((unsigned char)(u | 0x80));
+		u >>= 7;
+	}
+	buffer.push_back((unsigned char)u);
+}
+
+void THISCLASS::WriteFrame(double time, const Point3 *wind) {
+	bool keyframe = (mFrameCount % mKeyframeInterval == 0);
+	double inv = 1 / mStep;
+
+	mPayload.clear();
+	for (int i = 0; i < mCellCount; i++) {
+		int q[3] = {(int)lrint(wind[i].x * inv), (int)lrint(wind[i].y * inv), (int)lrint(wind[i].z * inv)};
+		int *previous = &mPrevious[3 * i];
+		for (int c = 0; c < 3; c++) {
+			PutVarint(mPayload, keyframe ? q[c] : q[c] - previous[c]);
+			previous[c] = q[c];
+		}
+	}
+
+	Double(time);
+	Char(keyframe ? 1 : 0);
+	Int((int)mPayload.size());
+	if (! mPayload.empty()) {
+		Write((char*)&mPayload[0], mPayload.size());
+	}
+	mPayloadBytes += mPayload.size();
+	mFrameCount++;
+}
@@ -0,0 +1,74 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classDataFileWriterWindSequence
+#define classDataFileWriterWindSequence
+
+class DataFileWriterWindSequence;
+
+#include <string>
+#include <vector>
+#include "DataFileWriter.h"
+#include "Point3.h"
+
+//!	Writes a sequence of wind snapshots (cell wind speeds) into a compressed binary file.
+/*!
+	The wind speeds are quantized with a fixed step (q = round(v / step)). Every K-th frame is a keyframe storing q itself; all other frames store the difference to the previous frame.
+	The values are written as zigzag-encoded variable-length integers, so that the small differences between consecutive snapshots take one or two bytes.
+	Since the differences are taken between quantized values, the error does not accumulate: each decoded wind speed is within step / 2 of the original value.
+
+	File layout (after the SIM2 header):
+	\code
+	int    FILEFORMAT
+	int    version
+	int    number of cells
+	double quantization step
+	int    keyframe interval
+	for each frame:
+	  double time
+	  char   1 for keyframes, 0 for delta frames
+	  int    number of payload bytes
+	  char[] payload (3 varints per cell)
+	\endcode
+*/
+class DataFileWriterWindSequence: public DataFileWriter {
+
+protected:
+	//! Number of cells per frame.
+	int mCellCount;
+	//! Quantization step.
+	double mStep;
+	//! Keyframe interval.
+	int mKeyframeInterval;
+	//! Number of frames written so far.
+	int mFrameCount;
+	//! Quantized values of the previous frame.
+	std::vector<int> mPrevious;
+	//! Payload of the current frame.
+	std::vector<unsigned char> mPayload;
+	//! Total number of payload bytes written so far.
+	long long mPayloadBytes;
+
+public:
+	//! File format identifier.
+	static const int FILEFORMAT = 0x51455357; // WSEQ
+	//! File format version.
+	static const int VERSION = 1;
+
+	//! Constructor. Creates the file and writes the sequence header.
+	DataFileWriterWindSequence(const std::string &filename, int cellcount, double step, int keyframeinterval);
+
+	//! Appends a frame (cellcount wind speeds).
+	void WriteFrame(double time, const Point3 *wind);
+
+	//! Returns the number of frames written.
+	int GetFrameCount() const {
+		return mFrameCount;
+	}
+	//! Returns the total number of payload bytes written.
+	long long GetPayloadBytes() const {
+		return mPayloadBytes;
+	}
+};
+
+#endif
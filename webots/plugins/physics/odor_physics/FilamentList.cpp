@@ -4,7 +4,6 @@
 #include <stdlib.h>
 #include <fstream>
 #include <iostream>
-#include <plugins/physics.h>
 #include "FilamentList.h"
 #include "Constants.h"
 #define	THISCLASS FilamentList
@@ -76,7 +75,9 @@ Filament *THISCLASS::AddFilament() {
 	}
 
 	// Make sure we remove a potentially existing filament
-	RemoveFilament(mLastAddedFilamentID);
+	if (RemoveFilament(mLastAddedFilamentID)) {
+		mSimulation->mCounters.Increment(SimulationCounters::sCounterFilamentsOverwritten);
+	}
 
 	// Return the new filament
 	mFilament[mLastAddedFilamentID].mExists = true;
@@ -152,12 +153,55 @@ void THISCLASS::OnWebotsPhysicsDraw() {
 	}
 	//Stream buffer data. A receiver in the supervisor will read this.
 	//Using channel 8000 for this communication
-	dWebotsSend(8000,buffer,4*mCountAllocated*sizeof(double));
+	mSimulation->mHost->Send(8000,buffer,4*mCountAllocated*sizeof(double));
 
 	//glLineWidth(1.0);
 	//glEnable(GL_LIGHTING);
 }
 
+void THISCLASS::Read(DataFileReader &f) {
+	// The filaments keep their slots, so that AddFilament continues to overwrite them in the same order
+	// The number of filaments cannot change, since the payload sent to the controllers has a fixed size
+	int count = f.Int();
+	if (count != mCountAllocated) {
+		f.mError = DataFileReader::ERROR_FORMAT;
+		return;
+	}
+	InitializeFilaments();
+	mLastAddedFilamentID = f.Int();
+	for (int i = 0; i < mCountAllocated; i++) {
+		Filament &fi = mFilament[i];
+		fi.mExists = f.Bool();
+		if (! fi.mExists) {
+			continue;
+		}
+		fi.mPosition.Read(f);
+		fi.mPrevPosition.Read(f);
+		fi.mAmount = f.Double();
+		fi.mWidth = f.Double();
+		fi.mCreationTime = f.Double();
+		fi.mOdorType = f.Int();
+	}
+}
+
+void THISCLASS::Write(DataFileWriter &f) {
+	f.Int(mCountAllocated);
+	f.Int(mLastAddedFilamentID);
+	for (int i = 0; i < mCountAllocated; i++) {
+		Filament &fi = mFilament[i];
+		f.Bool(fi.mExists);
+		if (! fi.mExists) {
+			continue;
+		}
+		fi.mPosition.Write(f);
+		fi.mPrevPosition.Write(f);
+		f.Double(fi.mAmount);
+		f.Double(fi.mWidth);
+		f.Double(fi.mCreationTime);
+		f.Int(fi.mOdorType);
+	}
+}
+
 void THISCLASS::WriteConfiguration(std::ostream &out) {
 	out << "<FilamentList>" << std::endl;
 	out << "\t<Size>" << mCountAllocated << "</Size>" << std::endl;
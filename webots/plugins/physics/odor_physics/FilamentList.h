@@ -56,9 +56,9 @@ public:
 	}
 
 	// Read/Write
-	//! Reads the object from a file.
+	//! Reads the filaments from a file (e.g. a checkpoint). The file must contain the same number of filaments as this list, otherwise the error of the reader is set and the filaments are not modified.
 	void Read(DataFileReader &f);
-	//! Writes the object to a file.
+	//! Writes the filaments to a file.
 	void Write(DataFileWriter &f);
 
 	//! Returns the concentration at p.
@@ -2,10 +2,14 @@
 // Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
 
 #include <stdlib.h>
+#include <cmath>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include "FilamentPropagation.h"
 #include "Random.h"
+#include "WindFieldConstant.h"
+#include "ObstacleList.h"
 #define	THISCLASS FilamentPropagation
 
 using namespace std;
@@ -16,6 +20,11 @@ THISCLASS::FilamentPropagation(Simulation *sim):
 	mSimulation->mFilamentPropagation = this;
 	mConfiguration.mStdDev = 0;
 	mConfiguration.mFilamentGrowthGamma = 0;
+	mConfiguration.mIntegrator = sIntegratorEuler;
+	mConfiguration.mCourantNumber = 0;
+	mConfiguration.mMaxSubsteps = 16;
+	mConfiguration.mCheckSegments = false;
+	mConfiguration.mRetireOutsideArena = false;
 }
 
 THISCLASS::~FilamentPropagation() {
@@ -30,74 +39,208 @@ void THISCLASS::OnSimulationStart() {
 void THISCLASS::OnSimulationEnd() {
 }
 
+template <class TWindField> int THISCLASS::Advect(TWindField *wf, int existing, double simstep) {
+	if (existing < 1) {
+		return 0;
+	}
+	wf->GetWindSpeeds(&mPositions[0], &mWindSpeeds[0], existing);
+
+	// Remove the filaments outside of the wind field, and compact the remaining ones
+	FilamentList *fl = mSimulation->mFilamentList;
+	int remaining = 0;
+	for (int j = 0; j < existing; j++) {
+		if (mWindSpeeds[j] == Point3(-100, -100, -100)) {
+			Filament *f = fl->Get(mIndices[j]);
+			f->mPrevPosition = f->mPosition;
+			fl->RemoveFilament(f->mID);
+			continue;
+		}
+		mIndices[remaining] = mIndices[j];
+		mPositions[remaining] = mPositions[j];
+		mWindSpeeds[remaining] = mWindSpeeds[j];
+		remaining++;
+	}
+	mSimulation->mCounters.Increment(SimulationCounters::sCounterOutOfDomain, existing - remaining);
+
+	// Advect the filaments block by block, with as many substeps as the fastest filament of the block needs
+	double resolution = (mConfiguration.mCourantNumber > 0 ? wf->GetResolution() : 0);
+	double maxstep = mConfiguration.mCourantNumber * resolution;
+	for (int first = 0; first < remaining; first += mBlockSize) {
+		int n = remaining - first;
+		if (n > mBlockSize) {
+			n = mBlockSize;
+		}
+		int substeps = 1;
+		if (maxstep > 0) {
+			double speed2 = 0;
+			for (int j = first; j < first + n; j++) {
+				double s2 = mWindSpeeds[j] * mWindSpeeds[j];
+				speed2 = (s2 > speed2 ? s2 : speed2);
+			}
+			substeps = (int)ceil(sqrt(speed2) * simstep / maxstep);
+			substeps = (substeps < 1 ? 1 : (substeps > mConfiguration.mMaxSubsteps ? mConfiguration.mMaxSubsteps : substeps));
+		}
+		AdvectBlock(wf, first, n, substeps, simstep / substeps);
+	}
+	return remaining;
+}
+
+// A constant wind field moves all filaments by the same displacement (which is exact for any integrator), and never returns the "outside" marker.
+template <> int THISCLASS::Advect(WindFieldConstant *wf, int existing, double simstep) {
+	Point3 d = wf->GetWindSpeed() * simstep;
+	Point3 *p = (existing > 0 ? &mPositions[0] : NULL);
+	for (int j = 0; j < existing; j++) {
+		p[j].x += d.x;
+		p[j].y += d.y;
+		p[j].z += d.z;
+	}
+	return existing;
+}
+
+void THISCLASS::AdvectBlock(WindField *wf, int first, int n, int substeps, double dt) {
+	Point3 *p = &mPositions[first];
+	Point3 *w = &mWindSpeeds[first];
+	Point3 *pm = &mMidPositions[first];
+	Point3 *wm = &mMidWindSpeeds[first];
+	int misses = 0;
+	for (int s = 0; s < substeps; s++) {
+		// Wind speeds at the start of the substep (a filament that left the wind field stops, and is removed in the next step)
+		if (s > 0) {
+			wf->GetWindSpeeds(p, w, n);
+			for (int j = 0; j < n; j++) {
+				if (w[j] == Point3(-100, -100, -100)) {
+					w[j] = Point3(0, 0, 0);
+					misses++;
+				}
+			}
+		}
+
+		if (mConfiguration.mIntegrator == sIntegratorEuler) {
+			for (int j = 0; j < n; j++) {
+				p[j] += w[j] * dt;
+			}
+			continue;
+		}
+
+		// Midpoint rule (falls back to Euler where the midpoint is outside of the wind field)
+		for (int j = 0; j < n; j++) {
+			pm[j] = p[j] + w[j] * (0.5 * dt);
+		}
+		wf->GetWindSpeeds(pm, wm, n);
+		for (int j = 0; j < n; j++) {
+			if (wm[j] == Point3(-100, -100, -100)) {
+				wm[j] = w[j];
+				misses++;
+			}
+			p[j] += wm[j] * dt;
+		}
+	}
+	mSimulation->mCounters.Increment(SimulationCounters::sCounterWindMisses, misses);
+}
+
 void THISCLASS::OnSimulationStep() {
 	WindField *wf = mSimulation->mWindField;
 	FilamentList *fl = mSimulation->mFilamentList;
 	ObstacleList *of = mSimulation->mObstacleList;
+	ObstacleDistanceField *df = of->GetDistanceField();
+	const ArenaGeometry *arena = (mConfiguration.mRetireOutsideArena ? of->GetArena() : 0);
 	double simstep = mSimulation->mSimulationTimeStep;
-	double stddev = mConfiguration.mStdDev * simstep;
+	double physicsstep = ((mSimulation->mPhysicsTimeStep > 0) ? mSimulation->mPhysicsTimeStep : simstep);
+
+	// The random walk and the growth are defined per physics step: an odor update spanning n physics steps (see Simulation::mOdorUpdatePeriod) adds the sum of n independent displacements, and applies the growth n times
+	double n = ((physicsstep > 0) ? simstep / physicsstep : 1);
+	double stddev = mConfiguration.mStdDev * physicsstep * sqrt(n);
+	int growthsteps = std::max(1, (int)floor(n + 0.5));
 	int count = fl->GetCount();
-	Point3 currentWind;
-	
-	//Fa open a file to write informations abour filaments to be checked
-	//ofstream myfile;
-	//myfile.open("/home/rahbar/Desktop/FaezehRahbar/Program/filament_Thomas/Webots/plugins/physics/odor_physics/results/filaments.txt", ios::app);
 
-	Random r;
+	// Gather the positions of all existing filaments
+	mIndices.resize(count);
+	mPositions.resize(count);
+	mWindSpeeds.resize(count);
+	mMidPositions.resize(count);
+	mMidWindSpeeds.resize(count);
+	int existing = 0;
 	for (int i = 0; i < count; i++) {
 		Filament *f = fl->Get(i);
 		if (f->mExists) {
-			f->mPrevPosition = f->mPosition;
-			
-			//check for error of wind
-			currentWind = wf->GetWindSpeed(f->mPosition);
-			if (currentWind == Point3(-100,-100,-100)){
-				/*std::cout << "filament " << f->mID << " got removed (position: " 
-							<< f->mPosition << ")" << std::endl;*/
-				fl->RemoveFilament(f->mID);
-				continue;
+			mIndices[existing] = i;
+			mPositions[existing] = f->mPosition;
+			existing++;
+		}
+	}
+
+	// Advection, with a specialized kernel for the wind field type (determined once per step)
+	WindFieldConstant *wfc = dynamic_cast<WindFieldConstant*>(wf);
+	if (wfc) {
+		existing = Advect(wfc, existing, simstep);
+	} else {
+		existing = Advect(wf, existing, simstep);
+	}
+
+	Random &r = mSimulation->mRandom;
+	int hits = 0;
+	int reflections = 0;
+	int outside = 0;
+	for (int j = 0; j < existing; j++) {
+		Filament *f = fl->Get(mIndices[j]);
+		f->mPrevPosition = f->mPosition;
+		Point3 newpos = mPositions[j];
+
+		// Stochastic process (vmi)
+		newpos.x += r.Normal(0, stddev);
+		newpos.y += r.Normal(0, stddev);
+		newpos.z += r.Normal(0, stddev);
+
+		// Reflect filaments that entered an obstacle or left the arena off the surface (mirroring the position at the surface along the distance gradient)
+		bool blocked = false;
+		if (df) {
+			Point3 gradient;
+			double d = df->GetDistance(newpos, gradient);
+			if (d < 0) {
+				double g2 = gradient.Length2();
+				if (g2 > 0) {
+					newpos = newpos - gradient * (2 * d / g2);
+				}
+				blocked = (g2 <= 0) || (df->GetDistance(newpos, gradient) < 0);
+				reflections += (blocked ? 0 : 1);
 			}
-			
-			// Advection
-			Point3 newpos = f->mPosition + currentWind * simstep;
-
-            //if(i==0) printf("old:(%f %f %f) new:(%f %f %f) ws:(%f %f %f)\n",f->mPosition.x,f->mPosition.y,f->mPosition.z,newpos.x, newpos.y, newpos.z, wf->GetWindSpeed(f->mPosition).x, wf->GetWindSpeed(f->mPosition).y, wf->GetWindSpeed(f->mPosition).z);
-            /*if(i==1){ //Fa
-            std::cout << "old:("<< f->mPosition.x << f->mPosition.y << f->mPosition.z << ") new:(" << newpos.x << newpos.y << newpos.z << ") ws:(" << wf->GetWindSpeed(f->mPosition).x << wf->GetWindSpeed(f->mPosition).y << wf->GetWindSpeed(f->mPosition).z << std::endl;
-              }*/
-
-			// Stochastic process (vmi)
-			newpos.x += r.Normal(0, stddev);
-			newpos.y += r.Normal(0, stddev);
-			newpos.z += r.Normal(0, stddev);
-
-			// write the position and wind speed of all the filaments in a file (Fa)
-			/*if (myfile.is_open()){} 
-			else{std::cout << "error while opening the file"<< std::endl;}
-			myfile << "filament " << i << "\n";
-			myfile << "old:("<< f->mPosition.x << " "<< f->mPosition.y << " "<< f->mPosition.z 
-					<< ") new:(" << newpos.x << " "<< newpos.y << " "<< newpos.z << ") ws:(" 
-					<< wf->GetWindSpeed(f->mPosition).x << " "<< wf->GetWindSpeed(f->mPosition).y
-					<< " "<< wf->GetWindSpeed(f->mPosition).z << ")\n";*/
-
-			// Simple way of dealing with obstacles: 
-			// if the new filament position is inside an obstacle, simply don't move
-			if (of->GetObstacle(newpos) == 0) {
-				f->mPosition = newpos;
-			}else
-				std::cout << "filament " << f->mID << " in an obstacle (position: " 
-						  << f->mPosition << ")" << std::endl;
-			// Filament growth
+		}
+
+		// Simple way of dealing with obstacles: 
+		// if the new filament position is inside an obstacle (or the path to it crosses one), simply don't move
+		double t;
+		if ((! blocked) && ((mConfiguration.mCheckSegments ? of->GetObstacle(f->mPosition, newpos, t) : of->GetObstacle(newpos)) == 0)) {
+			f->mPosition = newpos;
+		} else {
+			hits++;
+		}
+
+		// Retire filaments that left the arena
+		if (arena && (! arena->InsideArena(f->mPosition.x, f->mPosition.y))) {
+			fl->RemoveFilament(f->mID);
+			outside++;
+			continue;
+		}
+
+		// Filament growth
+		for (int k = 0; k < growthsteps; k++) {
 			f->mWidth += 0.5 * mConfiguration.mFilamentGrowthGamma / f->mWidth;
-			
 		}
 	}
-	//myfile.close();
+
+	mSimulation->mCounters.Increment(SimulationCounters::sCounterObstacleHits, hits);
+	mSimulation->mCounters.Increment(SimulationCounters::sCounterObstacleReflections, reflections);
+	mSimulation->mCounters.Increment(SimulationCounters::sCounterOutsideArena, outside);
 }
 
 void THISCLASS::WriteConfiguration(std::ostream &out) {
 	out << "<FilamentPropagation>" << std::endl;
 	out << "\t<StdDev>" << mConfiguration.mStdDev << "</StdDev>" << std::endl;
 	out << "\t<FilamentGrowthGamma>" << mConfiguration.mFilamentGrowthGamma << "</FilamentGrowthGamma>" << std::endl;
+	out << "\t<Integrator>" << (mConfiguration.mIntegrator == sIntegratorMidpoint ? "midpoint" : "euler") << "</Integrator>" << std::endl;
+	out << "\t<CourantNumber>" << mConfiguration.mCourantNumber << "</CourantNumber>" << std::endl;
+	out << "\t<MaxSubsteps>" << mConfiguration.mMaxSubsteps << "</MaxSubsteps>" << std::endl;
+	out << "\t<CheckSegments>" << (mConfiguration.mCheckSegments ? 1 : 0) << "</CheckSegments>" << std::endl;
+	out << "\t<RetireOutsideArena>" << (mConfiguration.mRetireOutsideArena ? 1 : 0) << "</RetireOutsideArena>" << std::endl;
 	out << "</FilamentPropagation>" << std::endl;
 }
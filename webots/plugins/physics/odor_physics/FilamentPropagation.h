@@ -7,18 +7,51 @@
 class FilamentPropagation;
 
 #include <string>
+#include <vector>
 #include "Filament.h"
 #include "Simulation.h"
 #include "SimulationInterface.h"
+#include "WindField.h"
 
 //! FilamentPropagation
 //! \brief This class implements more or less the model presented in "Filament-based atmospheric dispersion model to achieve short time-scale structure of odor plumes" of Jay A. Farrell. However, instead of implementing our own advection model, we use a WindField class.
 class FilamentPropagation: public SimulationInterface {
 
+public:
+	//! Integration schemes for the advection.
+	enum eIntegrator {
+		sIntegratorEuler = 0,			//!< Explicit Euler: the wind speed at the start of the (sub)step.
+		sIntegratorMidpoint,			//!< Midpoint (second-order Runge-Kutta): the wind speed half a (sub)step ahead.
+	};
+
+protected:
+	//! Number of filaments that are advected with a common number of substeps.
+	static const int mBlockSize = 256;
+
+	//! Indices of the existing filaments (gathered at each step).
+	std::vector<int> mIndices;
+	//! Positions of the existing filaments (gathered at each step).
+	std::vector<Point3> mPositions;
+	//! Wind speeds at the positions of the existing filaments.
+	std::vector<Point3> mWindSpeeds;
+	//! Intermediate positions and their wind speeds (midpoint integrator).
+	std::vector<Point3> mMidPositions;
+	std::vector<Point3> mMidWindSpeeds;
+
+	//! Advects the gathered positions (mPositions) with the wind field, and removes the filaments that left the wind field. Returns the number of remaining filaments. This is specialized for wind fields that allow a faster update.
+	template <class TWindField> int Advect(TWindField *wf, int existing, double simstep);
+	//! Advects n gathered filaments (starting at first) in substeps of dt. The wind speeds at the initial positions must be in mWindSpeeds.
+	void AdvectBlock(WindField *wf, int first, int n, int substeps, double dt);
+
 public:
 	struct {
 		double mStdDev;					//!< The standard deviation of the superposed stochastic process.
 		double mFilamentGrowthGamma;	//!< The gamma parameter of the filament growth [m^2/s].
+		eIntegrator mIntegrator;		//!< The integration scheme for the advection.
+		double mCourantNumber;			//!< The maximum distance a filament may move per substep, as a fraction of the wind field resolution (0 to advect in a single step).
+		int mMaxSubsteps;				//!< The maximum number of substeps per simulation step.
+		bool mCheckSegments;			//!< Whether to test the whole path of a filament (rather than its new position only) against the obstacles, such that filaments cannot tunnel through thin walls.
+		bool mRetireOutsideArena;		//!< Whether to remove filaments that left the arena (see ObstacleList::GetArena).
 	} mConfiguration;
 
 	//! Constructor.
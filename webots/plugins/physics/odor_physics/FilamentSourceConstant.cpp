@@ -6,7 +6,6 @@
 #include "Random.h"
 #include "Constants.h"
 #include <cassert>
-#include <plugins/physics.h>
 #define	THISCLASS FilamentSourceConstant
 
 THISCLASS::FilamentSourceConstant(Simulation *sim):
@@ -27,8 +26,7 @@ void THISCLASS::OnSimulationEnd() {}
 
 void THISCLASS::OnSimulationStep() {
 	// Get the position of the source
-	const dReal *p = dGeomGetPosition(mWebotsInterface.mGeometryID);
-	const Point3 position(p[0], p[1], p[2]);
+	const Point3 position = mSimulation->mHost->GetPosition(mWebotsInterface.mGeometryID);
 
 	// Accumulate fractional filaments
 	mState.mReleaseAmountAccumulator += mConfiguration.mReleaseAmount * mSimulation->mSimulationTimeStep;
@@ -37,7 +35,7 @@ void THISCLASS::OnSimulationStep() {
 	}
 
 	// Create filaments
-	Random r;
+	Random &r = mSimulation->mRandom;
 	double radius2 = mConfiguration.mRadius * mConfiguration.mRadius;
 	FilamentList *fl = mSimulation->mFilamentList;
 	while (mState.mReleaseAmountAccumulator >= 1) {
@@ -57,6 +55,7 @@ void THISCLASS::OnSimulationStep() {
 		f->mPosition += position;
 
 		mState.mReleaseAmountAccumulator--;
+		mSimulation->mCounters.Increment(SimulationCounters::sCounterFilamentsReleased);
 	}
 }
 
@@ -80,6 +79,14 @@ void THISCLASS::OnWebotsPhysicsDraw() {/*
 	glEnable(GL_DEPTH_TEST);*/
 }
 
+void THISCLASS::Read(DataFileReader &f) {
+	mState.mReleaseAmountAccumulator = f.Double();
+}
+
+void THISCLASS::Write(DataFileWriter &f) {
+	f.Double(mState.mReleaseAmountAccumulator);
+}
+
 void THISCLASS::WriteConfiguration(std::ostream &out) {
 	out << "<FilamentSourceConstant>" << std::endl;
 	out << "\t<Radius>" << mConfiguration.mRadius << "</Radius>" << std::endl;
@@ -9,7 +9,7 @@ class FilamentSourceConstant;
 #include "Point3.h"
 #include "SimulationInterface.h"
 #include "Simulation.h"
-#include <ode/ode.h>
+#include "SimulationHost.h"
 
 //! Creates a uniform rectangular filament distribution.
 class FilamentSourceConstant: public FilamentSource {
@@ -17,7 +17,7 @@ class FilamentSourceConstant: public FilamentSource {
 public:
 	//! Webots interface.
 	struct {
-		dGeomID mGeometryID;		//!< Geometry ID, which allows us to get the position.
+		SimulationHost::tObject mGeometryID;	//!< Host object (e.g. Webots geometry), which allows us to get the position.
 	} mWebotsInterface;
 
 	//! Sensor configuration.
@@ -43,6 +43,8 @@ public:
 	void OnSimulationStep();
 	void OnWebotsPhysicsDraw();
 	void WriteConfiguration(std::ostream &out);
+	void Read(DataFileReader &f);
+	void Write(DataFileWriter &f);
 };
 
 #endif
@@ -6,7 +6,6 @@
 #include "Random.h"
 #include "Constants.h"
 #include <cassert>
-#include <plugins/physics.h>
 #define	THISCLASS FilamentSourceIntermittent
 
 THISCLASS::FilamentSourceIntermittent(Simulation *sim):
@@ -26,11 +25,10 @@ void THISCLASS::OnSimulationEnd() {}
 
 void THISCLASS::OnSimulationStep() {
 	// Get the position of the source
-	const dReal *p = dGeomGetPosition(mWebotsInterface.mGeometryID);
-	const Point3 position(p[0], p[1], p[2]);
+	const Point3 position = mSimulation->mHost->GetPosition(mWebotsInterface.mGeometryID);
 
 	// Generate a poisson distributed amount of filaments
-	Random r;
+	Random &r = mSimulation->mRandom;
 	int amount = r.Poisson(mConfiguration.mReleaseAmount * mSimulation->mSimulationTimeStep);
 
 	// Create filaments
@@ -51,6 +49,7 @@ void THISCLASS::OnSimulationStep() {
 		}
 		f->mPosition += position;
 	}
+	mSimulation->mCounters.Increment(SimulationCounters::sCounterFilamentsReleased, amount);
 }
 
 void THISCLASS::OnWebotsPhysicsDraw() {/*
@@ -9,7 +9,7 @@ class FilamentSourceIntermittent;
 #include "Point3.h"
 #include "SimulationInterface.h"
 #include "Simulation.h"
-#include <ode/ode.h>
+#include "SimulationHost.h"
 
 //! A intermittent filament source.
 class FilamentSourceIntermittent: public FilamentSource {
@@ -17,7 +17,7 @@ class FilamentSourceIntermittent: public FilamentSource {
 public:
 	//! Webots interface.
 	struct {
-		dGeomID mGeometryID;		//!< Geometry ID, which allows us to get the position.
+		SimulationHost::tObject mGeometryID;	//!< Host object (e.g. Webots geometry), which allows us to get the position.
 	} mWebotsInterface;
 
 	//! Sensor configuration.
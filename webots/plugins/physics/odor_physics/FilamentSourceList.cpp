@@ -61,6 +61,14 @@ void THISCLASS::AddFilamentSource(FilamentSource *fs) {
 	mFilamentSources.push_back(fs);
 }
 
+void THISCLASS::GetCheckpointObjects(std::vector<SimulationInterface*> &objects) {
+	tFilamentSourceList::iterator it = mFilamentSources.begin();
+	while (it != mFilamentSources.end()) {
+		objects.push_back(*it);
+		it++;
+	}
+}
+
 void THISCLASS::WriteConfiguration(std::ostream &out) {
 	out << "<FilamentSourceList>" << std::endl;
 	tFilamentSourceList::iterator it = mFilamentSources.begin();
@@ -31,6 +31,10 @@ public:
 
 	//! Adds a filament source.
 	void AddFilamentSource(FilamentSource *fs);
+	//! Returns the number of filament sources.
+	int GetCount() const {
+		return (int)mFilamentSources.size();
+	}
 
 	// SimulationInterface methods.
 	void OnSimulationStart();
@@ -38,6 +42,7 @@ public:
 	void OnSimulationStep();
 	void OnWebotsPhysicsDraw();
 	void WriteConfiguration(std::ostream &out);
+	void GetCheckpointObjects(std::vector<SimulationInterface*> &objects);
 };
 
 #endif
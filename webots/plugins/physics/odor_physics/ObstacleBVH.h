@@ -0,0 +1,274 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classObstacleBVH
+#define classObstacleBVH
+
+class ObstacleBVH;
+
+#include <vector>
+#include <algorithm>
+
+//!	Bounding volume hierarchy over axis-aligned boxes.
+/*!
+	The boxes are sorted into a binary tree of bounding boxes (split at the median of the longest axis), such that point and segment queries only visit O(log n) nodes.
+	This class only depends on the standard library, so that controllers can include it as well (e.g. with #include "../../plugins/physics/odor_physics/ObstacleBVH.h").
+	Boxes are half-open, as in Cube::Inside: a point p is inside if a <= p < b on all axes. For 2D maps, use a z range that covers all queries.
+
+	Usage:
+		ObstacleBVH bvh;
+		bvh.Add(xmin, ymin, -1e9, xmax, ymax, 1e9);		// for each obstacle
+		bvh.Build();
+		int id = bvh.Inside(x, y, 0);					// index of the box containing the point, or -1
+*/
+class ObstacleBVH {
+
+protected:
+	//! A box.
+	struct tBox {
+		double a[3];		//!< Minimum corner.
+		double b[3];		//!< Maximum corner (exclusive).
+	};
+	//! A node of the tree. Leaves hold the boxes mIndex[first] to mIndex[first + count - 1]. Inner nodes (count == 0) have their first child at the next position and their second child at first.
+	struct tNode {
+		tBox box;			//!< Bounding box of all boxes below this node.
+		int first;			//!< First box (leaf) or second child (inner node).
+		int count;			//!< Number of boxes (leaf), or 0 (inner node).
+	};
+
+	//! The boxes in the order they were added.
+	std::vector<tBox> mBoxes;
+	//! The nodes (the root is the first node).
+	std::vector<tNode> mNodes;
+	//! Box indices, sorted such that each leaf references a contiguous range.
+	std::vector<int> mIndex;
+
+	//! Maximum number of boxes per leaf.
+	static const int mLeafSize = 4;
+	//! Size of the traversal stack of the queries (the tree is balanced, so its depth is about log2 of the number of boxes).
+	static const int mStackSize = 64;
+
+	//! Returns the centre of a box along one axis.
+	static double Centre(const tBox &box, int axis) {
+		return box.a[axis] + box.b[axis];
+	}
+
+	//! Comparison of two box indices by their centre along one axis.
+	struct tCompare {
+		const std::vector<tBox> *boxes;
+		int axis;
+		bool operator()(int i, int j) const {
+			return Centre((*boxes)[i], axis) < Centre((*boxes)[j], axis);
+		}
+	};
+
+	//! Builds the subtree of mIndex[first] to mIndex[last - 1], and returns its node.
+	int BuildNode(int first, int last) {
+		int node = mNodes.size();
+		mNodes.push_back(tNode());
+
+		// Bounding box of the boxes and of their centres
+		tBox box = mBoxes[mIndex[first]];
+		double cmin[3], cmax[3];
+		for (int k = 0; k < 3; k++) {
+			cmin[k] = cmax[k] = Centre(box, k);
+		}
+		for (int i = first + 1; i < last; i++) {
+			const tBox &bi = mBoxes[mIndex[i]];
+			for (int k = 0; k < 3; k++) {
+				box.a[k] = std::min(box.a[k], bi.a[k]);
+				box.b[k] = std::max(box.b[k], bi.b[k]);
+				cmin[k] = std::min(cmin[k], Centre(bi, k));
+				cmax[k] = std::max(cmax[k], Centre(bi, k));
+			}
+		}
+		mNodes[node].box = box;
+
+		if (last - first <= mLeafSize) {
+			mNodes[node].first = first;
+			mNodes[node].count = last - first;
+			return node;
+		}
+
+		// Split at the median of the axis along which the centres are spread most
+		int axis = 0;
+		for (int k = 1; k < 3; k++) {
+			if (cmax[k] - cmin[k] > cmax[axis] - cmin[axis]) {
+				axis = k;
+			}
+		}
+		int middle = (first + last) / 2;
+		tCompare compare = {&mBoxes, axis};
+		std::nth_element(mIndex.begin() + first, mIndex.begin() + middle, mIndex.begin() + last, compare);
+
+		BuildNode(first, middle);
+		int second = BuildNode(middle, last);
+		mNodes[node].first = second;
+		mNodes[node].count = 0;
+		return node;
+	}
+
+	//! Returns true if the point is inside the box.
+	static bool InsideBox(const tBox &box, double x, double y, double z) {
+		return (x >= box.a[0]) && (y >= box.a[1]) && (z >= box.a[2]) && (x < box.b[0]) && (y < box.b[1]) && (z < box.b[2]);
+	}
+
+	//! Intersects the segment p + t d (t in [0, tmax]) with a box (slab test). Returns the entry parameter, or -1 if the segment misses the box.
+	/*!
+		Like InsideBox, the slabs are half-open: along each axis, the parameter range on the side of the maximum corner excludes its bound. A segment that only touches the maximum face of a box therefore misses it.
+	*/
+	static double EnterBox(const tBox &box, const double *p, const double *d, const double *dinv, double tmax) {
+		double t0 = 0;
+		double t1 = tmax;
+		bool t0open = false;
+		bool t1open = false;
+		for (int k = 0; k < 3; k++) {
+			// Segment parallel to the slab
+			if (d[k] == 0) {
+				if ((p[k] < box.a[k]) || (p[k] >= box.b[k])) {
+					return -1;
+				}
+				continue;
+			}
+
+			// Parameter range [ta, tb) (positive direction) or (tb, ta] (negative direction)
+			double ta = (box.a[k] - p[k]) * dinv[k];
+			double tb = (box.b[k] - p[k]) * dinv[k];
+			if (d[k] > 0) {
+				if (ta > t0) {
+					t0 = ta;
+					t0open = false;
+				}
+				if (tb <= t1) {
+					t1 = tb;
+					t1open = true;
+				}
+			} else {
+				if (tb >= t0) {
+					t0 = tb;
+					t0open = true;
+				}
+				if (ta < t1) {
+					t1 = ta;
+					t1open = false;
+				}
+			}
+			if ((t0 > t1) || ((t0 == t1) && (t0open || t1open))) {
+				return -1;
+			}
+		}
+		return t0;
+	}
+
+public:
+	//! Constructor.
+	ObstacleBVH(): mBoxes(), mNodes(), mIndex() {}
+
+	//! Removes all boxes.
+	void Clear() {
+		mBoxes.clear();
+		mNodes.clear();
+		mIndex.clear();
+	}
+	//! Adds a box, and returns its index. Build must be called before the next query.
+	int Add(double xmin, double ymin, double zmin, double xmax, double ymax, double zmax) {
+		tBox box = {{xmin, ymin, zmin}, {xmax, ymax, zmax}};
+		mBoxes.push_back(box);
+		return mBoxes.size() - 1;
+	}
+	//! Returns the number of boxes.
+	int GetCount() const {
+		return mBoxes.size();
+	}
+	//! Returns the number of nodes.
+	int GetNodeCount() const {
+		return mNodes.size();
+	}
+
+	//! Builds the tree.
+	void Build() {
+		mNodes.clear();
+		mIndex.resize(mBoxes.size());
+		for (unsigned int i = 0; i < mBoxes.size(); i++) {
+			mIndex[i] = i;
+		}
+		if (! mBoxes.empty()) {
+			mNodes.reserve(2 * mBoxes.size() / mLeafSize + 1);
+			BuildNode(0, mBoxes.size());
+		}
+	}
+
+	//! Returns the index of a box containing the point, or -1 if there is none. Queries do not modify the tree, and can run in parallel.
+	int Inside(double x, double y, double z) const {
+		if (mNodes.empty()) {
+			return -1;
+		}
+		int stack[mStackSize];
+		int size = 0;
+		stack[size++] = 0;
+		while (size > 0) {
+			int current = stack[--size];
+			const tNode &node = mNodes[current];
+			if (! InsideBox(node.box, x, y, z)) {
+				continue;
+			}
+			if (node.count == 0) {
+				stack[size++] = node.first;
+				stack[size++] = current + 1;
+				continue;
+			}
+			for (int i = node.first; i < node.first + node.count; i++) {
+				if (InsideBox(mBoxes[mIndex[i]], x, y, z)) {
+					return mIndex[i];
+				}
+			}
+		}
+		return -1;
+	}
+
+	//! Returns the index of the first box hit by the segment from (x0, y0, z0) to (x1, y1, z1), or -1 if there is none. t is set to the position of the hit along the segment (0 at the start, 1 at the end).
+	/*!
+		Boxes containing the start point are ignored, so that a segment starting inside a box (e.g. a filament inside an obstacle that was added after it) can leave it.
+	*/
+	int Segment(double x0, double y0, double z0, double x1, double y1, double z1, double &t) const {
+		t = 1;
+		if (mNodes.empty()) {
+			return -1;
+		}
+		double p[3] = {x0, y0, z0};
+		double d[3] = {x1 - x0, y1 - y0, z1 - z0};
+		double dinv[3] = {1 / d[0], 1 / d[1], 1 / d[2]};
+		int hit = -1;
+		double thit = 1;
+		int stack[mStackSize];
+		int size = 0;
+		stack[size++] = 0;
+		while (size > 0) {
+			int current = stack[--size];
+			const tNode &node = mNodes[current];
+			if (EnterBox(node.box, p, d, dinv, thit) < 0) {
+				continue;
+			}
+			if (node.count == 0) {
+				stack[size++] = node.first;
+				stack[size++] = current + 1;
+				continue;
+			}
+			for (int i = node.first; i < node.first + node.count; i++) {
+				const tBox &box = mBoxes[mIndex[i]];
+				if (InsideBox(box, x0, y0, z0)) {
+					continue;
+				}
+				double ti = EnterBox(box, p, d, dinv, thit);
+				if ((ti >= 0) && ((hit < 0) || (ti < thit))) {
+					hit = mIndex[i];
+					thit = ti;
+				}
+			}
+		}
+		t = thit;
+		return hit;
+	}
+};
+
+#endif
@@ -0,0 +1,127 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#include <cmath>
+#include "ObstacleDistanceField.h"
+#define	THISCLASS ObstacleDistanceField
+
+double THISCLASS::PolygonDistance(const std::vector<Point3> &polygon, double x, double y) {
+	double dmin2 = -1;
+	bool inside = false;
+	int n = polygon.size();
+	for (int i = 0, j = n - 1; i < n; j = i++) {
+		const Point3 &a = polygon[j];
+		const Point3 &b = polygon[i];
+
+		// Crossing number (ray towards +x)
+		if (((a.y > y) != (b.y > y)) && (x < a.x + (b.x - a.x) * (y - a.y) / (b.y - a.y))) {
+			inside = ! inside;
+		}
+
+		// Distance to the edge
+		double ex = b.x - a.x;
+		double ey = b.y - a.y;
+		double l2 = ex * ex + ey * ey;
+		double t = (l2 > 0 ? ((x - a.x) * ex + (y - a.y) * ey) / l2 : 0);
+		t = (t < 0 ? 0 : (t > 1 ? 1 : t));
+		double dx = x - (a.x + t * ex);
+		double dy = y - (a.y + t * ey);
+		double d2 = dx * dx + dy * dy;
+		if ((dmin2 < 0) || (d2 < dmin2)) {
+			dmin2 = d2;
+		}
+	}
+	double d = sqrt(dmin2);
+	return inside ? d : -d;
+}
+
+void THISCLASS::Build(const std::vector<Cube> &cubes, const std::vector<Point3> &boundary, double resolution, double band) {
+	mDistance.clear();
+	mSize = Point3Int(0, 0, 0);
+	bool arena = (boundary.size() >= 3);
+
+	// Extent of the obstacles and the arena (the arena has no extent along z)
+	Cube bounds;
+	for (unsigned int i = 0; i < cubes.size(); i++) {
+		bounds.Include(cubes[i]);
+	}
+	bool hascubes = ! bounds.IsEmpty();
+	if (arena) {
+		Point3 a = boundary[0];
+		Point3 b = boundary[0];
+		for (unsigned int i = 1; i < boundary.size(); i++) {
+			a = Point3(boundary[i].x < a.x ? boundary[i].x : a.x, boundary[i].y < a.y ? boundary[i].y : a.y, 0);
+			b = Point3(boundary[i].x > b.x ? boundary[i].x : b.x, boundary[i].y > b.y ? boundary[i].y : b.y, 0);
+		}
+		if (hascubes) {
+			bounds.a = Point3(a.x < bounds.a.x ? a.x : bounds.a.x, a.y < bounds.a.y ? a.y : bounds.a.y, bounds.a.z);
+			bounds.b = Point3(b.x > bounds.b.x ? b.x : bounds.b.x, b.y > bounds.b.y ? b.y : bounds.b.y, bounds.b.z);
+		} else {
+			bounds = Cube(a.x, a.y, 0, b.x, b.y, 0);
+		}
+	} else if (! hascubes) {
+		return;
+	}
+
+	// Grid covering the extent and the band around it (at least 2 grid points on each axis)
+	mResolution = resolution;
+	mResolutionInv = 1 / resolution;
+	mBand = band;
+	mOrigin = bounds.a - Point3(band, band, hascubes ? band : 0);
+	Point3 extent = bounds.Size() + Point3(2 * band, 2 * band, hascubes ? 2 * band : 0);
+	mSize = Point3Int((int)ceil(extent.x * mResolutionInv) + 1, (int)ceil(extent.y * mResolutionInv) + 1, (int)ceil(extent.z * mResolutionInv) + 1);
+	mSize = Point3Int(mSize.x > 2 ? mSize.x : 2, mSize.y > 2 ? mSize.y : 2, mSize.z > 2 ? mSize.z : 2);
+	mDistance.assign(mSize.Volume(), (float)band);
+
+	// Arena walls (the same for all layers)
+	if (arena) {
+		int layer = mSize.x * mSize.y;
+		for (int iy = 0; iy < mSize.y; iy++) {
+			for (int ix = 0; ix < mSize.x; ix++) {
+				double d = PolygonDistance(boundary, mOrigin.x + ix * resolution, mOrigin.y + iy * resolution);
+				d = (d < -band ? -band : (d > band ? band : d));
+				for (int iz = 0; iz < mSize.z; iz++) {
+					mDistance[ix + mSize.x * iy + layer * iz] = (float)d;
+				}
+			}
+		}
+	}
+
+	// Cubes (the distance to a union is the minimum of the distances, which is exact outside of the obstacles)
+	for (unsigned int i = 0; i < cubes.size(); i++) {
+		const Cube &c = cubes[i];
+		if (c.IsEmpty()) {
+			continue;
+		}
+		Point3 centre = (c.a + c.b) * 0.5;
+		Point3 half = c.Size() * 0.5;
+		int x0 = (int)floor((c.a.x - band - mOrigin.x) * mResolutionInv), x1 = (int)ceil((c.b.x + band - mOrigin.x) * mResolutionInv);
+		int y0 = (int)floor((c.a.y - band - mOrigin.y) * mResolutionInv), y1 = (int)ceil((c.b.y + band - mOrigin.y) * mResolutionInv);
+		int z0 = (int)floor((c.a.z - band - mOrigin.z) * mResolutionInv), z1 = (int)ceil((c.b.z + band - mOrigin.z) * mResolutionInv);
+		x0 = (x0 < 0 ? 0 : x0);
+		y0 = (y0 < 0 ? 0 : y0);
+		z0 = (z0 < 0 ? 0 : z0);
+		x1 = (x1 >= mSize.x ? mSize.x - 1 : x1);
+		y1 = (y1 >= mSize.y ? mSize.y - 1 : y1);
+		z1 = (z1 >= mSize.z ? mSize.z - 1 : z1);
+		for (int iz = z0; iz <= z1; iz++) {
+			double qz = fabs(mOrigin.z + iz * resolution - centre.z) - half.z;
+			for (int iy = y0; iy <= y1; iy++) {
+				double qy = fabs(mOrigin.y + iy * resolution - centre.y) - half.y;
+				for (int ix = x0; ix <= x1; ix++) {
+					double qx = fabs(mOrigin.x + ix * resolution - centre.x) - half.x;
+
+					// Distance to the box: Euclidean outside, distance to the nearest face inside
+					double ox = (qx > 0 ? qx : 0), oy = (qy > 0 ? qy : 0), oz = (qz > 0 ? qz : 0);
+					double qmax = (qx > qy ? (qx > qz ? qx : qz) : (qy > qz ? qy : qz));
+					double d = sqrt(ox * ox + oy * oy + oz * oz) + (qmax < 0 ? qmax : 0);
+					d = (d < -band ? -band : d);
+					float &cell = mDistance[ix + mSize.x * (iy + mSize.y * iz)];
+					if (d < cell) {
+						cell = (float)d;
+					}
+				}
+			}
+		}
+	}
+}
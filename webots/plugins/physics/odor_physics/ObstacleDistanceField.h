@@ -0,0 +1,107 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classObstacleDistanceField
+#define classObstacleDistanceField
+
+class ObstacleDistanceField;
+
+#include <vector>
+#include <stddef.h>
+#include "Point3.h"
+#include "Point3Int.h"
+#include "Cube.h"
+
+//!	Signed distance to the nearest obstacle surface or arena wall, sampled on a regular grid.
+/*!
+	The distance is positive in free space, and negative inside obstacles (cubes) and outside of the arena (a polygon in the x-y plane, extruded along z).
+	Only a band around the surfaces is needed to reflect filaments, so distances are clamped to [-band, band], and each cube only updates the grid points within band of it.
+	GetDistance interpolates the distance trilinearly, and returns the gradient of the interpolation, which points away from the nearest surface.
+	Points beyond the grid are clamped to the grid.
+*/
+class ObstacleDistanceField {
+
+protected:
+	//! First grid point.
+	Point3 mOrigin;
+	//! Distance between grid points (on all axes).
+	double mResolution;
+	//! Inverse of mResolution.
+	double mResolutionInv;
+	//! Number of grid points on each axis (at least 2, or 0 if the field is empty).
+	Point3Int mSize;
+	//! Distances are clamped to [-mBand, mBand].
+	double mBand;
+	//! Distance at each grid point (x varies fastest).
+	std::vector<float> mDistance;
+
+	//! Returns the signed distance from a point in the x-y plane to a polygon (positive inside).
+	static double PolygonDistance(const std::vector<Point3> &polygon, double x, double y);
+
+public:
+	//! Constructor.
+	ObstacleDistanceField(): mOrigin(), mResolution(0), mResolutionInv(0), mSize(0, 0, 0), mBand(0), mDistance() {}
+
+	//! Samples the distance field of the cubes and the arena boundary (x-y polygon, ignored if it has less than 3 points) with the given grid resolution. Distances are exact within band of a surface.
+	void Build(const std::vector<Cube> &cubes, const std::vector<Point3> &boundary, double resolution, double band);
+	//! Returns true if the field has been built.
+	bool IsEmpty() const {
+		return mDistance.empty();
+	}
+	//! Returns the number of bytes used by the field.
+	size_t GetMemorySize() const {
+		return sizeof(float) * mDistance.size();
+	}
+	//! Returns the number of grid points on each axis.
+	Point3Int GetSize() const {
+		return mSize;
+	}
+
+	//! Returns the signed distance at a point, and the gradient of the distance (approximately a unit vector pointing away from the nearest surface).
+	inline double GetDistance(const Point3 &p, Point3 &gradient) const;
+};
+
+// Returns the lower grid index of the interpolation interval along one axis (n >= 2 grid points), and the interpolation factor.
+static inline int DistanceFieldIndex(double f, int n, double &t) {
+	if (f <= 0) {
+		t = 0;
+		return 0;
+	}
+	if (f >= n - 1) {
+		t = 1;
+		return n - 2;
+	}
+	int i = (int)f;
+	t = f - i;
+	return i;
+}
+
+inline double ObstacleDistanceField::GetDistance(const Point3 &p, Point3 &gradient) const {
+	double tx, ty, tz;
+	int ix = DistanceFieldIndex((p.x - mOrigin.x) * mResolutionInv, mSize.x, tx);
+	int iy = DistanceFieldIndex((p.y - mOrigin.y) * mResolutionInv, mSize.y, ty);
+	int iz = DistanceFieldIndex((p.z - mOrigin.z) * mResolutionInv, mSize.z, tz);
+	int dy = mSize.x;
+	int dz = mSize.x * mSize.y;
+	const float *d = &mDistance[ix + mSize.x * (iy + mSize.y * iz)];
+
+	// The 8 surrounding grid points
+	double d000 = d[0], d100 = d[1], d010 = d[dy], d110 = d[dy + 1];
+	double d001 = d[dz], d101 = d[dz + 1], d011 = d[dz + dy], d111 = d[dz + dy + 1];
+
+	// Interpolate along x, then y, then z (and differentiate each step)
+	double d00 = d000 + (d100 - d000) * tx, d10 = d010 + (d110 - d010) * tx;
+	double d01 = d001 + (d101 - d001) * tx, d11 = d011 + (d111 - d011) * tx;
+	double d0 = d00 + (d10 - d00) * ty;
+	double d1 = d01 + (d11 - d01) * ty;
+
+	double gx00 = d100 - d000, gx10 = d110 - d010, gx01 = d101 - d001, gx11 = d111 - d011;
+	double gx0 = gx00 + (gx10 - gx00) * ty;
+	double gx1 = gx01 + (gx11 - gx01) * ty;
+	gradient.x = (gx0 + (gx1 - gx0) * tz) * mResolutionInv;
+	gradient.y = ((d10 - d00) + ((d11 - d01) - (d10 - d00)) * tz) * mResolutionInv;
+	gradient.z = (d1 - d0) * mResolutionInv;
+	return d0 + (d1 - d0) * tz;
+}
+
+#endif
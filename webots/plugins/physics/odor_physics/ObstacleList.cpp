@@ -2,6 +2,7 @@
 // Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
 
 #include <stdlib.h>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include "ObstacleList.h"
@@ -9,7 +10,9 @@
 #define	THISCLASS ObstacleList
 
 THISCLASS::ObstacleList(Simulation *sim, int count):
-		SimulationInterface(sim), mObstacle(NULL), mCountAllocated(0), mLastAdded(-1) {
+		SimulationInterface(sim), mObstacle(NULL), mCountAllocated(0), mLastAdded(-1),
+		mLookup(sLookupVoxels), mBVH(), mBVHObstacles(), mVoxelsDirty(true), mVoxelSize(0), mVoxelOrigin(), mVoxelSizeInv(0), mVoxelCount(0, 0, 0), mOccupied(), mInterior(), mOccupiedRank(), mCandidateStart(), mCandidates(),
+		mArena(), mDistanceResolution(0), mDistanceBand(0), mDistanceField() {
 
 	SetCount(count);
 	mSimulation->mObstacleList = this;
@@ -23,6 +26,8 @@ THISCLASS::~ObstacleList() {
 }
 
 void THISCLASS::SetCount(int count) {
+	mVoxelsDirty = true;
+
 	// If more obstacles than allocated are requested, create a new set of obstacles.
 	if (count > mCountAllocated) {
 		Obstacle *oldobstacle = mObstacle;
@@ -57,22 +62,18 @@ void THISCLASS::SetCount(int count) {
 }
 
 Obstacle *THISCLASS::AddObstacle() {
-	int id = mLastAdded + 1;
-	if (id >= mCountAllocated) {
-		id = 0;
-	}
-	while (id != mLastAdded) {
+	// Take the first free slot after the last added obstacle
+	for (int i = 1; i <= mCountAllocated; i++) {
+		int id = (mLastAdded + i) % mCountAllocated;
 		if (! mObstacle[id].mExists) {
 			mLastAdded = id;
 			mObstacle[id].mExists = true;
+			mVoxelsDirty = true;
 			return &(mObstacle[id]);
 		}
-		if (id >= mCountAllocated) {
-			id = 0;
-		}
 	}
 
-	SetCount(mCountAllocated*2);
+	SetCount(mCountAllocated > 0 ? mCountAllocated * 2 : 4);
 	return AddObstacle();
 }
 
@@ -81,17 +82,256 @@ void THISCLASS::ReadTextFile(const std::string filename) {
 	f.Read(this);
 }
 
+void THISCLASS::SetBoundary(const std::vector<Point3> &boundary) {
+	mArena.Clear();
+	for (unsigned int i = 0; i < boundary.size(); i++) {
+		mArena.AddBoundaryPoint(boundary[i].x, boundary[i].y);
+	}
+	mVoxelsDirty = true;
+}
+
+bool THISCLASS::ReadBoundaryFile(const std::string filename) {
+	mVoxelsDirty = true;
+	return mArena.ReadEnvironmentFile(filename);
+}
+
+bool THISCLASS::ReadObstacleListFile(const std::string filename, double zmin, double zmax) {
+	ArenaGeometry rectangles;
+	bool ok = rectangles.ReadObstacleFile(filename);
+	for (int i = 0; i < rectangles.GetObstacleCount(); i++) {
+		const ArenaGeometry::tObstacle &r = rectangles.GetObstacle(i);
+		Obstacle *o = AddObstacle();
+		o->mCube = Cube(r.xmin, r.ymin, zmin, r.xmax, r.ymax, zmax);
+	}
+	return ok;
+}
+
+// Returns the number of bits set.
+static inline int CountBits(unsigned int word) {
+#ifdef __GNUC__
+	return __builtin_popcount(word);
+#else
+	int count = 0;
+	for (; word; word &= word - 1) {
+		count++;
+	}
+	return count;
+#endif
+}
+
+// Computes the voxels [first, last] touched by the interval [a, b) along one axis, and the voxels [infirst, inlast] that only contain points within that interval.
+// The bounds are computed with the same (monotonic) mapping as in GetObstacle, such that rounding never misclassifies a point.
+static void VoxelRange(double a, double b, double origin, double sizeinv, int count, int &first, int &last, int &infirst, int &inlast) {
+	double fa = (a - origin) * sizeinv;
+	double fb = (b - origin) * sizeinv;
+	first = (int)floor(fa);
+	last = (int)floor(fb);
+	first = (first < 0 ? 0 : first);
+	last = (last >= count ? count - 1 : last);
+
+	// Points below a map to voxels <= fa, but points below the origin are outside the grid. Points beyond b map to voxels >= fb.
+	infirst = (a <= origin ? 0 : (int)floor(fa) + 1);
+	inlast = (int)floor(fb) - 1;
+}
+
 Obstacle *THISCLASS::GetObstacle(const Point3 &preal) {
-	for (int i = 0; i < mCountAllocated; i++) {
-		if (mObstacle[i].IsObstacle(preal)) {
-			return &(mObstacle[i]);
+	if (mVoxelsDirty) {
+		Update();
+	}
+	if (mLookup == sLookupBVH) {
+		int box = mBVH.Inside(preal.x, preal.y, preal.z);
+		return (box < 0 ? 0 : &(mObstacle[mBVHObstacles[box]]));
+	}
+
+	// Voxel containing the point (points outside the bounding box are free)
+	double fx = (preal.x - mVoxelOrigin.x) * mVoxelSizeInv;
+	double fy = (preal.y - mVoxelOrigin.y) * mVoxelSizeInv;
+	double fz = (preal.z - mVoxelOrigin.z) * mVoxelSizeInv;
+	if (! ((fx >= 0) && (fy >= 0) && (fz >= 0) && (fx < mVoxelCount.x) && (fy < mVoxelCount.y) && (fz < mVoxelCount.z))) {
+		return 0;
+	}
+	int v = (int)fx + mVoxelCount.x * ((int)fy + mVoxelCount.y * (int)fz);
+	unsigned int word = mOccupied[v >> 5];
+	unsigned int bit = 1u << (v & 31);
+	if (! (word & bit)) {
+		return 0;
+	}
+
+	// Candidates of this voxel
+	int rank = mOccupiedRank[v >> 5] + CountBits(word & (bit - 1));
+	int first = mCandidateStart[rank];
+	if (mInterior[v >> 5] & bit) {
+		return &(mObstacle[mCandidates[first]]);
+	}
+	for (int c = first; c < mCandidateStart[rank + 1]; c++) {
+		Obstacle *o = &(mObstacle[mCandidates[c]]);
+		if (o->IsObstacle(preal)) {
+			return o;
 		}
 	}
 	return 0;
 }
 
+Obstacle *THISCLASS::GetObstacle(const Point3 &p0, const Point3 &p1, double &t) {
+	if (mVoxelsDirty) {
+		Update();
+	}
+	int box = mBVH.Segment(p0.x, p0.y, p0.z, p1.x, p1.y, p1.z, t);
+	return (box < 0 ? 0 : &(mObstacle[mBVHObstacles[box]]));
+}
+
+void THISCLASS::Update() {
+	mVoxelsDirty = false;
+	mVoxelCount = Point3Int(0, 0, 0);
+	mOccupied.clear();
+	mInterior.clear();
+	mOccupiedRank.clear();
+	mCandidateStart.clear();
+	mCandidates.clear();
+
+	// Bounding volume hierarchy and bounding box of all obstacles
+	mBVH.Clear();
+	mBVHObstacles.clear();
+	Cube bounds;
+	for (int i = 0; i < mCountAllocated; i++) {
+		const Cube &c = mObstacle[i].mCube;
+		if ((! mObstacle[i].mExists) || c.IsEmpty()) {
+			continue;
+		}
+		mBVH.Add(c.a.x, c.a.y, c.a.z, c.b.x, c.b.y, c.b.z);
+		mBVHObstacles.push_back(i);
+		bounds.Include(c);
+	}
+	mBVH.Build();
+
+	// Containment table of the arena
+	mArena.Build();
+
+	// Signed distance field
+	if (mDistanceResolution > 0) {
+		std::vector<Cube> cubes;
+		GetCubes(cubes);
+		std::vector<Point3> boundary;
+		for (int i = 0; i < mArena.GetBoundaryCount(); i++) {
+			boundary.push_back(Point3(mArena.GetBoundaryPoint(i).x, mArena.GetBoundaryPoint(i).y, 0));
+		}
+		mDistanceField.Build(cubes, boundary, mDistanceResolution, mDistanceBand);
+	} else {
+		mDistanceField = ObstacleDistanceField();
+	}
+
+	if ((mLookup != sLookupVoxels) || bounds.IsEmpty()) {
+		return;
+	}
+
+	// Cubic voxels, by default such that the grid has about 2^20 voxels (and never more than 2^24)
+	Point3 size = bounds.Size();
+	double voxelsize = (mVoxelSize > 0 ? mVoxelSize : cbrt(size.x * size.y * size.z / 1048576.));
+	mVoxelOrigin = bounds.a;
+	while (1) {
+		mVoxelSizeInv = 1 / voxelsize;
+		mVoxelCount = Point3Int((int)ceil(size.x * mVoxelSizeInv), (int)ceil(size.y * mVoxelSizeInv), (int)ceil(size.z * mVoxelSizeInv));
+		mVoxelCount = Point3Int(mVoxelCount.x > 0 ? mVoxelCount.x : 1, mVoxelCount.y > 0 ? mVoxelCount.y : 1, mVoxelCount.z > 0 ? mVoxelCount.z : 1);
+		if ((double)mVoxelCount.x * mVoxelCount.y * mVoxelCount.z <= 16777216.) {
+			break;
+		}
+		voxelsize *= 1.25;
+	}
+	int voxels = mVoxelCount.Volume();
+	int words = (voxels + 31) >> 5;
+	mOccupied.assign(words, 0);
+	mInterior.assign(words, 0);
+
+	// Two passes over the obstacles: the first marks the voxels touched by each obstacle, counts the obstacles per voxel and finds the interior voxels, and the second fills the candidate lists
+	std::vector<int> count(voxels, 0);
+	std::vector<int> interior(voxels, -1);
+	for (int pass = 0; pass < 2; pass++) {
+		for (int i = 0; i < mCountAllocated; i++) {
+			const Cube &c = mObstacle[i].mCube;
+			if ((! mObstacle[i].mExists) || c.IsEmpty()) {
+				continue;
+			}
+			int x0, x1, y0, y1, z0, z1, ix0, ix1, iy0, iy1, iz0, iz1;
+			VoxelRange(c.a.x, c.b.x, mVoxelOrigin.x, mVoxelSizeInv, mVoxelCount.x, x0, x1, ix0, ix1);
+			VoxelRange(c.a.y, c.b.y, mVoxelOrigin.y, mVoxelSizeInv, mVoxelCount.y, y0, y1, iy0, iy1);
+			VoxelRange(c.a.z, c.b.z, mVoxelOrigin.z, mVoxelSizeInv, mVoxelCount.z, z0, z1, iz0, iz1);
+			for (int iz = z0; iz <= z1; iz++) {
+				bool inz = (iz >= iz0) && (iz <= iz1);
+				for (int iy = y0; iy <= y1; iy++) {
+					bool iny = inz && (iy >= iy0) && (iy <= iy1);
+					for (int ix = x0; ix <= x1; ix++) {
+						bool in = iny && (ix >= ix0) && (ix <= ix1);
+						int v = ix + mVoxelCount.x * (iy + mVoxelCount.y * iz);
+						if (pass == 0) {
+							mOccupied[v >> 5] |= 1u << (v & 31);
+							count[v]++;
+							if (in && (interior[v] < 0)) {
+								interior[v] = i;
+								mInterior[v >> 5] |= 1u << (v & 31);
+							}
+						} else if (interior[v] < 0) {
+							mCandidates[count[v]++] = i;
+						}
+					}
+				}
+			}
+		}
+
+		if (pass > 0) {
+			break;
+		}
+
+		// Rank of each word, and start of each candidate list (count[v] becomes the next free entry of voxel v)
+		mOccupiedRank.resize(words);
+		int rank = 0;
+		for (int w = 0; w < words; w++) {
+			mOccupiedRank[w] = rank;
+			rank += CountBits(mOccupied[w]);
+		}
+		mCandidateStart.resize(rank + 1);
+		int entries = 0;
+		rank = 0;
+		for (int v = 0; v < voxels; v++) {
+			if (! (mOccupied[v >> 5] & (1u << (v & 31)))) {
+				continue;
+			}
+			mCandidateStart[rank++] = entries;
+			int n = (interior[v] < 0 ? count[v] : 1);
+			count[v] = entries;
+			entries += n;
+		}
+		mCandidateStart[rank] = entries;
+		mCandidates.resize(entries);
+		for (int v = 0; v < voxels; v++) {
+			if (interior[v] >= 0) {
+				mCandidates[count[v]] = interior[v];
+			}
+		}
+	}
+}
+
+void THISCLASS::GetCubes(std::vector<Cube> &cubes) const {
+	for (int i = 0; i < mCountAllocated; i++) {
+		if (mObstacle[i].mExists) {
+			cubes.push_back(mObstacle[i].mCube);
+		}
+	}
+}
+
 void THISCLASS::WriteConfiguration(std::ostream &out) {
 	out << "<ObstacleList>" << std::endl;
 	out << "<Size>" << mCountAllocated << "</Size>" << std::endl;
+	out << "<Lookup>" << (mLookup == sLookupBVH ? "bvh" : "voxels") << "</Lookup>" << std::endl;
+	out << "<BVHNodes>" << mBVH.GetNodeCount() << "</BVHNodes>" << std::endl;
+	out << "<Voxels>" << mVoxelCount << "</Voxels>" << std::endl;
+	out << "<VoxelSize>" << (mVoxelSizeInv > 0 ? 1 / mVoxelSizeInv : 0) << "</VoxelSize>" << std::endl;
+	out << "<VoxelCandidates>" << mCandidates.size() << "</VoxelCandidates>" << std::endl;
+	int cellsx, cellsy;
+	mArena.GetGridSize(cellsx, cellsy);
+	out << "<BoundaryPoints>" << mArena.GetBoundaryCount() << "</BoundaryPoints>" << std::endl;
+	out << "<BoundaryCells>" << cellsx << " " << cellsy << "</BoundaryCells>" << std::endl;
+	out << "<DistanceField>" << mDistanceField.GetSize() << "</DistanceField>" << std::endl;
+	out << "<DistanceResolution>" << mDistanceResolution << "</DistanceResolution>" << std::endl;
+	out << "<DistanceBand>" << mDistanceBand << "</DistanceBand>" << std::endl;
 	out << "</ObstacleList>" << std::endl;
 }
@@ -7,15 +7,35 @@
 class ObstacleList;
 
 #include <string>
+#include <vector>
 #include "Simulation.h"
 #include "SimulationInterface.h"
 #include "Point3.h"
+#include "Point3Int.h"
 #include "Obstacle.h"
+#include "ObstacleBVH.h"
+#include "ObstacleDistanceField.h"
+#include "ArenaGeometry.h"
 
 //!	ObstacleList
+/*!
+	The obstacles are rasterized into a voxel grid over their bounding box, which is stored as two bitmaps: voxels touched by any obstacle, and voxels entirely inside an obstacle.
+	A point in an empty voxel is therefore rejected with a single bit test, and a point in an interior voxel is accepted without testing any cube.
+	Only points in boundary voxels are tested against the (few) obstacles touching that voxel, which keeps the lookup cost independent of the number of obstacles.
+	Optionally, a signed distance field of the obstacles and of the arena boundary (see ObstacleDistanceField) can be sampled, which lets filaments be reflected off surfaces rather than stopped.
+	For large or sparse maps, on which a dense grid would be wasteful, point lookups can use a bounding volume hierarchy (see ObstacleBVH) instead. The hierarchy is always built, as it is also used for segment queries.
+	The lookup structures are rebuilt in OnSimulationStart, and whenever an obstacle was added (or Update was called) before the next lookup.
+*/
 class ObstacleList: public SimulationInterface {
 	friend class TextFileReaderObstacleList;
 
+public:
+	//! Data structures for point lookups.
+	enum eLookup {
+		sLookupVoxels = 0,				//!< Voxel occupancy bitmap (constant time).
+		sLookupBVH,						//!< Bounding volume hierarchy (logarithmic time, memory proportional to the number of obstacles).
+	};
+
 protected:
 	//! Array with obstacles.
 	Obstacle *mObstacle;
@@ -24,6 +44,43 @@ protected:
 	//! Last added obstacle ID.
 	int mLastAdded;
 
+	//! The data structure used for point lookups.
+	eLookup mLookup;
+	//! Bounding volume hierarchy over the obstacles (box i is obstacle mBVHObstacles[i]).
+	ObstacleBVH mBVH;
+	//! Obstacle of each box of the hierarchy.
+	std::vector<int> mBVHObstacles;
+
+	//! Whether the lookup structures need to be rebuilt before the next lookup.
+	bool mVoxelsDirty;
+	//! The requested edge length of the voxels (0 to choose it automatically).
+	double mVoxelSize;
+	//! Origin of the voxel grid (the minimum corner of the obstacles' bounding box).
+	Point3 mVoxelOrigin;
+	//! Inverse of the actual edge length of the voxels.
+	double mVoxelSizeInv;
+	//! Number of voxels on each axis (0 if there are no obstacles).
+	Point3Int mVoxelCount;
+	//! Bitmap of the voxels touched by at least one obstacle (x varies fastest, 32 voxels per word).
+	std::vector<unsigned int> mOccupied;
+	//! Bitmap of the voxels entirely inside an obstacle (a subset of mOccupied).
+	std::vector<unsigned int> mInterior;
+	//! Number of occupied voxels before each word of mOccupied.
+	std::vector<int> mOccupiedRank;
+	//! First entry of each occupied voxel (numbered by rank) in mCandidates, followed by the total number of entries.
+	std::vector<int> mCandidateStart;
+	//! Obstacles touching each occupied voxel. Interior voxels only list the obstacle containing them.
+	std::vector<int> mCandidates;
+
+	//! Outer boundary of the arena (counterclockwise polygon in the x-y plane, without points if the arena is unbounded).
+	ArenaGeometry mArena;
+	//! Grid resolution of the distance field (0 if the distance field is disabled).
+	double mDistanceResolution;
+	//! Distances are exact within this band around the surfaces.
+	double mDistanceBand;
+	//! Signed distance field of the obstacles and the arena boundary.
+	ObstacleDistanceField mDistanceField;
+
 public:
 	//! Constructor.
 	ObstacleList(Simulation *sim, int count = 0);
@@ -36,14 +93,58 @@ public:
 	//! Reads wind speed information from a text file.
 	void ReadTextFile(const std::string filename);
 
-	//! Returns the wind speed at a specific point.
+	//! Adds an obstacle and returns it. The caller sets its cube.
 	Obstacle *AddObstacle();
 
-	//! Returns the wind speed at a specific point.
+	//! Returns the obstacle at a specific point, or 0 if the point is free.
 	Obstacle *GetObstacle(const Point3 &preal);
+	//! Returns the first obstacle hit by the segment from p0 to p1 (e.g. a filament's previous and new position), or 0 if the segment is free. t is set to the position of the hit along the segment (0 at p0, 1 at p1). Obstacles containing p0 are ignored, so that a filament inside an obstacle is not stuck there.
+	Obstacle *GetObstacle(const Point3 &p0, const Point3 &p1, double &t);
+	//! Sets the data structure for point lookups. This takes effect with the next rebuild.
+	void SetLookup(eLookup lookup) {
+		mLookup = lookup;
+		mVoxelsDirty = true;
+	}
+	//! Sets the edge length of the voxels (0 to choose it automatically). This takes effect with the next rebuild.
+	void SetVoxelSize(double size) {
+		mVoxelSize = size;
+		mVoxelsDirty = true;
+	}
+	//! Sets the outer boundary of the arena (counterclockwise polygon in the x-y plane). This takes effect with the next rebuild.
+	void SetBoundary(const std::vector<Point3> &boundary);
+	//! Reads the outer boundary of the arena from an environment file (see ArenaGeometry). Returns false if the file could not be read.
+	bool ReadBoundaryFile(const std::string filename);
+	//! Reads rectangular obstacles from an obstacle file (see ArenaGeometry, e.g. data/obstacle_list.txt, shared with the controllers), and adds them as boxes from zmin to zmax. Returns false if the file could not be read.
+	bool ReadObstacleListFile(const std::string filename, double zmin, double zmax);
+	//! Returns the arena (with its containment table), or 0 if the arena is unbounded.
+	const ArenaGeometry *GetArena() {
+		if (mVoxelsDirty) {
+			Update();
+		}
+		return (mArena.GetBoundaryCount() < 3 ? 0 : &mArena);
+	}
+	//! Enables the signed distance field with the given grid resolution and band width (resolution 0 disables it). This takes effect with the next rebuild.
+	void SetDistanceField(double resolution, double band) {
+		mDistanceResolution = resolution;
+		mDistanceBand = band;
+		mVoxelsDirty = true;
+	}
+	//! Returns the signed distance field, or 0 if it is disabled.
+	ObstacleDistanceField *GetDistanceField() {
+		if (mVoxelsDirty) {
+			Update();
+		}
+		return (mDistanceField.IsEmpty() ? 0 : &mDistanceField);
+	}
+	//! Rebuilds the lookup structures. This must be called after modifying the cube of an existing obstacle.
+	void Update();
+	//! Appends the cubes of all obstacles to a list.
+	void GetCubes(std::vector<Cube> &cubes) const;
 
 	// SimulationInterface methods.
-	void OnSimulationStart() {}
+	void OnSimulationStart() {
+		Update();
+	}
 	void OnSimulationEnd() {}
 	void OnSimulationStep() {}
 	void OnWebotsPhysicsDraw() {}	// TODO: draw obstacles
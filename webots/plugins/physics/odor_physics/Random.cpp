@@ -4,36 +4,73 @@
 #include "Random.h"
 #define THISCLASS Random
 
-RandomMersenneTwister *Random::smRandomMersenneTwister = 0;
-RandomNormal *Random::smRandomNormal = 0;
-RandomExponential *Random::smRandomExponential = 0;
-RandomPoisson *Random::smRandomPoisson = 0;
+Random::tStream Random::smShared = {0, 0, 0, 0};
 
 
-THISCLASS::Random() {
-	if (! smRandomMersenneTwister) {
-		smRandomMersenneTwister = new RandomMersenneTwister();
+THISCLASS::Random(): mStream(&smShared) {
+	if (! smShared.mMersenneTwister) {
+		smShared.mMersenneTwister = new RandomMersenneTwister();
 		//std::cout << "MersenneTwister Random Number Generator initialized." << std::endl;
 //		generator = new std::default_random_engine;
 		Initialize();
 	}
 }
 
+THISCLASS::~Random() {
+	if (mStream == &smShared) {
+		return;
+	}
+	delete mStream->mNormal;
+	delete mStream->mExponential;
+	delete mStream->mPoisson;
+	delete mStream->mMersenneTwister;
+	delete mStream;
+}
+
 void THISCLASS::Initialize() {
-	delete smRandomNormal;
-	delete smRandomExponential;
-	delete smRandomPoisson;
-	smRandomNormal = new RandomNormal(smRandomMersenneTwister);
-	smRandomExponential = new RandomExponential(smRandomMersenneTwister);
-	smRandomPoisson = new RandomPoisson(smRandomMersenneTwister);
+	delete mStream->mNormal;
+	delete mStream->mExponential;
+	delete mStream->mPoisson;
+	mStream->mNormal = new RandomNormal(mStream->mMersenneTwister);
+	mStream->mExponential = new RandomExponential(mStream->mMersenneTwister);
+	mStream->mPoisson = new RandomPoisson(mStream->mMersenneTwister);
+}
+
+void THISCLASS::Seed(unsigned long seed) {
+	// The stream and the generator get independent seeds (seeding both with the same value would make their raw outputs identical)
+	RandomMersenneTwister::uint32 state[RandomMersenneTwister::N];
+	std::seed_seq streamseed{(unsigned long)seed, 0ul};
+	streamseed.generate(state, state + RandomMersenneTwister::N);
+	if (mStream == &smShared) {
+		mStream = new tStream();
+		mStream->mMersenneTwister = new RandomMersenneTwister(state);
+		mStream->mNormal = 0;
+		mStream->mExponential = 0;
+		mStream->mPoisson = 0;
+	} else {
+		mStream->mMersenneTwister->seed(state);
+	}
+	Initialize();
+	std::seed_seq generatorseed{(unsigned long)seed, 1ul};
+	generator.seed(generatorseed);
 }
 
 void THISCLASS::SaveState(std::ostream &out) {
-	out << *smRandomMersenneTwister << std::endl;
+	out << *mStream->mMersenneTwister << std::endl;
+	out << generator << std::endl;
 	Initialize(); // Note that we need to do this in order to be at the same state after LoadState. (Disadvantage: SaveState modifies the current state.)
 }
 
 void THISCLASS::LoadState(std::istream &in) {
-	in >> *smRandomMersenneTwister;
+	in >> *mStream->mMersenneTwister;
+	in >> generator;
 	Initialize();
 }
+
+bool THISCLASS::CheckState(std::istream &in) {
+	RandomMersenneTwister mt((RandomMersenneTwister::uint32)0);
+	std::mt19937 g;
+	in >> mt;
+	in >> g;
+	return ! in.fail();
+}
@@ -20,35 +20,53 @@ class Random;
 class Random {
 
 protected:
-        
-	//! The RandomMersenneTwister object.
-	static RandomMersenneTwister* smRandomMersenneTwister;
-	//! The RandomNormal object.
-	static RandomNormal* smRandomNormal;
-	//! The RandomExponential object.
-	static RandomExponential* smRandomExponential;
-	//! The RandomPoisson object.
-	static RandomPoisson* smRandomPoisson;
+	//! A random number stream.
+	struct tStream {
+		RandomMersenneTwister *mMersenneTwister;	//!< The RandomMersenneTwister object.
+		RandomNormal *mNormal;						//!< The RandomNormal object.
+		RandomExponential *mExponential;			//!< The RandomExponential object.
+		RandomPoisson *mPoisson;					//!< The RandomPoisson object.
+	};
+
+	//! The stream shared by all Random objects that were not seeded.
+	static tStream smShared;
+	//! The stream used by this object (either smShared, or its own stream after Seed).
+	tStream *mStream;
 
 	//! Initialization
 	void Initialize();
 
+	//! Random objects are not copied (a seeded object owns its stream).
+	Random(const Random &);
+	Random &operator=(const Random &);
+
 public:
-	//! Constructor.
+	//! Constructor. The object uses the shared stream.
 	Random();
+	//! Destructor.
+	~Random();
 	//std::default_random_engine generator; //this line has been replaced by the two following ones
 	std::random_device rd{};				//by Faezeh on March 19, 2020
 	std::mt19937 generator{rd()};			//because generated random values were always the same
 
 
-	//! Saves the current state of the RNG.
+	//! Gives this object its own stream, seeded with seed. Objects with their own stream can be used in parallel (e.g. one per simulation of an ensemble), and the same seed gives the same numbers.
+	void Seed(unsigned long seed);
+	//! Returns true if this object has its own stream (see Seed).
+	bool IsSeeded() const {
+		return (mStream != &smShared);
+	}
+
+	//! Saves the current state of the RNG (the stream and the generator).
 	void SaveState(std::ostream &in);
 	//! Loads a previously saved RNG state.
 	void LoadState(std::istream &in);
+	//! Returns true if a saved RNG state can be loaded, without modifying any stream.
+	static bool CheckState(std::istream &in);
 
 	//! Returns 0 or 1 with equal probability.
 	int Binary() {
-		return smRandomMersenneTwister->randInt() & 1;
+		return mStream->mMersenneTwister->randInt() & 1;
 		//return random() & 1;
 	}
 
@@ -62,30 +80,30 @@ public:
 		if (from >= to) {
 			return from;
 		}
-		return smRandomMersenneTwister->randInt(to - from - 1) + from;
+		return mStream->mMersenneTwister->randInt(to - from - 1) + from;
 		//return (int)((double)random() / ((double)RAND_MAX+1) * (double)(to-from)) + from;
 	}
 
 	//! Returns a double in the range [0, 1) with uniform distribution.
 	double Uniform() {
-		return smRandomMersenneTwister->randExc();
+		return mStream->mMersenneTwister->randExc();
 		//return (double)random() / ((double)RAND_MAX+1);
 	}
 
 	//! Returns a double in the range [from, to) with uniform distribution.
 	double Uniform(double from, double to) {
-		return smRandomMersenneTwister->randExc() * (to - from) + from;
+		return mStream->mMersenneTwister->randExc() * (to - from) + from;
 		//return ((double)random() / ((double)RAND_MAX+1) * (double)(to-from)) + from;
 	}
 
 	//! Returns a float with a gaussian distribution.
 	float Normal() {
-		return smRandomNormal->Normal();
+		return mStream->mNormal->Normal();
 	}
 
 	//! Returns a float with a gaussian distribution with a given standard deviation and mean.
 	float Normal(float mean, float stddev) {
-		//return smRandomNormal->Normal() * stddev + mean;
+		//return mStream->mNormal->Normal() * stddev + mean;
                   std::normal_distribution<float> distribution(mean,stddev);
                   float number = distribution(generator);
                   //printf("random number: %f\n",number);
@@ -94,12 +112,12 @@ public:
 
 	//! Returns a float with an exponential distribution.
 	float Exponential() {
-		return smRandomExponential->Exponential();
+		return mStream->mExponential->Exponential();
 	}
 
 	//! Returns an integer with a Poisson distribution.
 	long int Poisson(double mean) {
-		return smRandomPoisson->Poisson(mean);
+		return mStream->mPoisson->Poisson(mean);
 	}
 };
 
@@ -2,4 +2,12 @@
 // Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
 
 #include "Sensor.h"
+#include "Simulation.h"
 #define THISCLASS Sensor
+
+double THISCLASS::GetReportWeight(double fraction) const {
+	if ((mSimulation->mOdorUpdatePeriod > 0) && mSimulation->mSensorInterpolation) {
+		return fraction;
+	}
+	return 1;
+}
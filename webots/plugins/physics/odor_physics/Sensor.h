@@ -18,6 +18,13 @@ public:
 	//! Destructor.
 	virtual ~Sensor() {}
 
+	//! This method is invoked at physics steps without odor update (see Simulation::mOdorUpdatePeriod), with the time since the last odor update relative to the period. Sensors should report their last value again.
+	virtual void OnSimulationHold(double /*fraction*/) {}
+
+protected:
+	//! Returns the weight of the current value (as opposed to the previous value) to report at the given fraction of the odor update period.
+	double GetReportWeight(double fraction) const;
+
 };
 
 #endif
@@ -47,6 +47,15 @@ void THISCLASS::OnSimulationStep() {
 	}
 }
 
+void THISCLASS::OnSimulationHold(double fraction) {
+	tSensorList::iterator it = mSensors.begin();
+	while (it != mSensors.end()) {
+		Sensor *s = *it;
+		s->OnSimulationHold(fraction);
+		it++;
+	}
+}
+
 void THISCLASS::OnWebotsPhysicsDraw() {
 	tSensorList::iterator it = mSensors.begin();
 	while (it != mSensors.end()) {
@@ -56,6 +65,14 @@ void THISCLASS::OnWebotsPhysicsDraw() {
 	}
 }
 
+void THISCLASS::GetCheckpointObjects(std::vector<SimulationInterface*> &objects) {
+	tSensorList::iterator it = mSensors.begin();
+	while (it != mSensors.end()) {
+		objects.push_back(*it);
+		it++;
+	}
+}
+
 void THISCLASS::WriteConfiguration(std::ostream &out) {
 	out << "<SensorList>" << std::endl;
 	tSensorList::iterator it = mSensors.begin();
@@ -30,6 +30,12 @@ public:
 
 	//! Adds a sensor.
 	void AddSensor(Sensor *s);
+	//! Returns the number of sensors.
+	int GetCount() const {
+		return (int)mSensors.size();
+	}
+	//! Lets all sensors report their last values (see Sensor::OnSimulationHold).
+	void OnSimulationHold(double fraction);
 
 	// SimulationInterface methods.
 	void OnSimulationStart();
@@ -37,6 +43,7 @@ public:
 	void OnSimulationStep();
 	void OnWebotsPhysicsDraw();
 	void WriteConfiguration(std::ostream &out);
+	void GetCheckpointObjects(std::vector<SimulationInterface*> &objects);
 };
 
 #endif
@@ -1,12 +1,12 @@
 // Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
 // Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
 
+#include <cmath>
 #include "SensorOdor.h"
 #include "FilamentList.h"
 #include "Filament.h"
 #include "Random.h"
 #include "Constants.h"
-#include <plugins/physics.h>
 #define THISCLASS SensorOdor
 
 THISCLASS::SensorOdor(Simulation *sim):
@@ -18,6 +18,7 @@ THISCLASS::SensorOdor(Simulation *sim):
 	mConfiguration.mNoiseStdDev = 0;
 	mConfiguration.mRunningAverageFactor = 0;
 	mState.mConcentration = 0;
+	mState.mPreviousConcentration = 0;
 }
 
 THISCLASS::~SensorOdor() {
@@ -25,6 +26,7 @@ THISCLASS::~SensorOdor() {
 
 void THISCLASS::OnSimulationStart() {
 	mState.mConcentration = 0;
+	mState.mPreviousConcentration = 0;
 }
 
 void THISCLASS::OnSimulationEnd() {
@@ -32,24 +34,37 @@ void THISCLASS::OnSimulationEnd() {
 
 void THISCLASS::OnSimulationStep() {
 	// Get the position of the sensor
-	const dReal *p = dGeomGetPosition(mWebotsInterface.mGeometryID);
-	const Point3 position(p[0], p[1], p[2]);
+	const Point3 position = mSimulation->mHost->GetPosition(mWebotsInterface.mGeometryID);
 
 	// Get the raw concentration at the current point
 	double concentration = mSimulation->mOdorModel->GetConcentration(position, mConfiguration.mOdorType);
 
 	// Add noise
 	if (mConfiguration.mNoiseStdDev > 0) {
-		Random r;
+		Random &r = mSimulation->mRandom;
 		concentration += r.Normal(0, mConfiguration.mNoiseStdDev);
 	}
 
 	// Measured concentration is a running average
-	mState.mConcentration = mState.mConcentration * mConfiguration.mRunningAverageFactor + concentration * (1 - mConfiguration.mRunningAverageFactor);
+	mState.mPreviousConcentration = mState.mConcentration;
+	// The factor is defined per physics step, and is applied n times if this odor update spans n physics steps (see Simulation::mOdorUpdatePeriod)
+	double physicsstep = ((mSimulation->mPhysicsTimeStep > 0) ? mSimulation->mPhysicsTimeStep : mSimulation->mSimulationTimeStep);
+	double n = ((physicsstep > 0) ? mSimulation->mSimulationTimeStep / physicsstep : 1);
+	double factor = pow(mConfiguration.mRunningAverageFactor, n);
+	mState.mConcentration = mState.mConcentration * factor + concentration * (1 - factor);
+	Report(GetReportWeight(0));
+}
+
+void THISCLASS::OnSimulationHold(double fraction) {
+	Report(GetReportWeight(fraction));
+}
+
+void THISCLASS::Report(double weight) {
+	double concentration = (weight < 1 ? mState.mPreviousConcentration + (mState.mConcentration - mState.mPreviousConcentration) * weight : mState.mConcentration);
 
 	// Send this value to the controller (double) and log the same value
-	dWebotsSend(mWebotsInterface.mChannel, &mState.mConcentration, sizeof(mState.mConcentration));
-	mWebotsInterface.mLogFile << mState.mConcentration << std::endl;
+	mSimulation->mHost->Send(mWebotsInterface.mChannel, &concentration, sizeof(concentration));
+	mWebotsInterface.mLogFile << concentration << std::endl;
 }
 
 void THISCLASS::OnWebotsPhysicsDraw() {/*
@@ -70,6 +85,16 @@ void THISCLASS::OnWebotsPhysicsDraw() {/*
 	glEnable(GL_DEPTH_TEST);*/
 }
 
+void THISCLASS::Read(DataFileReader &f) {
+	mState.mConcentration = f.Double();
+	mState.mPreviousConcentration = f.Double();
+}
+
+void THISCLASS::Write(DataFileWriter &f) {
+	f.Double(mState.mConcentration);
+	f.Double(mState.mPreviousConcentration);
+}
+
 void THISCLASS::WriteConfiguration(std::ostream &out) {
 	out << "<SensorOdor>" << std::endl;
 	out << "\t<OdorType>" << mConfiguration.mOdorType << "</OdorType>" << std::endl;
@@ -9,7 +9,7 @@ class SensorOdor;
 #include "Sensor.h"
 #include "Point3.h"
 #include <fstream>
-#include <ode/ode.h>
+#include "SimulationHost.h"
 
 //! An odor sensor.
 //! \brief This class implements the sensor model presented in "Filament-based atmospheric dispersion model to achieve short time-scale structure of odor plumes" of Jay A. Farrell.
@@ -18,7 +18,7 @@ class SensorOdor: public Sensor {
 public:
 	//! Webots interface.
 	struct {
-		dGeomID mGeometryID;			//!< Geometry ID, which allows us to get the position.
+		SimulationHost::tObject mGeometryID;	//!< Host object (e.g. Webots geometry), which allows us to get the position.
 		int mChannel;					//!< Sender channel, which we will write the concentration value to.
 		std::ofstream mLogFile;			//!< File to which we will write all sensor values.
 	} mWebotsInterface;
@@ -27,14 +27,20 @@ public:
 	struct {
 		int mOdorType;					//!< Odor type.
 		double mNoiseStdDev;			//!< Standard deviation of the noise.
-		double mRunningAverageFactor;	//!< Factor for running average (over time, i.e. at each invocation of SimulationStep this factor is used).
+		double mRunningAverageFactor;	//!< Factor for running average (over time, i.e. this factor is used once per physics step).
 	} mConfiguration;
 
 	//! Sensor state.
 	struct {
 		double mConcentration;			//!< The measured concentration.
+		double mPreviousConcentration;	//!< The concentration measured at the previous odor update.
 	} mState;
 
+protected:
+	//! Sends a weighted average of the previous and the current concentration to the controller, and logs it.
+	void Report(double weight);
+
+public:
 	//! Constructor
 	SensorOdor(Simulation *sim);
 	//! Destructor
@@ -44,8 +50,11 @@ public:
 	void OnSimulationStart();
 	void OnSimulationEnd();
 	void OnSimulationStep();
+	void OnSimulationHold(double fraction);
 	void OnWebotsPhysicsDraw();
 	void WriteConfiguration(std::ostream &out);
+	void Read(DataFileReader &f);
+	void Write(DataFileWriter &f);
 };
 
 #endif
@@ -1,12 +1,12 @@
 // Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
 // Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
 
+#include <cmath>
 #include "SensorWind.h"
 #include "FilamentList.h"
 #include "Filament.h"
 #include "Random.h"
 #include "Constants.h"
-#include <plugins/physics.h>
 #define THISCLASS SensorWind
 
 THISCLASS::SensorWind(Simulation *sim):
@@ -17,6 +17,7 @@ THISCLASS::SensorWind(Simulation *sim):
 	mConfiguration.mNoiseStdDev = 0;
 	mConfiguration.mRunningAverageFactor = 0;
 	mState.mWind = Point3(0, 0, 0);
+	mState.mPreviousWind = Point3(0, 0, 0);
 }
 
 THISCLASS::~SensorWind() {
@@ -24,6 +25,7 @@ THISCLASS::~SensorWind() {
 
 void THISCLASS::OnSimulationStart() {
 	mState.mWind = Point3(0, 0, 0);
+	mState.mPreviousWind = Point3(0, 0, 0);
 }
 
 void THISCLASS::OnSimulationEnd() {
@@ -31,12 +33,11 @@ void THISCLASS::OnSimulationEnd() {
 
 void THISCLASS::OnSimulationStep() {
 	// Get the position of the sensor
-	const dReal *p = dGeomGetPosition(mWebotsInterface.mGeometryID);
-	const Point3 position(p[0], p[1], p[2]);
+	const Point3 position = mSimulation->mHost->GetPosition(mWebotsInterface.mGeometryID);
 
 	// Get the orientation of the sensor
-	dQuaternion orientation;
-	dGeomGetQuaternion(mWebotsInterface.mGeometryID, orientation);
+	double orientation[4];
+	mSimulation->mHost->GetOrientation(mWebotsInterface.mGeometryID, orientation);
 	orientation[1] = -orientation[1];
 	orientation[2] = -orientation[2];
 	orientation[3] = -orientation[3];
@@ -44,6 +45,9 @@ void THISCLASS::OnSimulationStep() {
 
 	// Get the raw concentration at the current point
 	Point3 wind = mSimulation->mWindField->GetWindSpeed(position);
+	if (wind == Point3(-100, -100, -100)) {
+		mSimulation->mCounters.Increment(SimulationCounters::sCounterWindMisses);
+	}
 	//std::cout << "Wind before: " << wind << std::endl;
 	qRotateVector(orientation, wind);
 	//std::cout << "Wind after: " << wind << std::endl;
@@ -52,18 +56,33 @@ void THISCLASS::OnSimulationStep() {
 
 	// Add noise
 	if (mConfiguration.mNoiseStdDev > 0) {
-		Random r;
+		Random &r = mSimulation->mRandom;
 		wind.x += r.Normal(0, mConfiguration.mNoiseStdDev);
 		wind.y += r.Normal(0, mConfiguration.mNoiseStdDev);
 		wind.z += r.Normal(0, mConfiguration.mNoiseStdDev);
 	}
 	//printf("wind2 %f %f %f\n", wind.x, wind.y, wind.z);
 	// Measured concentration is a running average
-	mState.mWind = mState.mWind * mConfiguration.mRunningAverageFactor + wind * (1 - mConfiguration.mRunningAverageFactor);
+	mState.mPreviousWind = mState.mWind;
+	// The factor is defined per physics step, and is applied n times if this odor update spans n physics steps (see Simulation::mOdorUpdatePeriod)
+	double physicsstep = ((mSimulation->mPhysicsTimeStep > 0) ? mSimulation->mPhysicsTimeStep : mSimulation->mSimulationTimeStep);
+	double n = ((physicsstep > 0) ? mSimulation->mSimulationTimeStep / physicsstep : 1);
+	double factor = pow(mConfiguration.mRunningAverageFactor, n);
+	mState.mWind = mState.mWind * factor + wind * (1 - factor);
 	//printf("wind3 %f %f %f\n", mState.mWind.x, mState.mWind.y, mState.mWind.z);
+	Report(GetReportWeight(0));
+}
+
+void THISCLASS::OnSimulationHold(double fraction) {
+	Report(GetReportWeight(fraction));
+}
+
+void THISCLASS::Report(double weight) {
+	Point3 wind = (weight < 1 ? mState.mPreviousWind + (mState.mWind - mState.mPreviousWind) * weight : mState.mWind);
+
 	// Send this value to the controller (double)
-	dWebotsSend(mWebotsInterface.mChannel, &mState.mWind, sizeof(mState.mWind));
-	mWebotsInterface.mLogFile << mState.mWind.x << "\t" << mState.mWind.y << "\t" << mState.mWind.z << std::endl;
+	mSimulation->mHost->Send(mWebotsInterface.mChannel, &wind, sizeof(wind));
+	mWebotsInterface.mLogFile << wind.x << "\t" << wind.y << "\t" << wind.z << std::endl;
 }
 
 void THISCLASS::OnWebotsPhysicsDraw() {/*
@@ -93,6 +112,16 @@ void THISCLASS::OnWebotsPhysicsDraw() {/*
 	glEnable(GL_DEPTH_TEST);*/
 }
 
+void THISCLASS::Read(DataFileReader &f) {
+	mState.mWind.Read(f);
+	mState.mPreviousWind.Read(f);
+}
+
+void THISCLASS::Write(DataFileWriter &f) {
+	mState.mWind.Write(f);
+	mState.mPreviousWind.Write(f);
+}
+
 void THISCLASS::WriteConfiguration(std::ostream &out) {
 	out << "<SensorWind>" << std::endl;
 	out << "\t<NoiseStdDev>" << mConfiguration.mNoiseStdDev << "</NoiseStdDev>" << std::endl;
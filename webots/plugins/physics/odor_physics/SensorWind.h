@@ -9,7 +9,7 @@ class SensorWind;
 #include "Sensor.h"
 #include "Point3.h"
 #include <fstream>
-#include <ode/ode.h>
+#include "SimulationHost.h"
 
 //! A wind sensor.
 class SensorWind: public Sensor {
@@ -17,7 +17,7 @@ class SensorWind: public Sensor {
 public:
 	//! Webots interface
 	struct {
-		dGeomID mGeometryID;			//!< Geometry ID, which allows us to get the position.
+		SimulationHost::tObject mGeometryID;	//!< Host object (e.g. Webots geometry), which allows us to get the position.
 		int mChannel;					//!< Sender channel, which we will write the concentration value to.
 		std::ofstream mLogFile;			//!< File to which we will write all sensor values.
 	} mWebotsInterface;
@@ -25,14 +25,20 @@ public:
 	//! Sensor configuration.
 	struct {
 		double mNoiseStdDev;			//!< Standard deviation of the noise.
-		double mRunningAverageFactor;	//!< Factor for running average (over time, i.e. at each invocation of SimulationStep this factor is used).
+		double mRunningAverageFactor;	//!< Factor for running average (over time, i.e. this factor is used once per physics step).
 	} mConfiguration;
 
 	//! Sensor state.
 	struct {
 		Point3 mWind;					//!< The measured wind.
+		Point3 mPreviousWind;			//!< The wind measured at the previous odor update.
 	} mState;
 
+protected:
+	//! Sends a weighted average of the previous and the current wind to the controller, and logs it.
+	void Report(double weight);
+
+public:
 	//! Constructor
 	SensorWind(Simulation *sim);
 	//! Destructor
@@ -42,11 +48,14 @@ public:
 	void OnSimulationStart();
 	void OnSimulationEnd();
 	void OnSimulationStep();
+	void OnSimulationHold(double fraction);
 	void OnWebotsPhysicsDraw();
 	void WriteConfiguration(std::ostream &out);
+	void Read(DataFileReader &f);
+	void Write(DataFileWriter &f);
 
 	// Rotate vector v by quaternion q
-	inline void qRotateVector(const dQuaternion q, Point3 &v) {
+	inline void qRotateVector(const double q[4], Point3 &v) {
 		double v1 = v.x;
 		double v2 = v.y;
 		double v3 = v.z;
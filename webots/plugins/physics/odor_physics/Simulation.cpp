@@ -1,15 +1,24 @@
 // Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
 // Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
 
+#include <iostream>
+#include <sstream>
+#include <typeinfo>
 #include "Simulation.h"
+#include "DataFileReader.h"
+#include "DataFileWriter.h"
 #define THISCLASS Simulation
 
 THISCLASS::Simulation():
-		SimulationInterface(this), mSimulationTimeStep(0), mSimulationTime(0), mResultsFolder(), mObstacleList(0), mWindField(0), mFilamentList(0), mFilamentPropagation(0), mOdorModel(0), mFilamentSourceList(0), mSensorList(0) {
+		SimulationInterface(this), mHost(0), mRandom(), mSharedEnvironment(false), mSimulationTimeStep(0), mPhysicsTimeStep(0), mSimulationTime(0), mOdorUpdatePeriod(0), mOdorUpdateTime(0), mSensorInterpolation(false), mResultsFolder(), mCounters(), mCounterInterval(0), mStepCount(0), mTiming(0), mObstacleList(0), mWindField(0), mFilamentList(0), mFilamentPropagation(0), mOdorModel(0), mFilamentSourceList(0), mSensorList(0) {
 
 }
 
 void THISCLASS::OnSimulationStart() {
+	if (! mHost) {
+		printf("No simulation host defined! We have to quit ...\n");
+		exit(1);
+	}
 	if (! mObstacleList) {
 		printf("No obstacle list defined! We have to quit ...\n");
 		exit(1);
@@ -39,8 +48,20 @@ void THISCLASS::OnSimulationStart() {
 		exit(1);
 	}
 
-	mObstacleList->OnSimulationStart();
-	mWindField->OnSimulationStart();
+	mOdorUpdateTime = mSimulationTime;
+	if (mTiming) {
+		mTiming->Reset();
+	}
+	mStepCount = 0;
+	mCounters.Reset();
+	if ((mCounterInterval > 0) && (! mCounters.OpenFile(mResultsFolder + "/counters.csv"))) {
+		AddError("Unable to create the counters file!");
+	}
+
+	if (! mSharedEnvironment) {
+		mObstacleList->OnSimulationStart();
+		mWindField->OnSimulationStart();
+	}
 	mFilamentList->OnSimulationStart();
 	mFilamentPropagation->OnSimulationStart();
 	mOdorModel->OnSimulationStart();
@@ -54,18 +75,72 @@ void THISCLASS::OnSimulationEnd() {
 	mOdorModel->OnSimulationEnd();
 	mFilamentPropagation->OnSimulationEnd();
 	mFilamentList->OnSimulationEnd();
-	mWindField->OnSimulationEnd();
-	mObstacleList->OnSimulationEnd();
+	if (! mSharedEnvironment) {
+		mWindField->OnSimulationEnd();
+		mObstacleList->OnSimulationEnd();
+	}
+
+	// Counters
+	if ((mCounterInterval > 0) && (mStepCount % mCounterInterval != 0)) {
+		mCounters.WriteLine(mStepCount, mSimulationTime);
+	}
+	mCounters.CloseFile();
+	if (! mSharedEnvironment) { // an ensemble writes one summary for all its simulations
+		mCounters.WriteSummary(std::cout);
+	}
+
+	// Timing
+	if (mTiming) {
+		if (! mTiming->WriteFile(mResultsFolder + "/timing.csv")) {
+			AddError("Unable to create the timing file!");
+		}
+		mTiming->WriteSummary(std::cout);
+	}
 }
 
 void THISCLASS::OnSimulationStep() {
-	mObstacleList->OnSimulationStep();
-	mWindField->OnSimulationStep();
-	mFilamentList->OnSimulationStep();
-	mFilamentPropagation->OnSimulationStep();
-	mOdorModel->OnSimulationStep();
-	mFilamentSourceList->OnSimulationStep();
-	mSensorList->OnSimulationStep();
+	// Between odor updates, the sensors only report their last values (the update happens at the physics step closest to the end of the period)
+	double physicsstep = mSimulationTimeStep;
+	mPhysicsTimeStep = physicsstep;
+	if (mOdorUpdatePeriod > 0) {
+		double elapsed = mSimulationTime - mOdorUpdateTime;
+		if (elapsed < mOdorUpdatePeriod - 0.5 * physicsstep) {
+			mSensorList->OnSimulationHold(elapsed / mOdorUpdatePeriod);
+			return;
+		}
+		mSimulationTimeStep = elapsed;
+	}
+	mOdorUpdateTime = mSimulationTime;
+
+	if (mTiming) {
+		// Same as below, but reading the clock after each subsystem
+		SimulationInterface *subsystems[] = {mObstacleList, mWindField, mFilamentList, mFilamentPropagation, mOdorModel, mFilamentSourceList, mSensorList};
+		double start = SimulationTiming::Now();
+		double last = start;
+		for (int i = (mSharedEnvironment ? SimulationTiming::sSectionFilamentList : 0); i < SimulationTiming::sSectionStep; i++) {
+			subsystems[i]->OnSimulationStep();
+			double now = SimulationTiming::Now();
+			mTiming->Add((SimulationTiming::eSection)i, now - last);
+			last = now;
+		}
+		mTiming->Add(SimulationTiming::sSectionStep, last - start);
+	} else {
+		if (! mSharedEnvironment) {
+			mObstacleList->OnSimulationStep();
+			mWindField->OnSimulationStep();
+		}
+		mFilamentList->OnSimulationStep();
+		mFilamentPropagation->OnSimulationStep();
+		mOdorModel->OnSimulationStep();
+		mFilamentSourceList->OnSimulationStep();
+		mSensorList->OnSimulationStep();
+	}
+	mSimulationTimeStep = physicsstep;
+
+	mStepCount++;
+	if ((mCounterInterval > 0) && (mStepCount % mCounterInterval == 0)) {
+		mCounters.WriteLine(mStepCount, mSimulationTime);
+	}
 }
 
 void THISCLASS::OnWebotsPhysicsDraw() {
@@ -78,9 +153,186 @@ void THISCLASS::OnWebotsPhysicsDraw() {
 	//mSensorList->OnWebotsPhysicsDraw();
 }
 
+bool THISCLASS::WriteCheckpoint(const std::string &filename) {
+	DataFileWriter f(filename);
+	if (f.Error()) {
+		AddError("Unable to write the checkpoint file " + filename + "!");
+		return false;
+	}
+	f.Int(mCheckpointVersion);
+	f.Int(mFilamentSourceList->GetCount());
+	f.Int(mSensorList->GetCount());
+	f.Int(mFilamentList->GetCount());
+
+	// The size of the state is written in front of it once it is known, so that a truncated file can be detected before reading
+	std::streampos sizepos = f.mFile.tellp();
+	f.Int(0);
+	std::streampos start = f.mFile.tellp();
+	Write(f);
+	std::streampos end = f.mFile.tellp();
+	f.mFile.seekp(sizepos);
+	f.Int((int)(end - start));
+	f.mFile.seekp(end);
+	if (f.mFile.fail()) {
+		AddError("Unable to write the checkpoint file " + filename + "!");
+		f.Close();
+		return false;
+	}
+	f.Close();
+	return true;
+}
+
+bool THISCLASS::ReadCheckpoint(const std::string &filename) {
+	if (mSharedEnvironment) {
+		AddError("Checkpoints cannot be read into a simulation with a shared environment!");
+		return false;
+	}
+	DataFileReader f(filename);
+	if (f.Error()) {
+		AddError("Unable to read the checkpoint file " + filename + "!");
+		return false;
+	}
+
+	// Check that the checkpoint was written by a simulation with the same sources, sensors and filaments
+	int version = f.Int();
+	int sources = f.Int();
+	int sensors = f.Int();
+	int filaments = f.Int();
+	if (version != mCheckpointVersion) {
+		AddError("The checkpoint file " + filename + " has an unknown version!");
+		return false;
+	}
+	if ((sources != mFilamentSourceList->GetCount()) || (sensors != mSensorList->GetCount()) || (filaments != mFilamentList->GetCount())) {
+		AddError("The checkpoint file " + filename + " does not match the sources, sensors and filaments of this simulation!");
+		return false;
+	}
+
+	// Check that the file is complete before anything is modified
+	int size = f.Int();
+	if (f.mFile.fail() || (size != f.Remaining())) {
+		AddError("The checkpoint file " + filename + " is truncated!");
+		return false;
+	}
+
+	Read(f);
+	if (f.Error()) {
+		AddError("The checkpoint file " + filename + " cannot be restored, the simulation was not modified!");
+		return false;
+	}
+	return true;
+}
+
+void THISCLASS::Read(DataFileReader &f) {
+	// Parse the state of the simulation itself
+	tCheckpointState state;
+	if (! ReadCheckpointState(f, state)) {
+		AddError("The state of the simulation is corrupt!");
+		f.mError = DataFileReader::ERROR_FORMAT;
+		return;
+	}
+
+	// Check the section of each object (type and size), and remember where it starts
+	std::vector<SimulationInterface*> objects;
+	GetCheckpointObjects(objects);
+	std::vector<std::streampos> sections(objects.size());
+	for (unsigned int i = 0; i < objects.size(); i++) {
+		std::string type = typeid(*objects[i]).name();
+		int length = f.Int();
+		std::string stored((length == (int)type.size() ? length : 0), ' ');
+		f.Read(&stored[0], stored.size());
+		int size = f.Int();
+		if (f.mFile.fail() || (stored != type) || (size < 0) || (size > f.Remaining())) {
+			AddError("The checkpoint does not match the wind field, sources and sensors of this simulation!");
+			f.mError = DataFileReader::ERROR_FORMAT;
+			return;
+		}
+		sections[i] = f.mFile.tellg();
+		f.mFile.seekg(size, std::ios::cur);
+	}
+	if (f.Remaining() != 0) {
+		AddError("The checkpoint has data after the last section!");
+		f.mError = DataFileReader::ERROR_FORMAT;
+		return;
+	}
+
+	// Restore the objects, starting with the wind field, which may still refuse the checkpoint time (the time is then reset, and nothing else has been modified)
+	double simulationtime = mSimulationTime;
+	mSimulationTime = state.simulationtime;
+	for (unsigned int i = 0; i < objects.size(); i++) {
+		f.mFile.seekg(sections[i]);
+		objects[i]->Read(f);
+		if (f.Error() || f.mFile.fail()) {
+			mSimulationTime = simulationtime;
+			f.mError = DataFileReader::ERROR_FORMAT;
+			return;
+		}
+	}
+	mOdorUpdateTime = state.odorupdatetime;
+	mStepCount = state.stepcount;
+	std::istringstream in(state.random);
+	mRandom.LoadState(in);
+}
+
+bool THISCLASS::ReadCheckpointState(DataFileReader &f, tCheckpointState &state) {
+	state.simulationtime = f.Double();
+	state.odorupdatetime = f.Double();
+	state.stepcount = f.Int();
+
+	// The random number state is stored as text (see Random::SaveState), and cannot be longer than the rest of the file
+	int length = f.Int();
+	if (f.mFile.fail() || (length < 0) || (length > f.Remaining())) {
+		return false;
+	}
+	state.random.assign(length, ' ');
+	f.Read(&state.random[0], length);
+	std::istringstream in(state.random);
+	return (! f.mFile.fail()) && Random::CheckState(in);
+}
+
+void THISCLASS::Write(DataFileWriter &f) {
+	f.Double(mSimulationTime);
+	f.Double(mOdorUpdateTime);
+	f.Int(mStepCount);
+
+	std::ostringstream out;
+	mRandom.SaveState(out);
+	std::string state = out.str();
+	f.Int((int)state.size());
+	f.Write(&state[0], state.size());
+
+	// Each object is written in a section with its type and size, so that a checkpoint of another simulation is refused before anything is restored
+	std::vector<SimulationInterface*> objects;
+	GetCheckpointObjects(objects);
+	for (unsigned int i = 0; i < objects.size(); i++) {
+		std::string type = typeid(*objects[i]).name();
+		f.Int((int)type.size());
+		f.Write(&type[0], type.size());
+		std::streampos sizepos = f.mFile.tellp();
+		f.Int(0);
+		std::streampos start = f.mFile.tellp();
+		objects[i]->Write(f);
+		std::streampos end = f.mFile.tellp();
+		f.mFile.seekp(sizepos);
+		f.Int((int)(end - start));
+		f.mFile.seekp(end);
+	}
+}
+
+void THISCLASS::GetCheckpointObjects(std::vector<SimulationInterface*> &objects) {
+	mWindField->GetCheckpointObjects(objects);
+	mFilamentList->GetCheckpointObjects(objects);
+	mFilamentSourceList->GetCheckpointObjects(objects);
+	mSensorList->GetCheckpointObjects(objects);
+}
+
 void THISCLASS::WriteConfiguration(std::ostream &out) {
 	out << "<SimulationTime>" << mSimulationTime << "</SimulationTime>" << std::endl;
 	out << "<SimulationTimeStep>" << mSimulationTimeStep << "</SimulationTimeStep>" << std::endl;
+	out << "<OdorUpdatePeriod>" << mOdorUpdatePeriod << "</OdorUpdatePeriod>" << std::endl;
+	out << "<SensorInterpolation>" << (mSensorInterpolation ? 1 : 0) << "</SensorInterpolation>" << std::endl;
+	out << "<CounterInterval>" << mCounterInterval << "</CounterInterval>" << std::endl;
+	out << "<Timing>" << (mTiming ? 1 : 0) << "</Timing>" << std::endl;
+	out << "<SharedEnvironment>" << (mSharedEnvironment ? 1 : 0) << "</SharedEnvironment>" << std::endl;
 
 	mObstacleList->WriteConfiguration(out);
 	mWindField->WriteConfiguration(out);
@@ -14,26 +14,47 @@ class Simulation;
 #include "OdorModel.h"
 #include "FilamentSourceList.h"
 #include "SensorList.h"
-#include <ode/ode.h>
+#include "SimulationCounters.h"
+#include "SimulationTiming.h"
+#include "SimulationHost.h"
+#include "Random.h"
 
 //! Simulation.
 class Simulation: public SimulationInterface {
 
 public:
-	//! Webots interface.
-	struct {
-		dWorldID mWorldID;
-		dSpaceID mSpaceID;
-	} mWebotsInterface;
+	//! The host (Webots or headless), which provides the positions of sources and sensors, and receives the sensor values.
+	SimulationHost *mHost;
+	//! The random numbers of this simulation (the shared stream, unless seeded with mRandom.Seed).
+	Random mRandom;
+	//! Whether the obstacle list and the wind field belong to another simulation, which updates them (see SimulationEnsemble). This simulation then only reads them, and does not start, step or end them.
+	bool mSharedEnvironment;
 
 	//! The time discretisation interval of the simulation.
 	double mSimulationTimeStep;
+	//! The physics step. This is the same as mSimulationTimeStep, except during odor updates with mOdorUpdatePeriod > 0 (0 if the subsystems are stepped directly, in which case mSimulationTimeStep is the physics step).
+	double mPhysicsTimeStep;
 	//! The current simulation time.
 	double mSimulationTime;
+	//! The period of the odor update (filament propagation, sources and sensor evaluation), or 0 to update at every physics step. During an odor update, mSimulationTimeStep is the time since the last odor update, and the filament random walk and growth are scaled to the number of physics steps in it (see FilamentPropagation), so the period does not change the plume spread.
+	double mOdorUpdatePeriod;
+	//! The simulation time of the last odor update.
+	double mOdorUpdateTime;
+	//! Whether the sensors interpolate between their last two values between odor updates (which delays them by one period), or hold their last value.
+	bool mSensorInterpolation;
 
 	//! The path to the results
 	std::string mResultsFolder;
 
+	//! Event counters.
+	SimulationCounters mCounters;
+	//! The counters are appended to counters.csv in the results folder every mCounterInterval odor updates (0 to disable the file).
+	int mCounterInterval;
+	//! The number of odor updates since the start of the simulation.
+	int mStepCount;
+	//! Wall time spent in each subsystem, or 0 to disable the timing. The statistics are written to timing.csv in the results folder when the simulation ends.
+	SimulationTiming *mTiming;
+
 	//! The list with obstacles.
 	ObstacleList *mObstacleList;
 	//! The wind field.
@@ -54,12 +75,33 @@ public:
 	//! Destructor.
 	~Simulation() {}
 
+	//! The version of the checkpoint format.
+	static const int mCheckpointVersion = 3;
+	//! Writes the state of the simulation (time, filaments, sources, sensors, wind field time and random numbers) to a checkpoint file. The event counters and the timing are not part of the checkpoint. Returns false if the file cannot be written.
+	bool WriteCheckpoint(const std::string &filename);
+	//! Restores the state of the simulation from a checkpoint file written with the same wind field type, sources and sensors. This must be called after OnSimulationStart, and the simulation then continues at the time of the checkpoint (i.e. the host must advance mSimulationTime from there). Returns false if the file cannot be read, does not match this simulation, is truncated, or lies outside the wind samples, in which case the simulation is not modified.
+	bool ReadCheckpoint(const std::string &filename);
+
 	// SimulationInterface methods
 	void OnSimulationStart();
 	void OnSimulationStep();
 	void OnSimulationEnd();
 	void OnWebotsPhysicsDraw();
 	void WriteConfiguration(std::ostream &out);
+	void Read(DataFileReader &f);
+	void Write(DataFileWriter &f);
+	void GetCheckpointObjects(std::vector<SimulationInterface*> &objects);
+
+protected:
+	//! The state of the simulation itself in a checkpoint (without the objects of GetCheckpointObjects).
+	struct tCheckpointState {
+		double simulationtime;		//!< See mSimulationTime.
+		double odorupdatetime;		//!< See mOdorUpdateTime.
+		int stepcount;				//!< See mStepCount.
+		std::string random;			//!< See Random::SaveState.
+	};
+	//! Reads the state of the simulation itself from a checkpoint, without modifying the simulation. Returns false if it is invalid.
+	bool ReadCheckpointState(DataFileReader &f, tCheckpointState &state);
 };
 
 #endif
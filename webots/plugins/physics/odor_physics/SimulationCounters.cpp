@@ -0,0 +1,79 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#include "SimulationCounters.h"
+#define THISCLASS SimulationCounters
+
+THISCLASS::SimulationCounters():
+		mFile() {
+
+	Reset();
+}
+
+void THISCLASS::Reset() {
+	for (int i = 0; i < sCounterCount; i++) {
+		mCount[i] = 0;
+	}
+}
+
+const char *THISCLASS::GetName(eCounter counter) {
+	switch (counter) {
+	case sCounterFilamentsReleased:
+		return "filaments_released";
+	case sCounterFilamentsOverwritten:
+		return "filaments_overwritten";
+	case sCounterOutOfDomain:
+		return "out_of_domain";
+	case sCounterOutsideArena:
+		return "outside_arena";
+	case sCounterObstacleHits:
+		return "obstacle_hits";
+	case sCounterObstacleReflections:
+		return "obstacle_reflections";
+	case sCounterWindMisses:
+		return "wind_misses";
+	case sCounterWindFilesRead:
+		return "wind_files_read";
+	default:
+		return "unknown";
+	}
+}
+
+bool THISCLASS::OpenFile(const std::string &filename) {
+	CloseFile();
+	mFile.open(filename.c_str());
+	if (! mFile.is_open()) {
+		return false;
+	}
+	mFile << "step,time";
+	for (int i = 0; i < sCounterCount; i++) {
+		mFile << "," << GetName((eCounter)i);
+	}
+	mFile << std::endl;
+	return true;
+}
+
+void THISCLASS::WriteLine(int step, double time) {
+	if (! mFile.is_open()) {
+		return;
+	}
+	mFile << step << "," << time;
+	for (int i = 0; i < sCounterCount; i++) {
+		mFile << "," << mCount[i];
+	}
+	mFile << "\n";
+}
+
+void THISCLASS::CloseFile() {
+	if (mFile.is_open()) {
+		mFile.close();
+	}
+}
+
+void THISCLASS::WriteSummary(std::ostream &out) const {
+	out << "<Counters>" << std::endl;
+	for (int i = 0; i < sCounterCount; i++) {
+		out << "\t<Counter name=\"" << GetName((eCounter)i) << "\">" << mCount[i] << "</Counter>" << std::endl;
+	}
+	out << "</Counters>" << std::endl;
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classSimulationCounters
+#define classSimulationCounters
+
+class SimulationCounters;
+
+#include <string>
+#include <ostream>
+#include <fstream>
+
+//!	Event counters of a simulation.
+/*!
+	The subsystems count noteworthy events (e.g. filaments stopped by an obstacle) with Increment, which is a single addition and can therefore be used in the propagation loop, where printing a message for each event would dominate the step.
+	The counts are cumulative. They can be appended as a line to a CSV file at regular intervals (see Simulation::mCounterInterval), and are written as a summary when the simulation ends.
+*/
+class SimulationCounters {
+
+public:
+	//! The counted events.
+	enum eCounter {
+		sCounterFilamentsReleased = 0,	//!< Filaments created by a source.
+		sCounterFilamentsOverwritten,	//!< Existing filaments that were replaced by a new filament because the filament list was full.
+		sCounterOutOfDomain,			//!< Filaments removed because they left the wind field.
+		sCounterOutsideArena,			//!< Filaments removed because they left the arena.
+		sCounterObstacleHits,			//!< Filament moves that were blocked by an obstacle.
+		sCounterObstacleReflections,	//!< Filament moves that were reflected off a surface by the distance field.
+		sCounterWindMisses,				//!< Wind lookups outside of the wind field (during substeps, at midpoints, and by sensors).
+		sCounterWindFilesRead,			//!< Wind snapshots read from a file.
+		sCounterCount					//!< Number of counters.
+	};
+
+protected:
+	//! The counts.
+	long long mCount[sCounterCount];
+	//! The CSV file.
+	std::ofstream mFile;
+
+public:
+	//! Constructor.
+	SimulationCounters();
+
+	//! Adds n events to a counter.
+	void Increment(eCounter counter, long long n = 1) {
+		mCount[counter] += n;
+	}
+	//! Returns the count of a counter.
+	long long Get(eCounter counter) const {
+		return mCount[counter];
+	}
+	//! Sets all counters to zero.
+	void Reset();
+	//! Returns the name of a counter (as used in the CSV header and the summary).
+	static const char *GetName(eCounter counter);
+
+	//! Creates a CSV file and writes its header. Returns false if the file could not be created.
+	bool OpenFile(const std::string &filename);
+	//! Appends the current counts to the CSV file (if open).
+	void WriteLine(int step, double time);
+	//! Closes the CSV file.
+	void CloseFile();
+	//! Writes the current counts.
+	void WriteSummary(std::ostream &out) const;
+};
+
+#endif
@@ -0,0 +1,157 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#include <iostream>
+#include <random>
+#include "SimulationEnsemble.h"
+#define THISCLASS SimulationEnsemble
+
+THISCLASS::SimulationEnsemble(Simulation *environment, int threads):
+		mEnvironment(environment), mRealizations(), mThreadCount(threads), mThreads(), mMutex(), mTaskReady(), mTaskDone(), mTask(sTaskStart), mGeneration(0), mBusy(0), mNext(0) {
+
+	if (mThreadCount <= 0) {
+		mThreadCount = std::thread::hardware_concurrency();
+		mThreadCount = (mThreadCount > 0 ? mThreadCount : 1);
+	}
+}
+
+THISCLASS::~SimulationEnsemble() {
+	if (! mThreads.empty()) {
+		RunAll(sTaskQuit);
+		for (unsigned int i = 0; i < mThreads.size(); i++) {
+			mThreads[i].join();
+		}
+	}
+}
+
+void THISCLASS::AddRealization(Simulation *sim) {
+	sim->mObstacleList = mEnvironment->mObstacleList;
+	sim->mWindField = mEnvironment->mWindField;
+	sim->mSharedEnvironment = true;
+	if (! sim->mRandom.IsSeeded()) {
+		sim->mRandom.Seed(std::random_device()());
+	}
+	mRealizations.push_back(sim);
+}
+
+void THISCLASS::Run(eTask task, Simulation *sim) {
+	switch (task) {
+	case sTaskStart:
+		sim->OnSimulationStart();
+		break;
+	case sTaskStep:
+		sim->OnSimulationStep();
+		break;
+	case sTaskEnd:
+		sim->OnSimulationEnd();
+		break;
+	case sTaskQuit:
+		break;
+	}
+}
+
+void THISCLASS::RunAll(eTask task) {
+	if (mThreads.empty()) {
+		for (unsigned int i = 0; i < mRealizations.size(); i++) {
+			Run(task, mRealizations[i]);
+		}
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mTask = task;
+	mNext = 0;
+	mBusy = mThreads.size();
+	mGeneration++;
+	mTaskReady.notify_all();
+	while (mBusy > 0) {
+		mTaskDone.wait(lock);
+	}
+}
+
+void THISCLASS::Worker() {
+	int generation = 0;
+	while (1) {
+		eTask task;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			while (mGeneration == generation) {
+				mTaskReady.wait(lock);
+			}
+			generation = mGeneration;
+			task = mTask;
+		}
+
+		if (task != sTaskQuit) {
+			int count = mRealizations.size();
+			for (int i = mNext++; i < count; i = mNext++) {
+				Run(task, mRealizations[i]);
+			}
+		}
+
+		std::unique_lock<std::mutex> lock(mMutex);
+		mBusy--;
+		if (mBusy == 0) {
+			mTaskDone.notify_one();
+		}
+		if (task == sTaskQuit) {
+			return;
+		}
+	}
+}
+
+void THISCLASS::OnSimulationStart() {
+	// The environment (this also builds the obstacle lookup structures, which are only read from now on)
+	mEnvironment->mObstacleList->OnSimulationStart();
+	mEnvironment->mWindField->OnSimulationStart();
+
+	// Start the workers (only if there is something to share)
+	int threads = (mThreadCount < (int)mRealizations.size() ? mThreadCount : mRealizations.size());
+	if ((threads > 1) && mThreads.empty()) {
+		for (int i = 0; i < threads; i++) {
+			mThreads.push_back(std::thread(&THISCLASS::Worker, this));
+		}
+	}
+
+	RunAll(sTaskStart);
+}
+
+void THISCLASS::OnSimulationStep(double time, double timestep) {
+	mEnvironment->mSimulationTime = time;
+	mEnvironment->mSimulationTimeStep = timestep;
+	mEnvironment->mObstacleList->OnSimulationStep();
+	mEnvironment->mWindField->OnSimulationStep();
+
+	for (unsigned int i = 0; i < mRealizations.size(); i++) {
+		mRealizations[i]->mSimulationTime = time;
+		mRealizations[i]->mSimulationTimeStep = timestep;
+	}
+	RunAll(sTaskStep);
+}
+
+void THISCLASS::OnSimulationEnd() {
+	RunAll(sTaskEnd);
+	mEnvironment->mWindField->OnSimulationEnd();
+	mEnvironment->mObstacleList->OnSimulationEnd();
+
+	// Sum of the counters (the environment counts the wind files read)
+	SimulationCounters counters;
+	for (int c = 0; c < SimulationCounters::sCounterCount; c++) {
+		SimulationCounters::eCounter counter = (SimulationCounters::eCounter)c;
+		counters.Increment(counter, mEnvironment->mCounters.Get(counter));
+		for (unsigned int i = 0; i < mRealizations.size(); i++) {
+			counters.Increment(counter, mRealizations[i]->mCounters.Get(counter));
+		}
+	}
+	counters.WriteSummary(std::cout);
+}
+
+void THISCLASS::WriteConfiguration(std::ostream &out) {
+	out << "<Ensemble>" << std::endl;
+	out << "\t<Realizations>" << mRealizations.size() << "</Realizations>" << std::endl;
+	out << "\t<Threads>" << mThreadCount << "</Threads>" << std::endl;
+	out << "</Ensemble>" << std::endl;
+	if (! mRealizations.empty()) {
+		mRealizations[0]->WriteConfiguration(out);
+	}
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classSimulationEnsemble
+#define classSimulationEnsemble
+
+class SimulationEnsemble;
+
+#include <vector>
+#include <ostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "Simulation.h"
+
+//!	Independent realizations of a plume, stepped in parallel.
+/*!
+	The environment simulation holds the obstacle list and the wind field, which are shared (read-only) by all realizations.
+	Each realization is a complete Simulation with its own filament list, propagation, sources, sensors, host and random number stream (see AddRealization).
+	At each step, the environment is updated first (on the calling thread), and the realizations are then stepped by a pool of worker threads.
+	Note that the environment is updated at every physics step, even if the realizations only update the plume every mOdorUpdatePeriod.
+
+	Usage:
+		Simulation environment;
+		new ObstacleList(&environment);
+		new WindFieldConstant(&environment);
+		SimulationEnsemble ensemble(&environment);
+		ensemble.AddRealization(sim);		// for each realization, with all other subsystems and mRandom.Seed(...)
+		ensemble.OnSimulationStart();
+		ensemble.OnSimulationStep(time, timestep);		// for each step
+		ensemble.OnSimulationEnd();
+*/
+class SimulationEnsemble {
+
+protected:
+	//! The tasks run by the workers.
+	enum eTask {
+		sTaskStart,		//!< OnSimulationStart of each realization.
+		sTaskStep,		//!< OnSimulationStep of each realization.
+		sTaskEnd,		//!< OnSimulationEnd of each realization.
+		sTaskQuit,		//!< Terminates the workers.
+	};
+
+	//! The simulation holding the shared obstacle list and wind field.
+	Simulation *mEnvironment;
+	//! The realizations.
+	std::vector<Simulation*> mRealizations;
+	//! The number of threads stepping the realizations (1 to step them on the calling thread).
+	int mThreadCount;
+	//! The worker threads (started with the simulation).
+	std::vector<std::thread> mThreads;
+
+	//! Protects the fields below.
+	std::mutex mMutex;
+	//! Signals a new task to the workers.
+	std::condition_variable mTaskReady;
+	//! Signals the end of a task to the calling thread.
+	std::condition_variable mTaskDone;
+	//! The current task.
+	eTask mTask;
+	//! Incremented with each task, such that the workers can tell a new task from the previous one.
+	int mGeneration;
+	//! Number of workers that have not finished the current task.
+	int mBusy;
+	//! The next realization to process (taken by the workers in turn).
+	std::atomic<int> mNext;
+
+	//! Runs a task on a realization.
+	void Run(eTask task, Simulation *sim);
+	//! Runs a task on all realizations, and returns when all are done.
+	void RunAll(eTask task);
+	//! Main loop of a worker thread.
+	void Worker();
+
+public:
+	//! Constructor. With threads = 0, one thread per core is used.
+	SimulationEnsemble(Simulation *environment, int threads = 0);
+	//! Destructor. The realizations are not deleted.
+	~SimulationEnsemble();
+
+	//! Adds a realization, and makes it use the obstacle list and the wind field of the environment. A realization that was not seeded gets a random seed, since the shared random number stream must not be used from several threads.
+	void AddRealization(Simulation *sim);
+	//! Returns the number of realizations.
+	int GetCount() const {
+		return mRealizations.size();
+	}
+	//! Returns a realization.
+	Simulation *Get(int i) const {
+		return mRealizations[i];
+	}
+	//! Returns the number of threads.
+	int GetThreadCount() const {
+		return mThreadCount;
+	}
+
+	//! Starts the environment and all realizations.
+	void OnSimulationStart();
+	//! Advances the environment and all realizations to the given time.
+	void OnSimulationStep(double time, double timestep);
+	//! Ends all realizations and the environment, and writes the sum of their counters to std::cout.
+	void OnSimulationEnd();
+	//! Writes the configuration of the environment and of the first realization.
+	void WriteConfiguration(std::ostream &out);
+};
+
+#endif
@@ -0,0 +1,33 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classSimulationHost
+#define classSimulationHost
+
+class SimulationHost;
+
+#include "Point3.h"
+
+//!	The environment in which a simulation runs.
+/*!
+	Sources and sensors are attached to objects of the host (e.g. Webots geometries), whose position and orientation they read at each step, and sensors send their values to channels of the host.
+	All access to the physics engine goes through this interface, such that the simulation core can run inside Webots (SimulationHostWebots) or without it (SimulationHostHeadless).
+*/
+class SimulationHost {
+
+public:
+	//! An object of the host (e.g. a dGeomID).
+	typedef void *tObject;
+
+	//! Destructor.
+	virtual ~SimulationHost() {}
+
+	//! Returns the position of an object.
+	virtual Point3 GetPosition(tObject object) = 0;
+	//! Returns the orientation of an object as a quaternion (w, x, y, z).
+	virtual void GetOrientation(tObject object, double q[4]) = 0;
+	//! Sends data to a channel.
+	virtual void Send(int channel, const void *data, int size) = 0;
+};
+
+#endif
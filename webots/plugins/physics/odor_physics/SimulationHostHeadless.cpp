@@ -0,0 +1,33 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#include "SimulationHostHeadless.h"
+#define THISCLASS SimulationHostHeadless
+
+SimulationHost::tObject THISCLASS::AddObject(const Point3 &position) {
+	mObjects.push_back(position);
+	return &mObjects.back();
+}
+
+const void *THISCLASS::GetData(int channel, int &size) const {
+	std::map<int, std::vector<char> >::const_iterator it = mChannels.find(channel);
+	if ((it == mChannels.end()) || it->second.empty()) {
+		size = 0;
+		return 0;
+	}
+	size = it->second.size();
+	return &(it->second[0]);
+}
+
+void THISCLASS::GetOrientation(tObject /*object*/, double q[4]) {
+	q[0] = 1;
+	q[1] = 0;
+	q[2] = 0;
+	q[3] = 0;
+}
+
+void THISCLASS::Send(int channel, const void *data, int size) {
+	std::vector<char> &buffer = mChannels[channel];
+	buffer.assign((const char *)data, (const char *)data + size);
+	mSendCount++;
+}
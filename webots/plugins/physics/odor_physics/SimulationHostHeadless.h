@@ -0,0 +1,54 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classSimulationHostHeadless
+#define classSimulationHostHeadless
+
+class SimulationHostHeadless;
+
+#include <deque>
+#include <map>
+#include <vector>
+#include "SimulationHost.h"
+
+//!	Runs the simulation without Webots (e.g. in command line tools).
+/*!
+	Objects are created with AddObject, and stay where they are placed (with the identity orientation) unless moved with SetPosition.
+	Data sent to a channel is kept until the next Send on that channel, and can be read with GetData (e.g. to print the final sensor values).
+*/
+class SimulationHostHeadless: public SimulationHost {
+
+protected:
+	//! Positions of the objects (a deque, such that the objects do not move in memory when new ones are added).
+	std::deque<Point3> mObjects;
+	//! The last data sent to each channel.
+	std::map<int, std::vector<char> > mChannels;
+	//! Number of Send calls.
+	long long mSendCount;
+
+public:
+	//! Constructor.
+	SimulationHostHeadless(): mObjects(), mChannels(), mSendCount(0) {}
+
+	//! Adds an object at a position, and returns it.
+	tObject AddObject(const Point3 &position);
+	//! Moves an object.
+	void SetPosition(tObject object, const Point3 &position) {
+		*(Point3 *)object = position;
+	}
+	//! Returns the last data sent to a channel (or 0 if nothing was sent), and its size.
+	const void *GetData(int channel, int &size) const;
+	//! Returns the number of Send calls.
+	long long GetSendCount() const {
+		return mSendCount;
+	}
+
+	// SimulationHost methods
+	Point3 GetPosition(tObject object) {
+		return *(const Point3 *)object;
+	}
+	void GetOrientation(tObject object, double q[4]);
+	void Send(int channel, const void *data, int size);
+};
+
+#endif
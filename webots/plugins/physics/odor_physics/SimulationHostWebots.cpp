@@ -0,0 +1,24 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#include <ode/ode.h>
+#include <plugins/physics.h>
+#include "SimulationHostWebots.h"
+#define THISCLASS SimulationHostWebots
+
+Point3 THISCLASS::GetPosition(tObject object) {
+	const dReal *p = dGeomGetPosition((dGeomID)object);
+	return Point3(p[0], p[1], p[2]);
+}
+
+void THISCLASS::GetOrientation(tObject object, double q[4]) {
+	dQuaternion orientation;
+	dGeomGetQuaternion((dGeomID)object, orientation);
+	for (int i = 0; i < 4; i++) {
+		q[i] = orientation[i];
+	}
+}
+
+void THISCLASS::Send(int channel, const void *data, int size) {
+	dWebotsSend(channel, data, size);
+}
@@ -0,0 +1,24 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classSimulationHostWebots
+#define classSimulationHostWebots
+
+class SimulationHostWebots;
+
+#include "SimulationHost.h"
+
+//! Runs the simulation inside a Webots physics plugin. Objects are ODE geometries (dGeomID), and data is sent with dWebotsSend.
+class SimulationHostWebots: public SimulationHost {
+
+public:
+	//! Constructor.
+	SimulationHostWebots() {}
+
+	// SimulationHost methods
+	Point3 GetPosition(tObject object);
+	void GetOrientation(tObject object, double q[4]);
+	void Send(int channel, const void *data, int size);
+};
+
+#endif
@@ -6,9 +6,12 @@
 
 #include <string>
 #include <ostream>
+#include <vector>
 
 class SimulationInterface;
 class Simulation;
+class DataFileReader;
+class DataFileWriter;
 
 //! Simulation interface.
 class SimulationInterface {
@@ -33,6 +36,14 @@ public:
 	virtual void OnWebotsPhysicsDraw() = 0;
 	//! Writes the properties of this object.
 	virtual void WriteConfiguration(std::ostream &out) = 0;
+	//! Reads the state of this object from a checkpoint (see Simulation::ReadCheckpoint). Objects without state that evolves over time do not need to implement this.
+	virtual void Read(DataFileReader &/*f*/) {}
+	//! Writes the state of this object to a checkpoint (see Simulation::WriteCheckpoint).
+	virtual void Write(DataFileWriter &/*f*/) {}
+	//! Adds the objects whose state is stored in a checkpoint, each in its own section tagged with its type. This is the object itself by default, and the elements for lists.
+	virtual void GetCheckpointObjects(std::vector<SimulationInterface*> &objects) {
+		objects.push_back(this);
+	}
 
 	//! Adds an error to the list of errors (at the moment, this just prints the error message).
 	void AddError(const std::string &msg);
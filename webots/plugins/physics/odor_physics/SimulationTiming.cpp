@@ -0,0 +1,110 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#include <cmath>
+#include <fstream>
+#include <time.h>
+#include "SimulationTiming.h"
+#define THISCLASS SimulationTiming
+
+THISCLASS::SimulationTiming() {
+	Reset();
+}
+
+double THISCLASS::Now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+double THISCLASS::BinEdge(int bin) {
+	return 1e-7 * pow(2., (double)(bin + 1) / mBinsPerOctave);
+}
+
+void THISCLASS::Reset() {
+	for (int s = 0; s < sSectionCount; s++) {
+		for (int i = 0; i < mBinCount; i++) {
+			mHistogram[s][i] = 0;
+		}
+		mCount[s] = 0;
+		mSum[s] = 0;
+		mMax[s] = 0;
+	}
+}
+
+void THISCLASS::Add(eSection section, double duration) {
+	int bin = 0;
+	if (duration > 1e-7) {
+		bin = (int)(mBinsPerOctave * log2(duration * 1e7));
+		bin = (bin >= mBinCount ? mBinCount - 1 : bin);
+	}
+	mHistogram[section][bin]++;
+	mCount[section]++;
+	mSum[section] += duration;
+	mMax[section] = (duration > mMax[section] ? duration : mMax[section]);
+}
+
+const char *THISCLASS::GetName(eSection section) {
+	switch (section) {
+	case sSectionObstacleList:
+		return "ObstacleList";
+	case sSectionWindField:
+		return "WindField";
+	case sSectionFilamentList:
+		return "FilamentList";
+	case sSectionFilamentPropagation:
+		return "FilamentPropagation";
+	case sSectionOdorModel:
+		return "OdorModel";
+	case sSectionFilamentSourceList:
+		return "FilamentSourceList";
+	case sSectionSensorList:
+		return "SensorList";
+	case sSectionStep:
+		return "Step";
+	default:
+		return "Unknown";
+	}
+}
+
+double THISCLASS::GetPercentile(eSection section, double p) const {
+	if (mCount[section] < 1) {
+		return 0;
+	}
+
+	// Interpolate within the bin in which the cumulative count reaches p (but never return more than the maximum)
+	double target = p * mCount[section];
+	long long cumulative = 0;
+	for (int i = 0; i < mBinCount; i++) {
+		int n = mHistogram[section][i];
+		if ((n > 0) && (cumulative + n >= target)) {
+			double lower = (i > 0 ? BinEdge(i - 1) : 0);
+			double value = lower + (BinEdge(i) - lower) * (target - cumulative) / n;
+			return (value < mMax[section] ? value : mMax[section]);
+		}
+		cumulative += n;
+	}
+	return mMax[section];
+}
+
+bool THISCLASS::WriteFile(const std::string &filename) const {
+	std::ofstream file(filename.c_str());
+	if (! file.is_open()) {
+		return false;
+	}
+	file << "section,count,mean,p50,p95,max" << std::endl;
+	for (int s = 0; s < sSectionCount; s++) {
+		eSection section = (eSection)s;
+		file << GetName(section) << "," << mCount[s] << "," << (mCount[s] > 0 ? mSum[s] / mCount[s] : 0) << "," << GetPercentile(section, 0.5) << "," << GetPercentile(section, 0.95) << "," << mMax[s] << std::endl;
+	}
+	return true;
+}
+
+void THISCLASS::WriteSummary(std::ostream &out) const {
+	out << "<Timing unit=\"s\">" << std::endl;
+	for (int s = 0; s < sSectionCount; s++) {
+		eSection section = (eSection)s;
+		out << "\t<" << GetName(section) << " count=\"" << mCount[s] << "\" mean=\"" << (mCount[s] > 0 ? mSum[s] / mCount[s] : 0) << "\" p50=\"" << GetPercentile(section, 0.5) << "\" p95=\"" << GetPercentile(section, 0.95) << "\" max=\"" << mMax[s] << "\" />" << std::endl;
+	}
+	out << "</Timing>" << std::endl;
+}
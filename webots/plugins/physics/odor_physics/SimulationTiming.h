@@ -0,0 +1,74 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classSimulationTiming
+#define classSimulationTiming
+
+class SimulationTiming;
+
+#include <string>
+#include <ostream>
+
+//!	Wall time spent in each subsystem per odor update.
+/*!
+	Each duration is sorted into a fixed-size histogram with logarithmic bins (8 bins per factor of 2, from 0.1 us to about 7 minutes), such that the memory and the cost per step do not depend on the length of the run.
+	Percentiles are interpolated within a bin, and are therefore accurate to a few percent, while the maximum and the mean are exact.
+	The timing is only active if Simulation::mTiming is set. Otherwise, Simulation::OnSimulationStep does not read the clock at all.
+*/
+class SimulationTiming {
+
+public:
+	//! The timed sections (the subsystems in the order in which they are stepped, and the whole odor update).
+	enum eSection {
+		sSectionObstacleList = 0,
+		sSectionWindField,
+		sSectionFilamentList,
+		sSectionFilamentPropagation,
+		sSectionOdorModel,
+		sSectionFilamentSourceList,
+		sSectionSensorList,
+		sSectionStep,
+		sSectionCount
+	};
+
+protected:
+	//! Number of histogram bins.
+	static const int mBinCount = 256;
+	//! Number of bins per factor of 2.
+	static const int mBinsPerOctave = 8;
+
+	//! Histogram of each section.
+	int mHistogram[sSectionCount][mBinCount];
+	//! Number of durations of each section.
+	long long mCount[sSectionCount];
+	//! Sum of the durations of each section [s].
+	double mSum[sSectionCount];
+	//! Longest duration of each section [s].
+	double mMax[sSectionCount];
+
+	//! Returns the upper edge of a bin [s].
+	static double BinEdge(int bin);
+
+public:
+	//! Constructor.
+	SimulationTiming();
+
+	//! Returns the current wall time [s].
+	static double Now();
+	//! Adds a duration [s] to a section.
+	void Add(eSection section, double duration);
+	//! Removes all durations.
+	void Reset();
+
+	//! Returns the name of a section.
+	static const char *GetName(eSection section);
+	//! Returns the duration below which a fraction p of the durations of a section lie (approximately, see above).
+	double GetPercentile(eSection section, double p) const;
+
+	//! Writes count, mean, p50, p95 and max of each section to a CSV file. Returns false if the file could not be created.
+	bool WriteFile(const std::string &filename) const;
+	//! Writes the same statistics as XML.
+	void WriteSummary(std::ostream &out) const;
+};
+
+#endif
@@ -7,6 +7,7 @@
 #include <sstream>
 #include <fstream>
 #include <string>
+#include <stdlib.h>
 
 THISCLASS::TextFileReaderOpenFOAMSamples(const std::string &filename):
 		TextFileReader(filename) {
@@ -29,6 +30,8 @@ void THISCLASS::Read(WindFieldSnapshot *wfs) {
 			// the ')' at the begining of the line means the end of the file
 			if (line[0]==')')
 				break;
+			if (counter >= wfs->GetCellCount())
+				break;
 			
 			// the '(' at the begining of the line doesnt let to extract the double form string
 			if (line[0]=='(')
@@ -58,3 +61,15 @@ void THISCLASS::Read(WindFieldSnapshot *wfs) {
     
 //std::cout << "TextFileReaderOpenFOAMSamples Read end" << std::endl;
 }
+
+int THISCLASS::VectorCount(const std::string &filename) {
+	std::ifstream in(filename.c_str());
+	std::string line, prevLine;
+	while (std::getline(in, line)) {
+		if (line[0] == '(') {
+			return atoi(prevLine.c_str());
+		}
+		prevLine = line;
+	}
+	return -1;
+}
@@ -21,6 +21,9 @@ public:
 
 	// Read methods
 	void Read(WindFieldSnapshot *wfs);
+
+	//! Returns the number of vectors in a samples file (the number on the line before the opening parenthesis), or -1 if the file cannot be read.
+	static int VectorCount(const std::string &filename);
 	
 };
 
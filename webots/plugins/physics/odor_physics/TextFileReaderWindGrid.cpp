@@ -0,0 +1,150 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#include "TextFileReaderWindGrid.h"
+#define THISCLASS TextFileReaderWindGrid
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <iterator>
+
+THISCLASS::TextFileReaderWindGrid(const std::string &filename):
+		TextFileReader(filename) {
+
+}
+
+// Skips white space and comments (from '#' to the end of the line).
+static const char *SkipSpace(const char *p) {
+	while (*p) {
+		if (isspace(*p)) {
+			p++;
+		} else if (*p == '#') {
+			while (*p && (*p != '\n')) {
+				p++;
+			}
+		} else {
+			break;
+		}
+	}
+	return p;
+}
+
+// Reads n doubles. Returns false if a value is missing.
+static bool ReadDoubles(const char *&p, double *values, int n) {
+	for (int i = 0; i < n; i++) {
+		p = SkipSpace(p);
+		char *end;
+		values[i] = strtod(p, &end);
+		if (end == p) {
+			return false;
+		}
+		p = end;
+	}
+	return true;
+}
+
+bool THISCLASS::Read(WindFieldSnapshot *wfs) {
+	if (! mFile.is_open()) {
+		std::cout << "unable to open the file " << std::endl;
+		return false;
+	}
+
+	// Read the whole file at once, and parse it in memory
+	std::string buffer((std::istreambuf_iterator<char>(mFile)), std::istreambuf_iterator<char>());
+	const char *p = SkipSpace(buffer.c_str());
+
+	double origin[3] = {0, 0, 0};
+	double spacing[3] = {0, 0, 0};
+	double dims[3] = {0, 0, 0};
+	bool order_yxz = false;
+	WindFieldSnapshot::eInterpolation interpolation = wfs->GetInterpolation();
+
+	if (isdigit(*p)) {
+		// Legacy format: number of grid points, followed by the data (grid of the original arena, cell-centred)
+		double size;
+		ReadDoubles(p, &size, 1);
+		dims[0] = 100;
+		dims[1] = 64;
+		dims[2] = 19;
+		spacing[0] = 0.1586;
+		spacing[1] = 0.0632;
+		spacing[2] = 0.095;
+		for (int i = 0; i < 3; i++) {
+			origin[i] = spacing[i] / 2;
+		}
+		order_yxz = true;
+		if ((int)size != (int)(dims[0] * dims[1] * dims[2])) {
+			std::cout << "Legacy wind map with " << (int)size << " grid points does not match the arena grid" << std::endl;
+			return false;
+		}
+	} else {
+		// Header
+		while (*p) {
+			const char *start = p;
+			while (*p && ! isspace(*p)) {
+				p++;
+			}
+			std::string key(start, p - start);
+			bool ok = true;
+			if (key == "data") {
+				break;
+			} else if (key == "origin") {
+				ok = ReadDoubles(p, origin, 3);
+			} else if (key == "spacing") {
+				ok = ReadDoubles(p, spacing, 3);
+			} else if (key == "dims") {
+				ok = ReadDoubles(p, dims, 3);
+			} else if ((key == "order") || (key == "interpolation")) {
+				p = SkipSpace(p);
+				start = p;
+				while (*p && ! isspace(*p)) {
+					p++;
+				}
+				std::string value(start, p - start);
+				if (key == "order") {
+					order_yxz = (value == "yxz");
+					ok = order_yxz || (value == "xyz");
+				} else {
+					interpolation = (value == "trilinear") ? WindFieldSnapshot::sInterpolationTrilinear : WindFieldSnapshot::sInterpolationNearest;
+					ok = (value == "trilinear") || (value == "nearest");
+				}
+			} else {
+				ok = false;
+			}
+			if (! ok) {
+				std::cout << "Invalid wind map header entry: " << key << std::endl;
+				return false;
+			}
+			p = SkipSpace(p);
+		}
+		if ((dims[0] < 1) || (dims[1] < 1) || (dims[2] < 1) || (spacing[0] <= 0) || (spacing[1] <= 0) || (spacing[2] <= 0)) {
+			std::cout << "Wind map header must declare positive dims and spacing" << std::endl;
+			return false;
+		}
+	}
+
+	// Allocate the grid
+	Point3Int arraysize((int)dims[0], (int)dims[1], (int)dims[2]);
+	wfs->AllocateRegularGrid(Point3(origin[0], origin[1], origin[2]), Point3(spacing[0], spacing[1], spacing[2]), arraysize);
+	wfs->SetInterpolation(interpolation);
+
+	// Read the data
+	int count = arraysize.Volume();
+	int nxy = arraysize.x * arraysize.y;
+	double w[3];
+	for (int k = 0; k < count; k++) {
+		if (! ReadDoubles(p, w, 3)) {
+			std::cout << "Number of elements in wind map incorrect: " << k << " instead of " << count << std::endl;
+			return false;
+		}
+		int i = k;
+		if (order_yxz) {
+			i = (k / arraysize.y) % arraysize.x + arraysize.x * (k % arraysize.y) + nxy * (k / nxy);
+		}
+		wfs->SetCellWindSpeed(i, Point3(w[0], w[1], w[2]));
+	}
+
+	wfs->ResampleGrid();
+	return true;
+}
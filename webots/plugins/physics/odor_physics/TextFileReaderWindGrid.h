@@ -0,0 +1,42 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classTextFileReaderWindGrid
+#define classTextFileReaderWindGrid
+
+class TextFileReaderWindGrid;
+
+#include <string>
+#include "TextFileReader.h"
+#include "WindFieldSnapshot.h"
+
+//!	Reads a wind field defined on a regular grid from a text file.
+/*!
+	The file starts with a header declaring the grid, followed by one wind vector per grid point (x varies fastest, then y, then z):
+
+	\code
+	# comment
+	origin 0.0793 0.0316 0.0475
+	spacing 0.1586 0.0632 0.095
+	dims 100 64 19
+	order xyz
+	interpolation trilinear
+	data
+	vx vy vz
+	...
+	\endcode
+
+	The keywords "order" (xyz or yxz) and "interpolation" (nearest or trilinear) are optional.
+	Files in the legacy format (number of grid points on the first line, followed by the wind vectors in yxz order) are read with the grid of the original arena.
+*/
+class TextFileReaderWindGrid: public TextFileReader {
+
+public:
+	// Constructor
+	TextFileReaderWindGrid(const std::string &filename);
+
+	// Read methods
+	bool Read(WindFieldSnapshot *wfs);
+};
+
+#endif
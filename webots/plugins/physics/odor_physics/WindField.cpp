@@ -14,3 +14,9 @@ THISCLASS::~WindField() {
 		mSimulation->mWindField = 0;
 	}
 }
+
+void THISCLASS::GetWindSpeeds(const Point3 *in, Point3 *out, int n) {
+	for (int i = 0; i < n; i++) {
+		out[i] = GetWindSpeed(in[i]);
+	}
+}
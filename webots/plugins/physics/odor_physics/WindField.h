@@ -21,6 +21,12 @@ public:
 
 	//! Returns the wind speed at a specific point.
 	virtual Point3 GetWindSpeed(const Point3 &preal) = 0;
+	//! Returns the wind speed at n points (out[i] is the wind speed at in[i]). Subclasses should override this with a tight loop, as this is called once per simulation step for all filaments.
+	virtual void GetWindSpeeds(const Point3 *in, Point3 *out, int n);
+	//! Returns the smallest distance on which the wind speed varies (e.g. the grid spacing), or 0 if the wind speed is uniform. FilamentPropagation uses this to limit the distance a filament moves per substep.
+	virtual double GetResolution() {
+		return 0;
+	}
 };
 
 #endif
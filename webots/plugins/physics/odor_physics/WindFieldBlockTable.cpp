@@ -0,0 +1,116 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#include <string.h>
+#include "WindFieldBlockTable.h"
+#define	THISCLASS WindFieldBlockTable
+
+// Number of blocks needed to cover n grid points with blocks of edge intervals.
+static int BlockCount(int n, int edge) {
+	return edge ? (n - 1 + edge - 1) / edge : 1;
+}
+
+void THISCLASS::Build(const Point3 &origin, const Point3 &gridsize, const Point3Int &arraysize, int blocksize, const std::vector<Cube> &regions, double margin) {
+	mArraySize = arraysize;
+	mBlockSize = (blocksize > 0 ? blocksize : 1);
+	mEdge = Point3Int(arraysize.x > 1 ? mBlockSize : 0, arraysize.y > 1 ? mBlockSize : 0, arraysize.z > 1 ? mBlockSize : 0);
+	mBlockCount = Point3Int(BlockCount(arraysize.x, mEdge.x), BlockCount(arraysize.y, mEdge.y), BlockCount(arraysize.z, mEdge.z));
+	mCornerCount = Point3Int(mEdge.x ? mBlockCount.x + 1 : 1, mEdge.y ? mBlockCount.y + 1 : 1, mEdge.z ? mBlockCount.z + 1 : 1);
+
+	// The coarse grid comes first
+	mSampleCount = mCornerCount.Volume();
+	int blocksamples = (mEdge.x + 1) * (mEdge.y + 1) * (mEdge.z + 1);
+
+	// Refine all blocks whose extent (including the boundary grid points) intersects a region grown by the margin
+	mTable.assign(mBlockCount.Volume(), -1);
+	mFineCount = 0;
+	int i = 0;
+	for (int bz = 0; bz < mBlockCount.z; bz++) {
+		for (int by = 0; by < mBlockCount.y; by++) {
+			for (int bx = 0; bx < mBlockCount.x; bx++) {
+				Point3 a = origin + gridsize.DotMultiply(bx * mEdge.x, by * mEdge.y, bz * mEdge.z) - Point3(margin, margin, margin);
+				Point3 b = a + gridsize.DotMultiply(mEdge.x, mEdge.y, mEdge.z) + Point3(2 * margin, 2 * margin, 2 * margin);
+				for (unsigned int r = 0; r < regions.size(); r++) {
+					const Cube &c = regions[r];
+					if ((a.x <= c.b.x) && (b.x >= c.a.x) && (a.y <= c.b.y) && (b.y >= c.a.y) && (a.z <= c.b.z) && (b.z >= c.a.z)) {
+						mTable[i] = mSampleCount;
+						mSampleCount += blocksamples;
+						mFineCount++;
+						break;
+					}
+				}
+				i++;
+			}
+		}
+	}
+}
+
+// Clamps a grid index to [0, n - 1].
+static inline int ClampGridIndex(int i, int n) {
+	return (i < n) ? i : n - 1;
+}
+
+void THISCLASS::GetSamplePoints(std::vector<Point3Int> &points) const {
+	points.resize(mSampleCount);
+
+	// Coarse grid
+	int s = 0;
+	for (int iz = 0; iz < mCornerCount.z; iz++) {
+		for (int iy = 0; iy < mCornerCount.y; iy++) {
+			for (int ix = 0; ix < mCornerCount.x; ix++) {
+				points[s++] = Point3Int(ClampGridIndex(ix * mEdge.x, mArraySize.x), ClampGridIndex(iy * mEdge.y, mArraySize.y), ClampGridIndex(iz * mEdge.z, mArraySize.z));
+			}
+		}
+	}
+
+	// Fine blocks (grid points beyond the end of the grid are clamped to the last grid point)
+	int i = 0;
+	for (int bz = 0; bz < mBlockCount.z; bz++) {
+		for (int by = 0; by < mBlockCount.y; by++) {
+			for (int bx = 0; bx < mBlockCount.x; bx++) {
+				s = mTable[i++];
+				if (s < 0) {
+					continue;
+				}
+				for (int iz = 0; iz <= mEdge.z; iz++) {
+					for (int iy = 0; iy <= mEdge.y; iy++) {
+						for (int ix = 0; ix <= mEdge.x; ix++) {
+							points[s++] = Point3Int(ClampGridIndex(bx * mEdge.x + ix, mArraySize.x), ClampGridIndex(by * mEdge.y + iy, mArraySize.y), ClampGridIndex(bz * mEdge.z + iz, mArraySize.z));
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+size_t THISCLASS::GetSharedSize() const {
+	size_t size = sizeof(tShared) + sizeof(int) * mTable.size();
+	return (size + 7) & ~(size_t)7;
+}
+
+void THISCLASS::WriteShared(void *dst) const {
+	tShared *header = (tShared*)dst;
+	header->arraysize[0] = mArraySize.x;
+	header->arraysize[1] = mArraySize.y;
+	header->arraysize[2] = mArraySize.z;
+	header->blocksize = mBlockSize;
+	header->finecount = mFineCount;
+	header->samplecount = mSampleCount;
+	if (! mTable.empty()) {
+		memcpy(header + 1, &mTable[0], sizeof(int) * mTable.size());
+	}
+}
+
+void THISCLASS::ReadShared(const void *src) {
+	const tShared *header = (const tShared*)src;
+	mArraySize = Point3Int(header->arraysize[0], header->arraysize[1], header->arraysize[2]);
+	mBlockSize = header->blocksize;
+	mEdge = Point3Int(mArraySize.x > 1 ? mBlockSize : 0, mArraySize.y > 1 ? mBlockSize : 0, mArraySize.z > 1 ? mBlockSize : 0);
+	mBlockCount = Point3Int(BlockCount(mArraySize.x, mEdge.x), BlockCount(mArraySize.y, mEdge.y), BlockCount(mArraySize.z, mEdge.z));
+	mCornerCount = Point3Int(mEdge.x ? mBlockCount.x + 1 : 1, mEdge.y ? mBlockCount.y + 1 : 1, mEdge.z ? mBlockCount.z + 1 : 1);
+	mFineCount = header->finecount;
+	mSampleCount = header->samplecount;
+	const int *table = (const int*)(header + 1);
+	mTable.assign(table, table + mBlockCount.Volume());
+}
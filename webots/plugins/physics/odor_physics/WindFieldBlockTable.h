@@ -0,0 +1,177 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classWindFieldBlockTable
+#define classWindFieldBlockTable
+
+class WindFieldBlockTable;
+
+#include <vector>
+#include <stddef.h>
+#include "Point3.h"
+#include "Point3Int.h"
+#include "Cube.h"
+
+//!	Two-level layout of a wind grid: fine blocks where detail is needed, and a coarse grid elsewhere.
+/*!
+	The regular grid (mArraySize points) is divided into blocks of mBlockSize x mBlockSize x mBlockSize grid intervals.
+	Blocks that touch a refinement region store all their (mBlockSize + 1)^3 grid points, such that interpolation never needs a neighbouring block.
+	All other blocks are covered by the coarse grid, which only stores the block corners (every mBlockSize-th grid point).
+
+	The stored grid points (samples) are numbered as follows: first the coarse grid (x varies fastest), then the fine blocks in the order of the block table.
+	The block table holds, for each block, the number of its first sample, or -1 if the block is coarse. A lookup is therefore a division and a table access.
+*/
+class WindFieldBlockTable {
+
+protected:
+	//! Dimensions of the regular grid.
+	Point3Int mArraySize;
+	//! Number of grid intervals per block edge.
+	int mBlockSize;
+	//! Number of grid intervals per block edge on each axis (mBlockSize, or 0 on axes with a single grid point).
+	Point3Int mEdge;
+	//! Number of blocks on each axis.
+	Point3Int mBlockCount;
+	//! Number of coarse grid points on each axis.
+	Point3Int mCornerCount;
+	//! First sample of each block, or -1 for coarse blocks (x varies fastest).
+	std::vector<int> mTable;
+	//! Number of fine blocks.
+	int mFineCount;
+	//! Total number of samples.
+	int mSampleCount;
+
+	//! Serialized layout (followed by the block table).
+	struct tShared {
+		int arraysize[3];
+		int blocksize;
+		int finecount;
+		int samplecount;
+	};
+
+public:
+	//! Constructor.
+	WindFieldBlockTable(): mArraySize(), mBlockSize(0), mEdge(), mBlockCount(), mCornerCount(), mTable(), mFineCount(0), mSampleCount(0) {}
+
+	//! Builds the table for a regular grid. Blocks closer than margin to any of the regions (in world coordinates) are refined.
+	void Build(const Point3 &origin, const Point3 &gridsize, const Point3Int &arraysize, int blocksize, const std::vector<Cube> &regions, double margin);
+
+	//! Returns the number of samples.
+	int GetSampleCount() const {
+		return mSampleCount;
+	}
+	//! Returns the number of fine blocks.
+	int GetFineCount() const {
+		return mFineCount;
+	}
+	//! Returns the total number of blocks.
+	int GetBlockCount() const {
+		return (int)mTable.size();
+	}
+	//! Returns the number of grid intervals per block edge.
+	int GetBlockSize() const {
+		return mBlockSize;
+	}
+	//! Returns the regular grid point of every sample.
+	void GetSamplePoints(std::vector<Point3Int> &points) const;
+
+	//! Computes the sample index (nearest sample, or base sample for trilinear interpolation), the offsets to the neighbouring samples and the interpolation factors of a point given in (continuous) regular grid coordinates.
+	inline void Stencil(double fx, double fy, double fz, bool trilinear, int &index, int &dx, int &dy, int &dz, Point3 &t) const;
+
+	//! Returns the number of bytes needed to serialize the table (a multiple of 8).
+	size_t GetSharedSize() const;
+	//! Serializes the table.
+	void WriteShared(void *dst) const;
+	//! Reads a table serialized with WriteShared.
+	void ReadShared(const void *src);
+};
+
+// Clamps a continuous grid coordinate to [0, n - 1].
+static inline double ClampGridCoordinate(double f, int n) {
+	return (f <= 0) ? 0 : ((f >= n - 1) ? n - 1 : f);
+}
+
+// Computes the nearest or lower sample along one axis (edge is the number of intervals, and g the coordinate within [0, edge]).
+static inline int BlockGridIndex(double g, int edge, bool trilinear, double &t) {
+	if (! trilinear) {
+		t = 0;
+		return (int)(g + 0.5);
+	}
+	if (edge == 0) {
+		t = 0;
+		return 0;
+	}
+	int i = (int)g;
+	if (i >= edge) {
+		i = edge - 1;
+	}
+	t = g - i;
+	return i;
+}
+
+// Computes the nearest or lower coarse grid point along one axis. The last coarse interval ends at the last grid point, and may thus be shorter than edge.
+static inline int CoarseGridIndex(double f, int edge, int n, int corners, bool trilinear, double &t) {
+	if (edge == 0) {
+		t = 0;
+		return 0;
+	}
+	int i = (int)(f / edge);
+	if (i >= corners - 1) {
+		i = corners - 2;
+	}
+	int lower = i * edge;
+	int upper = (lower + edge < n - 1) ? lower + edge : n - 1;
+	double g = (f - lower) / (upper - lower);
+	if (! trilinear) {
+		t = 0;
+		return (g < 0.5) ? i : i + 1;
+	}
+	t = g;
+	return i;
+}
+
+inline void WindFieldBlockTable::Stencil(double fx, double fy, double fz, bool trilinear, int &index, int &dx, int &dy, int &dz, Point3 &t) const {
+	fx = ClampGridCoordinate(fx, mArraySize.x);
+	fy = ClampGridCoordinate(fy, mArraySize.y);
+	fz = ClampGridCoordinate(fz, mArraySize.z);
+
+	// Block containing the point
+	int bx = mEdge.x ? (int)(fx / mEdge.x) : 0;
+	int by = mEdge.y ? (int)(fy / mEdge.y) : 0;
+	int bz = mEdge.z ? (int)(fz / mEdge.z) : 0;
+	if (bx >= mBlockCount.x) {
+		bx = mBlockCount.x - 1;
+	}
+	if (by >= mBlockCount.y) {
+		by = mBlockCount.y - 1;
+	}
+	if (bz >= mBlockCount.z) {
+		bz = mBlockCount.z - 1;
+	}
+	int first = mTable[bx + mBlockCount.x * (by + mBlockCount.y * bz)];
+
+	if (first >= 0) {
+		// Fine block with (mEdge + 1) samples per axis
+		int nx = mEdge.x + 1;
+		int ny = mEdge.y + 1;
+		int ix = BlockGridIndex(fx - bx * mEdge.x, mEdge.x, trilinear, t.x);
+		int iy = BlockGridIndex(fy - by * mEdge.y, mEdge.y, trilinear, t.y);
+		int iz = BlockGridIndex(fz - bz * mEdge.z, mEdge.z, trilinear, t.z);
+		index = first + ix + nx * (iy + ny * iz);
+		dx = (mEdge.x ? 1 : 0);
+		dy = (mEdge.y ? nx : 0);
+		dz = (mEdge.z ? nx * ny : 0);
+		return;
+	}
+
+	// Coarse grid (one sample per block corner)
+	int ix = CoarseGridIndex(fx, mEdge.x, mArraySize.x, mCornerCount.x, trilinear, t.x);
+	int iy = CoarseGridIndex(fy, mEdge.y, mArraySize.y, mCornerCount.y, trilinear, t.y);
+	int iz = CoarseGridIndex(fz, mEdge.z, mArraySize.z, mCornerCount.z, trilinear, t.z);
+	index = ix + mCornerCount.x * (iy + mCornerCount.y * iz);
+	dx = (mCornerCount.x > 1 ? 1 : 0);
+	dy = (mCornerCount.y > 1 ? mCornerCount.x : 0);
+	dz = (mCornerCount.z > 1 ? mCornerCount.x * mCornerCount.y : 0);
+}
+
+#endif
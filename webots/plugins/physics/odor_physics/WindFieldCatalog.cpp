@@ -0,0 +1,104 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#include "WindFieldCatalog.h"
+#define THISCLASS WindFieldCatalog
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+const char *THISCLASS::sCacheFile = "windcatalog.txt";
+
+bool THISCLASS::Read(const std::string &folder) {
+	if (ReadCache(folder)) {
+		return true;
+	}
+	if (! Scan(folder)) {
+		return false;
+	}
+	WriteCache(folder);
+	return true;
+}
+
+bool THISCLASS::Scan(const std::string &folder) {
+	mEntries.clear();
+
+	DIR *d = opendir(folder.c_str());
+	if (! d) {
+		return false;
+	}
+	while (struct dirent *entry = readdir(d)) {
+		if ((entry->d_type != DT_DIR) || (entry->d_name[0] == '.')) {
+			continue;
+		}
+
+		// Ignore all subfolders that are not numbers
+		char *end;
+		tEntry e;
+		e.time = strtod(entry->d_name, &end);
+		if ((end == entry->d_name) || (*end != 0)) {
+			continue;
+		}
+		e.name = entry->d_name;
+		mEntries.push_back(e);
+	}
+	closedir(d);
+
+	std::sort(mEntries.begin(), mEntries.end());
+	return true;
+}
+
+bool THISCLASS::ReadCache(const std::string &folder) {
+	// The cache is valid if it was written after the last modification of the folder
+	std::string file = folder + "/" + sCacheFile;
+	struct stat stfolder;
+	struct stat stfile;
+	if ((stat(folder.c_str(), &stfolder) != 0) || (stat(file.c_str(), &stfile) != 0) || (stfile.st_mtime < stfolder.st_mtime)) {
+		return false;
+	}
+
+	std::ifstream in(file.c_str());
+	in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+	int count = -1;
+	in >> count;
+	if ((! in) || (count < 0)) {
+		return false;
+	}
+	mEntries.resize(count);
+	for (int i = 0; i < count; i++) {
+		in >> mEntries[i].time >> mEntries[i].name;
+	}
+	if (! in) {
+		mEntries.clear();
+		return false;
+	}
+	std::sort(mEntries.begin(), mEntries.end());
+	return true;
+}
+
+void THISCLASS::WriteCache(const std::string &folder) {
+	std::string file = folder + "/" + sCacheFile;
+	std::ofstream out(file.c_str());
+	if (! out.is_open()) {
+		return;
+	}
+	out << "# Snapshot catalog of this folder (delete this file to rebuild it)" << std::endl;
+	out << mEntries.size() << std::endl;
+	out << std::setprecision(17);
+	for (unsigned int i = 0; i < mEntries.size(); i++) {
+		out << mEntries[i].time << " " << mEntries[i].name << std::endl;
+	}
+}
+
+int THISCLASS::Find(double time) const {
+	tEntry e;
+	e.time = time;
+	std::vector<tEntry>::const_iterator it = std::upper_bound(mEntries.begin(), mEntries.end(), e);
+	return (int)(it - mEntries.begin()) - 1;
+}
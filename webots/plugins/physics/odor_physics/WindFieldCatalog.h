@@ -0,0 +1,63 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classWindFieldCatalog
+#define classWindFieldCatalog
+
+class WindFieldCatalog;
+
+#include <string>
+#include <vector>
+
+//!	Sorted list of the snapshot times available in a samples folder.
+/*!
+	Each snapshot is a subfolder named after its simulation time. Subfolders whose name is not a number are ignored.
+	The catalog is cached in the file "windcatalog.txt" inside the samples folder, and only rebuilt if the folder has been modified after the cache was written (or if the cache file is deleted).
+*/
+class WindFieldCatalog {
+
+public:
+	//! A catalog entry.
+	struct tEntry {
+		double time;		//!< Simulation time of the snapshot.
+		std::string name;	//!< Name of the subfolder.
+
+		bool operator < (const tEntry &other) const {
+			return time < other.time;
+		}
+	};
+
+protected:
+	//! The entries, sorted by time.
+	std::vector<tEntry> mEntries;
+
+	//! Reads the cache file. Returns false if there is no valid cache.
+	bool ReadCache(const std::string &folder);
+	//! Writes the cache file (if the folder is writable).
+	void WriteCache(const std::string &folder);
+
+public:
+	//! The name of the cache file.
+	static const char *sCacheFile;
+
+	//! Constructor.
+	WindFieldCatalog(): mEntries() {}
+
+	//! Reads the catalog of a samples folder (from the cache if possible). Returns false if the folder cannot be read.
+	bool Read(const std::string &folder);
+	//! Scans the samples folder (ignoring the cache). Returns false if the folder cannot be read.
+	bool Scan(const std::string &folder);
+
+	//! Returns the number of snapshots.
+	int GetCount() const {
+		return (int)mEntries.size();
+	}
+	//! Returns a catalog entry.
+	const tEntry &GetEntry(int i) const {
+		return mEntries[i];
+	}
+	//! Returns the index of the last snapshot at or before time, or -1 if time is before the first snapshot.
+	int Find(double time) const;
+};
+
+#endif
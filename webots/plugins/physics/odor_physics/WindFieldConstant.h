@@ -25,6 +25,10 @@ public:
 	void SetWindSpeed(const Point3 &ws) {
 		mWindSpeed = ws;
 	}
+	//! Returns the constant wind speed.
+	const Point3 &GetWindSpeed() const {
+		return mWindSpeed;
+	}
 
 	// WindField methods
 	void OnSimulationStart() {}
@@ -34,6 +38,11 @@ public:
 	Point3 GetWindSpeed(const Point3 &preal) {
 		return mWindSpeed;
 	}
+	void GetWindSpeeds(const Point3 */*in*/, Point3 *out, int n) {
+		for (int i = 0; i < n; i++) {
+			out[i] = mWindSpeed;
+		}
+	}
 	void WriteConfiguration(std::ostream &out);
 };
 
@@ -6,172 +6,432 @@
 #include <fstream>
 #include <sstream>
 #include <algorithm>
-#include <dirent.h>
 #include <math.h> 
 #include "WindFieldDynamic.h"
 #include "TextFileReaderOpenFOAMSamples.h"
+#include "ObstacleList.h"
 #define	THISCLASS WindFieldDynamic
 
-THISCLASS::WindFieldDynamic(Simulation *sim): WindField(sim) {
-	mWindFieldSnapshot[0] = new WindFieldSnapshot();
-	mWindFieldSnapshot[1] = new WindFieldSnapshot();
-	
+THISCLASS::WindFieldDynamic(Simulation *sim): WindField(sim), mRingSize(2), mCatalog(), mCatalogNext(0), mStartTime(0), mSequenceFile(), mSequence(NULL), mLoop(false), mLoopStart(0), mLoopEnd(0), mLoopFade(0), mResident(), mResidentTimes(), mSharedName(), mShared(NULL), mTimeInterpolation(WindFieldTimeInterpolation::sModeLinear), mBlendCount(0), mCellSnapshot(new WindFieldSnapshot()), mInterpolation(WindFieldSnapshot::sInterpolationNearest), mStorage(WindFieldSnapshot::sStorageDouble), mBlockSize(0), mRefinementMargin(0), mRefinementRegions() {
+	for (int i = 0; i < mRingMax; i++) {
+		mWindFieldSnapshot[i] = new WindFieldSnapshot();
+		mSnapshotValid[i] = false;
+	}
 }
 
-// mini function for sort function used in OnSimulationStart()
-bool wayToSort(double i, double j) { return i > j; }
-
 void THISCLASS::OnSimulationStart() {
-	mFileHeapCount = 0;
+	mRingSize = (mTimeInterpolation == WindFieldTimeInterpolation::sModeCubic ? 4 : 2);
 
-	// Open folder
-	DIR *d = opendir(mSamplesFolder.c_str());
-	if (! d) {
-		AddError("Unable to access samples folder! Is the path correct?");
-		return;
+	// Read the snapshot catalog (not needed for compressed sequences), and start with the snapshot(s) before the start time
+	if (mSequenceFile.empty()) {
+		if (! mCatalog.Read(mSamplesFolder)) {
+			AddError("Unable to access samples folder! Is the path correct?");
+			return;
+		}
+		double first = (mLoop ? std::min(mStartTime, mLoopStart) : mStartTime);
+		mCatalogNext = std::max(0, mCatalog.Find(first) - (mRingSize / 2 - 1));
 	}
 
-	// Reinitialize the heap
-	for (int i = 0; i < mFileHeapMax; i++) {
-		mFileHeap[i] = 0;
+	// Attach to the mesh (and loop window) of another process
+	bool meshattached = false;
+	bool windowattached = false;
+	if (! mSharedName.empty()) {
+		delete mShared;
+		mShared = new WindFieldSharedStore();
+		if (! mShared->Open(mSharedName, GetSharedKey())) {
+			std::cout << "Unable to use the shared wind field " << mSharedName << ", reading the samples folder" << std::endl;
+			delete mShared;
+			mShared = NULL;
+		} else if ((! mShared->IsCreator()) && (mShared->GetCount() >= 1)) {
+			AttachSharedMesh();
+			meshattached = true;
+			if (mLoop && (mShared->GetCount() >= 3)) {
+				AttachSharedWindow();
+				windowattached = true;
+			}
+		}
 	}
-	std::make_heap(mFileHeap, mFileHeap);
 
-	// Read folder items
-	while (struct dirent *entry = readdir(d)) {
-		if ((entry->d_type == DT_DIR) && (entry->d_name[0] != '.')) {
-			
-			double val;
-			std::string str(entry->d_name);
-			std::istringstream istr(str);
-			// TODO catch errors, i.e. ignore all subfolders that are not numbers
-			istr >> val;
-			
-			mFileHeap[mFileHeapCount] = val;
-			mFileHeapCount++;
-			std::push_heap(mFileHeap, mFileHeap + mFileHeapCount);
+	//Fa
+	if (! meshattached) {
+		windSnapshotMemoryAllocation(mCellSnapshot);
+		for (int i = 0; i < mRingSize; i++) {
+			mWindFieldSnapshot[i]->SetMesh(mCellSnapshot->GetMesh(), false);
+			mWindFieldSnapshot[i]->SetInterpolation(mInterpolation);
+			mWindFieldSnapshot[i]->SetStorage(mStorage);
 		}
 	}
-	
-	std::sort(mFileHeap, mFileHeap+mFileHeapCount, wayToSort);
-	/*std::cout << "begin............" << std::endl;
-	for (int i = mFileHeapCount -1; i >= 0; i--) 
-    	std::cout << mFileHeap[i] << "	"<< i<< std::endl;
-   	std::cout << "done............" << std::endl;
-  	std::cout << "mFileHeapCount " << mFileHeapCount << std::endl;
- */
-	// Close folder
-	closedir(d);
-	
-	//Fa
-	windSnapshotMemoryAllocation(mWindFieldSnapshot[0]);
-	//windSnapshotMemoryAllocation(mWindFieldSnapshot[1]);
-	mWindFieldSnapshot[1]->WindFieldSnapshotCopy(*mWindFieldSnapshot[0]);
+	for (int i = 0; i < mRingMax; i++) {
+		mSnapshotValid[i] = false;
+	}
 
-	// Read the two first wind fields
-	ReadNextFile();
-	ReadNextFile();
+	// Open the compressed sequence
+	if (! mSequenceFile.empty()) {
+		delete mSequence;
+		mSequence = new DataFileReaderWindSequence(mSequenceFile);
+		if (mSequence->Error()) {
+			AddError("Unable to read the wind sequence file!");
+			return;
+		}
+		if (mSequence->GetCellCount() != mCellSnapshot->GetCellCount()) {
+			AddError("The wind sequence file does not match the cell centres of the samples folder!");
+			return;
+		}
+	}
+
+	// Read the loop window
+	if (mLoop) {
+		mLoopFade = std::max(0.0, std::min(mLoopFade, (mLoopEnd - mLoopStart) / 2));
+		if ((mLoopEnd <= mLoopStart) || ((! windowattached) && (! ReadLoopWindow()))) {
+			AddError("No wind samples in the loop window!");
+			return;
+		}
+	}
+
+	// Publish the mesh (and the loop window) for other processes, and use the shared copy
+	if (mShared && mShared->IsCreator()) {
+		const WindFieldMesh *mesh = mWindFieldSnapshot[0]->GetMesh();
+		mesh->WriteShared(mShared->Add(mesh->GetSharedSize()));
+		for (unsigned int i = 0; i < mResident.size(); i++) {
+			mResident[i]->WriteSharedGrid(mShared->Add(mResident[i]->GetSharedGridSize()));
+		}
+		if (mShared->Publish()) {
+			AttachSharedMesh();
+			AttachSharedWindow();
+		}
+	}
+
+	if (mLoop) {
+		UpdateWeights(mStartTime);
+		return;
+	}
+
+	// Read the first wind fields
+	if (! Advance(mStartTime)) {
+		AddError("No wind samples at the start time!");
+		return;
+	}
+	UpdateWeights(mStartTime);
 }
 
 void THISCLASS::OnSimulationEnd() {
 }
 
 void THISCLASS::OnSimulationStep() {
-//std::cout << "OnSimulationStep START" << std::endl;
-	// Read next file if necessary
-	//std::cout << "mSimulation->mSimulationTime " << mSimulation->mSimulationTime << std::endl;
-//	std::cout << "mWindFieldSnapshot[1]->mTime " << mWindFieldSnapshot[1]->mTime << std::endl;
-	//std::cout << "mWindFieldSnapshot[0]->mTime " << mWindFieldSnapshot[0]->mTime << std::endl;
-	while (mSimulation->mSimulationTime > mWindFieldSnapshot[1]->mTime) {
+	// Read the next file if necessary
+	double time = mSimulation->mSimulationTime + mStartTime;
+	if (mLoop) {
+		UpdateWeights(time);
+		return;
+	}
+	if (! Advance(time)) {
+		AddError("At end of wind simulation!");
+		return;
+	}
+	UpdateWeights(time);
+}
+
+bool THISCLASS::Advance(double time) {
+	int b = mRingSize / 2;
+	while ((! mSnapshotValid[b]) || (time > mWindFieldSnapshot[b]->mTime)) {
 		bool ok = ReadNextFile();
-		if (! ok) {
-			AddError("At end of wind simulation!");
-			return;
+		if ((! ok) && (! mSnapshotValid[b])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void THISCLASS::Read(DataFileReader &f) {
+	// Refuse a time after the last sample before modifying anything (compressed sequences are only read sequentially, and cannot be checked)
+	double time = f.Double();
+	int count = mCatalog.GetCount();
+	if ((! mLoop) && mSequenceFile.empty() && ((count == 0) || (time > mCatalog.GetEntry(count - 1).time))) {
+		AddError("No wind samples at the checkpoint time!");
+		f.mError = DataFileReader::ERROR_FORMAT;
+		return;
+	}
+	mStartTime = time - mSimulation->mSimulationTime;
+	if (mLoop) {
+		UpdateWeights(time);
+		return;
+	}
+
+	// Start again with the snapshot(s) before that time
+	if (mSequenceFile.empty()) {
+		for (int i = 0; i < mRingMax; i++) {
+			mSnapshotValid[i] = false;
+		}
+		mCatalogNext = std::max(0, mCatalog.Find(time) - (mRingSize / 2 - 1));
+	}
+	if (! Advance(time)) {
+		AddError("No wind samples at the checkpoint time!");
+		f.mError = DataFileReader::ERROR_FORMAT;
+		return;
+	}
+	UpdateWeights(time);
+}
+
+void THISCLASS::Write(DataFileWriter &f) {
+	f.Double(mSimulation->mSimulationTime + mStartTime);
+}
+
+void THISCLASS::UpdateWeights(double time) {
+	mBlendCount = 0;
+
+	// Loop: blend the resident snapshots, fading into the beginning of the window at the end of each pass
+	if (mLoop) {
+		double s = LoopTime(time);
+		double fadestart = mLoopEnd - mLoopFade;
+		if ((mLoopFade > 0) && (s > fadestart)) {
+			double alpha = (s - fadestart) / mLoopFade;
+			AddResidentBlend(s, 1 - alpha);
+			AddResidentBlend(s - (mLoopEnd - mLoopStart - mLoopFade), alpha);
+		} else {
+			AddResidentBlend(s, 1);
+		}
+		return;
+	}
+
+	// Stencil of 4 snapshots around the interval (the outer ones are missing for linear interpolation)
+	int first = mRingSize / 2 - 2;
+	const WindFieldSnapshot *stencil[4];
+	bool valid[4];
+	for (int i = 0; i < 4; i++) {
+		int r = first + i;
+		valid[i] = (r >= 0) && (r < mRingSize) && mSnapshotValid[r];
+		stencil[i] = (valid[i] ? mWindFieldSnapshot[r] : NULL);
+	}
+	AddBlend(stencil, valid, time, 1);
+}
+
+void THISCLASS::AddBlend(const WindFieldSnapshot * const *stencil, const bool *valid, double time, double scale) {
+	double times[4];
+	for (int i = 0; i < 4; i++) {
+		times[i] = (valid[i] ? stencil[i]->mTime : 0);
+	}
+
+	double weights[4];
+	WindFieldTimeInterpolation::Weights(mTimeInterpolation, times, valid, time, weights);
+	for (int i = 0; i < 4; i++) {
+		if (valid[i] && (weights[i] * scale != 0) && (mBlendCount < mBlendMax)) {
+			mBlendSnapshots[mBlendCount] = stencil[i];
+			mBlendWeights[mBlendCount] = weights[i] * scale;
+			mBlendCount++;
 		}
 	}
+}
+
+void THISCLASS::AddResidentBlend(double time, double scale) {
+	// The interval [k, k + 1] containing time (clamped to the resident snapshots)
+	int count = (int)mResidentTimes.size();
+	int k = (int)(std::upper_bound(mResidentTimes.begin(), mResidentTimes.end(), time) - mResidentTimes.begin()) - 1;
+	k = std::max(0, std::min(k, count - 2));
 
-	mTimeInterpolationFactor = (mSimulation->mSimulationTime - mWindFieldSnapshot[0]->mTime) / (mWindFieldSnapshot[1]->mTime - mWindFieldSnapshot[0]->mTime);
-	/*std::cout << "mTimeInterpolationFactor = (" << mSimulation->mSimulationTime 
-				<< " - " << mWindFieldSnapshot[0]->mTime << ") / (" 
-				<< mWindFieldSnapshot[1]->mTime << " - " << mWindFieldSnapshot[0]->mTime 
-				<< ") = " << mTimeInterpolationFactor << std::endl;*/
-//std::cout << "OnSimulationStep END" << std::endl;
+	// Linear interpolation only uses the two inner snapshots
+	const WindFieldSnapshot *stencil[4];
+	bool valid[4];
+	for (int i = 0; i < 4; i++) {
+		int r = k - 1 + i;
+		valid[i] = (r >= 0) && (r < count) && ((mTimeInterpolation == WindFieldTimeInterpolation::sModeCubic) || (i == 1) || (i == 2));
+		stencil[i] = (valid[i] ? mResident[r] : NULL);
+	}
+	AddBlend(stencil, valid, time, scale);
+}
+
+double THISCLASS::LoopTime(double time) const {
+	// The first pass plays the sequence up to the end of the window, after which the window (without the part covered by the fade) repeats
+	if (time < mLoopEnd) {
+		return time;
+	}
+	double period = mLoopEnd - mLoopStart - mLoopFade;
+	return mLoopStart + mLoopFade + fmod(time - mLoopEnd, period);
+}
+
+unsigned long long THISCLASS::GetSharedKey() const {
+	std::ostringstream settings;
+	settings.precision(17);
+	settings << mSamplesFolder << "\n" << mSequenceFile << "\n";
+	if (mSequenceFile.empty()) {
+		settings << WindFieldSharedStore::GetFileStamp(mSamplesFolder + "/" + WindFieldCatalog::sCacheFile) << " " << WindFieldSharedStore::GetFileStamp(mSamplesFolder + "/0/cellCentres") << "\n";
+	} else {
+		settings << WindFieldSharedStore::GetFileStamp(mSequenceFile) << "\n";
+	}
+	settings << mStorage << " " << mInterpolation << " " << mTimeInterpolation << " " << mBlockSize << " " << mRefinementMargin;
+	std::vector<Cube> regions(mRefinementRegions);
+	if (mSimulation->mObstacleList) {
+		mSimulation->mObstacleList->GetCubes(regions);
+	}
+	for (unsigned int i = 0; i < regions.size(); i++) {
+		settings << " " << regions[i];
+	}
+	if (mLoop) {
+		settings << " loop " << std::min(mStartTime, mLoopStart) << " " << mLoopEnd;
+	}
+	return WindFieldSharedStore::GetKey(settings.str());
+}
+
+void THISCLASS::AttachSharedMesh() {
+	WindFieldMesh *mesh = new WindFieldMesh();
+	mesh->AttachShared(mShared->Get(0));
+	mCellSnapshot->SetMesh(mesh);
+	for (int i = 0; i < mRingSize; i++) {
+		mWindFieldSnapshot[i]->SetMesh(mesh, false);
+		mWindFieldSnapshot[i]->SetInterpolation(mInterpolation);
+		mWindFieldSnapshot[i]->SetStorage(mStorage);
+	}
+}
+
+void THISCLASS::AttachSharedWindow() {
+	// Block 0 is the mesh, all other blocks are the snapshots of the loop window
+	for (unsigned int i = 0; i < mResident.size(); i++) {
+		delete mResident[i];
+	}
+	int count = mShared->GetCount() - 1;
+	mResident.resize(count);
+	mResidentTimes.resize(count);
+	for (int i = 0; i < count; i++) {
+		mResident[i] = new WindFieldSnapshot();
+		mResident[i]->AttachSharedGrid(mShared->Get(i + 1));
+		mResident[i]->SetInterpolation(mInterpolation);
+		mResidentTimes[i] = mResident[i]->GetTime();
+	}
+}
+
+bool THISCLASS::ReadLoopWindow() {
+	// Keep two snapshots before the beginning, and two after the end of the window (only their grid, the cells are read into the shared cell buffer)
+	double first = std::min(mStartTime, mLoopStart);
+	WindFieldSnapshot *wfs = NULL;
+	while (true) {
+		if (! wfs) {
+			wfs = new WindFieldSnapshot();
+			wfs->WindFieldSnapshotCopy(*mWindFieldSnapshot[0]);
+		}
+		if (! ReadSnapshot(wfs)) {
+			break;
+		}
+		mResident.push_back(wfs);
+		wfs = NULL;
+
+		if ((mResident.size() > 2) && (mResident[2]->mTime <= first)) {
+			wfs = mResident.front();
+			mResident.erase(mResident.begin());
+		}
+		int count = (int)mResident.size();
+		if ((count >= 2) && (mResident[count - 2]->mTime >= mLoopEnd)) {
+			break;
+		}
+	}
+	delete wfs;
+
+	mResidentTimes.resize(mResident.size());
+	for (unsigned int i = 0; i < mResident.size(); i++) {
+		mResidentTimes[i] = mResident[i]->mTime;
+	}
+	return (mResident.size() >= 2);
 }
 
 void THISCLASS::WriteConfiguration(std::ostream &out) {
-	mWindFieldSnapshot[0]->WriteConfiguration(out);
-	mWindFieldSnapshot[1]->WriteConfiguration(out);
-	//std::cout << "windFieldDynamic line 94" << std::endl;
+	if (mLoop) {
+		out << "<Loop>" << std::endl;
+		out << "\t<Start>" << mLoopStart << "</Start>" << std::endl;
+		out << "\t<End>" << mLoopEnd << "</End>" << std::endl;
+		out << "\t<Fade>" << mLoopFade << "</Fade>" << std::endl;
+		out << "\t<ResidentSnapshots>" << mResident.size() << "</ResidentSnapshots>" << std::endl;
+		size_t memory = 0;
+		for (unsigned int i = 0; i < mResident.size(); i++) {
+			memory += mResident[i]->GetMemorySize();
+		}
+		out << "\t<ResidentMemory>" << memory << " bytes</ResidentMemory>" << std::endl;
+		out << "</Loop>" << std::endl;
+	}
+	for (int i = 0; i < mRingSize; i++) {
+		mWindFieldSnapshot[i]->WriteConfiguration(out);
+	}
 }
 
 Point3 THISCLASS::GetWindSpeed(const Point3 &preal) {
-//std::cout << "windFieldDynamic line 96" << std::endl;
-	Point3 w0 = mWindFieldSnapshot[0]->GetWindSpeed(preal);
-	Point3 w1 = mWindFieldSnapshot[1]->GetWindSpeed(preal);
-	//std::cout << "w0 " << w0 << ", w1 " << w1<< std::endl;
-//std::cout << "windFieldDynamic line 100" << std::endl;
-	return w0*mTimeInterpolationFactor + w1*(1 - mTimeInterpolationFactor);
+	Point3 out;
+	GetWindSpeeds(&preal, &out, 1);
+	return out;
+}
+
+void THISCLASS::GetWindSpeeds(const Point3 *in, Point3 *out, int n) {
+	if (mBlendCount == 0) {
+		for (int i = 0; i < n; i++) {
+			out[i] = Point3(-100, -100, -100);
+		}
+		return;
+	}
+
+	// All snapshots share the same grid, so they are blended in one pass
+	WindFieldSnapshot::GetWeightedWindSpeeds(mBlendSnapshots, mBlendWeights, mBlendCount, in, out, n);
+}
+
+double THISCLASS::GetResolution() {
+	const WindFieldMesh *mesh = mWindFieldSnapshot[0]->GetMesh();
+	return (mesh ? mesh->GetMinGridSize() : 0);
+}
+
+bool THISCLASS::ReadSnapshot(WindFieldSnapshot *wfs) {
+	// The cells are read into the shared cell buffer, and only resampled into the snapshot
+	WindFieldSnapshot *cells = mCellSnapshot;
+	bool ok = true;
+	if (mSequence) {
+		// Decode the next frame of the compressed sequence
+		ok = mSequence->ReadFrame(cells);
+	} else if (mCatalogNext < mCatalog.GetCount()) {
+		const WindFieldCatalog::tEntry &entry = mCatalog.GetEntry(mCatalogNext);
+		mCatalogNext++;
+
+		std::ostringstream file;
+		file << mSamplesFolder << "/" << entry.name << "/U";
+		TextFileReaderOpenFOAMSamples tfr(file.str());
+		ok = ! tfr.Error();
+		if (ok) {
+			tfr.Read(cells);
+			cells->mTime = entry.time;
+		}
+	} else {
+		// No more files in the catalog
+		ok = false;
+	}
+	if (ok) {
+		wfs->mTime = cells->mTime;
+		wfs->ResampleGrid(*cells);
+		mSimulation->mCounters.Increment(SimulationCounters::sCounterWindFilesRead);
+	}
+	return ok;
 }
 
 bool THISCLASS::ReadNextFile() {
-//std::cout << "WindFieldDynamic ReadNextFile" << std::endl;
-	// Switch the two wind fields
-	WindFieldSnapshot *temp = mWindFieldSnapshot[1];
-	mWindFieldSnapshot[1] = mWindFieldSnapshot[0];
-	mWindFieldSnapshot[0] = temp;
-	std::cout << mFileHeapCount << std::endl;
-	// If there are no more files on the heap, stop the simulation
-	if (mFileHeapCount <= 0) {
-		return false;
-	}
-
-	// Get the next file name
-	/*
-	std::pop_heap(mFileHeap, mFileHeap + mFileHeapCount);
-std::cout << "begin............2" << std::endl;
-	for (int i = mFileHeapCount - 1; i >= 0; i--) 
-    	std::cout << mFileHeap[i] <<"	"<< i<<  std::endl;
-std::cout << "done............2" << std::endl;
-	*/
-	mFileHeapCount--;
-	double time = mFileHeap[mFileHeapCount];
-	mFileHeap[mFileHeapCount] = 0;
-
-
-	std::ostringstream file;
-	//file << mSamplesFolder << "/" << time << "/velfield_xy";
-	file << mSamplesFolder << "/" << time << "/U";
-
-	// bad idea Fa
-	mWindFieldSnapshot[0]->mTime = time;
-	//std::cout << "Time " << time << std::endl;
-	
-	// Read the next file
-	TextFileReaderOpenFOAMSamples tfr(file.str());
-	//std::cout << "TextFileReaderOpenFOAMSamples constructor" << std::endl;
-	//if (tfr.Error()) {return false;}	//Error() method doesn't existe yet TODO
-	tfr.Read(mWindFieldSnapshot[0]);
-	
-//std::cout << "WindFieldDynamic ReadNextFile end" << std::endl;	
-	return true;
+	// Read the next snapshot into the oldest snapshot
+	WindFieldSnapshot *wfs = mWindFieldSnapshot[0];
+	bool ok = ReadSnapshot(wfs);
+
+	// Rotate the ring
+	for (int i = 0; i < mRingSize - 1; i++) {
+		mWindFieldSnapshot[i] = mWindFieldSnapshot[i + 1];
+		mSnapshotValid[i] = mSnapshotValid[i + 1];
+	}
+	mWindFieldSnapshot[mRingSize - 1] = wfs;
+	mSnapshotValid[mRingSize - 1] = ok;
+	return ok;
 }
 
 
 // read the "cellcentres" file to have the number of points to allocate memory as well as the centre of cells 
 void THISCLASS::windSnapshotMemoryAllocation(WindFieldSnapshot *wfs) {	//Fa
-//std::cout << "WindFieldDynamic windSnapshotMemoryAllocation" << std::endl;
 	
 	std::string line, prevLine;
 	bool start = false;
-	int size = 0, ctrPoint = 0;
-	Point3 * mCellCentrestmp = NULL;
+	int size = 0;
+	std::vector<Point3> cellcentres;
 	Point3 newpoint, oldValue(-1e7,-1e7,-1e7), diff;
 
-	wfs->mCellCentres = (Point3*) malloc (sizeof(double));
-	wfs->mOrigin = Point3(1e7,1e7,1e7);
-	wfs->mEnd = Point3(-1e7,-1e7,-1e7);
-	wfs->mGridSize = Point3(1e8,1e8,1e8);
-	wfs->SetArraySize(Point3Int(0,0,0));
+	Point3 origin(1e7,1e7,1e7);
+	Point3 end(-1e7,-1e7,-1e7);
+	Point3 gridsize(1e8,1e8,1e8);
 	
 	//open the file (no need to use open())
 	std::ostringstream pointsFile;
@@ -192,7 +452,7 @@ void THISCLASS::windSnapshotMemoryAllocation(WindFieldSnapshot *wfs) {	//Fa
 				if (line[0]=='('){
 					start = true; 
 					size = atoi(prevLine.c_str());
-					std::cout << "size " << size << std::endl;
+					cellcentres.reserve(size);
 				} else
 					prevLine = line;
 				continue;
@@ -202,56 +462,42 @@ void THISCLASS::windSnapshotMemoryAllocation(WindFieldSnapshot *wfs) {	//Fa
 			if (line[0]=='(')
 				line.erase (line.begin()); 
 			
-			// Memory reallocation
-			ctrPoint++;
-			mCellCentrestmp = (Point3*) realloc (wfs->mCellCentres, ctrPoint * sizeof(Point3));
-			if(mCellCentrestmp != NULL){
-    			wfs->mCellCentres = mCellCentrestmp;
-    			wfs->mCellCentres[ctrPoint-1] = newpoint;
-    		} else {
-    			free(wfs->mCellCentres);
-    			std::cout << "Error reallocating memory" << std::endl;
-    			exit (1);
-    		}
     		// seperate x, y and z
 			std::istringstream iss(line);
-    		if (!(iss >> wfs->mCellCentres[ctrPoint-1].x >> wfs->mCellCentres[ctrPoint-1].y >> wfs->mCellCentres[ctrPoint-1].z)) 
+    		if (!(iss >> newpoint.x >> newpoint.y >> newpoint.z)) 
     			continue; // in case of useless lines (but it shouldn't happend!)
-    		//std::cout << "point counter : " << ctrPoint << std::endl;
-    		/*std::cout << wfs->mCellCentres[ctrPoint-1].x << " " 
-    					<< wfs->mCellCentres[ctrPoint-1].y << " "
-    					<< wfs->mCellCentres[ctrPoint-1].z << std::endl;*/
+    		cellcentres.push_back(newpoint);
     		
     		// set the size of the measurement area
-    		if (wfs->mOrigin.x > wfs->mCellCentres[ctrPoint-1].x)
-    			wfs->mOrigin.x = wfs->mCellCentres[ctrPoint-1].x;
-    		if (wfs->mOrigin.y > wfs->mCellCentres[ctrPoint-1].y)
-    			wfs->mOrigin.y = wfs->mCellCentres[ctrPoint-1].y;
-    		if (wfs->mOrigin.z > wfs->mCellCentres[ctrPoint-1].z)
-    			wfs->mOrigin.z = wfs->mCellCentres[ctrPoint-1].z;
-    		if (wfs->mEnd.x < wfs->mCellCentres[ctrPoint-1].x)
-    			wfs->mEnd.x = wfs->mCellCentres[ctrPoint-1].x;
-    		if (wfs->mEnd.y < wfs->mCellCentres[ctrPoint-1].y)
-    			wfs->mEnd.y = wfs->mCellCentres[ctrPoint-1].y;
-    		if (wfs->mEnd.z < wfs->mCellCentres[ctrPoint-1].z)
-    			wfs->mEnd.z = wfs->mCellCentres[ctrPoint-1].z;
+    		if (origin.x > newpoint.x)
+    			origin.x = newpoint.x;
+    		if (origin.y > newpoint.y)
+    			origin.y = newpoint.y;
+    		if (origin.z > newpoint.z)
+    			origin.z = newpoint.z;
+    		if (end.x < newpoint.x)
+    			end.x = newpoint.x;
+    		if (end.y < newpoint.y)
+    			end.y = newpoint.y;
+    		if (end.z < newpoint.z)
+    			end.z = newpoint.z;
     		
     		// set the gridsize
-    		diff = wfs->mCellCentres[ctrPoint-1] - oldValue;
+    		diff = newpoint - oldValue;
     		if (fabs(diff.x) > 0) {
-    			oldValue.x = wfs->mCellCentres[ctrPoint-1].x;
-    			if ((fabs(diff.x) < wfs->mGridSize.x) && (fabs(diff.x) > 0.001))
-    				wfs->mGridSize.x = fabs(diff.x);
+    			oldValue.x = newpoint.x;
+    			if ((fabs(diff.x) < gridsize.x) && (fabs(diff.x) > 0.001))
+    				gridsize.x = fabs(diff.x);
     		}
     		if (fabs(diff.y) > 0) {
-    			oldValue.y = wfs->mCellCentres[ctrPoint-1].y;
-    			if ((fabs(diff.y) < wfs->mGridSize.y) && (fabs(diff.y) > 0.001))
-    				wfs->mGridSize.y = fabs(diff.y);
+    			oldValue.y = newpoint.y;
+    			if ((fabs(diff.y) < gridsize.y) && (fabs(diff.y) > 0.001))
+    				gridsize.y = fabs(diff.y);
     		}
     		if (fabs(diff.z) > 0) {
-    			oldValue.z = wfs->mCellCentres[ctrPoint-1].z;
-    			if ((fabs(diff.z) < wfs->mGridSize.z) && (fabs(diff.z) > 0.001))
-    				wfs->mGridSize.z = fabs(diff.z);
+    			oldValue.z = newpoint.z;
+    			if ((fabs(diff.z) < gridsize.z) && (fabs(diff.z) > 0.001))
+    				gridsize.z = fabs(diff.z);
     		}
 		}
     } else
@@ -260,59 +506,57 @@ void THISCLASS::windSnapshotMemoryAllocation(WindFieldSnapshot *wfs) {	//Fa
 	// close the input file (not sure if necessary)
     infile.close();
     
-    // number of points on each axis
-    wfs->mArraySize = (wfs->mEnd - wfs->mOrigin + wfs->mGridSize).DotDivide(wfs->mGridSize);
-    
-    // Memory Allocation for wind snapshot
-    wfs->AllocateArray(ctrPoint);
-    wfs->mCellNbr = ctrPoint;
-    
+    // The mesh (shared by all snapshots), with the number of points on each axis
+    int ctrPoint = cellcentres.size();
+    WindFieldMesh *mesh = new WindFieldMesh();
+    mesh->SetGrid(origin, gridsize, (end - origin + gridsize).DotDivide(gridsize));
+    mesh->mCellCount = ctrPoint;
+    mesh->mCellCentres = new Point3[ctrPoint];
+    std::copy(cellcentres.begin(), cellcentres.end(), mesh->mCellCentres);
     
-    std::cout<< "mGridSize: " << wfs->mGridSize << std::endl;
-std::cout<< "mOrigin: " << wfs->mOrigin << std::endl;
-std::cout<< "mEnd: " << wfs->mEnd << std::endl;
-std::cout<< "mArraySize: " << wfs->mArraySize << std::endl;
-    
-    
-    
-    //List of indexes
-    int indexNumber = wfs->mArraySize.x * wfs->mArraySize.y * wfs->mArraySize.z;
+    //List of indexes (nearest cell centre for each stored grid point)
+    std::vector<Point3Int> gridpoints;
+    if (mBlockSize > 0) {
+    	// Two-level layout: only the stored grid points need an index
+    	std::vector<Cube> regions(mRefinementRegions);
+    	if (mSimulation->mObstacleList) {
+    		mSimulation->mObstacleList->GetCubes(regions);
+    	}
+    	mesh->mBlocks = new WindFieldBlockTable();
+    	mesh->mBlocks->Build(mesh->mOrigin, mesh->mGridSize, mesh->mArraySize, mBlockSize, regions, mRefinementMargin);
+    	mesh->mBlocks->GetSamplePoints(gridpoints);
+    } else {
+    	// All grid points (x varies fastest)
+    	gridpoints.reserve(mesh->mArraySize.Volume());
+    	for (int iz = 0; iz < mesh->mArraySize.z; iz++)
+    		for (int iy = 0; iy < mesh->mArraySize.y; iy++)
+    			for (int ix = 0; ix < mesh->mArraySize.x; ix++)
+    				gridpoints.push_back(Point3Int(ix, iy, iz));
+    }
+    int indexNumber = gridpoints.size();
     double distance = 0;
-    double minDistance = wfs->mCellCentres[0].Distance(wfs->mCellCentres[ctrPoint-1]);
-    int ctrIndex = 0;
-    wfs->mIndexTable = (int*) malloc (indexNumber * sizeof(int));
+    double minDistance = 0;
+    int *indextable = new int[indexNumber];
     
-    for (double c = wfs->mOrigin.z; c <= wfs->mEnd.z; c += wfs->mGridSize.z){
-    	for (double b = wfs->mOrigin.y; b <= wfs->mEnd.y; b += wfs->mGridSize.y){
-    		for (double a = wfs->mOrigin.x; a <= wfs->mEnd.x; a += wfs->mGridSize.x){
-    		//for each possible point in the area
-    			for (int i = 0; i < ctrPoint; i++){
-    				//search the nearest one in the cellcentres
-    				distance = Point3(a,b,c).Distance(wfs->mCellCentres[i]);
-					if (distance < minDistance){
-						minDistance = distance;
-						wfs->mIndexTable[ctrIndex] = i;
-					}
-					/*if (minDistance == 0)
-						continue;*/
-    			}
-    		ctrIndex ++;
-    		minDistance = wfs->mCellCentres[0].Distance(wfs->mCellCentres[ctrPoint-1]);
+    for (int ctrIndex = 0; (ctrIndex < indexNumber) && (ctrPoint > 0); ctrIndex++){
+    	//for each stored point in the area
+    	const Point3Int &p = gridpoints[ctrIndex];
+    	Point3 gridpoint = mesh->mOrigin + mesh->mGridSize.DotMultiply(p.x, p.y, p.z);
+    	indextable[ctrIndex] = 0;
+    	minDistance = gridpoint.Distance2(mesh->mCellCentres[0]);
+    	for (int i = 1; i < ctrPoint; i++){
+    		//search the nearest one in the cellcentres
+    		distance = gridpoint.Distance2(mesh->mCellCentres[i]);
+    		if (distance < minDistance){
+    			minDistance = distance;
+    			indextable[ctrIndex] = i;
     		}
     	}
     }
+    mesh->SetIndexTable(indextable);
 
-  	/*//write in a file
-  	std::ofstream myfile;
-	myfile.open("/home/rahbar/Desktop/index.txt", std::ios::app);
-	for(int k=0; k<ctrIndex; k++)
-		myfile << wfs->mIndexTable[k] << "\n";
-	myfile.close();*/
-    
     //TODO send an error in case we don't have any point!
-std::cout<< "mGridSize: " << wfs->mGridSize << std::endl;
-std::cout<< "mOrigin: " << wfs->mOrigin << std::endl;
-std::cout<< "mEnd: " << wfs->mEnd << std::endl;
-std::cout<< "mArraySize: " << wfs->mArraySize << std::endl;
-//std::cout << "WindFieldDynamic windSnapshotMemoryAllocation END" << std::endl;
+
+    // Memory Allocation for wind snapshot
+    wfs->SetMesh(mesh);
 }
@@ -7,9 +7,14 @@
 class WindFieldDynamic;
 
 #include <string>
+#include <vector>
 #include "Point3.h"
 #include "WindField.h"
 #include "WindFieldSnapshot.h"
+#include "DataFileReaderWindSequence.h"
+#include "WindFieldCatalog.h"
+#include "WindFieldTimeInterpolation.h"
+#include "WindFieldSharedStore.h"
 
 //!	WindFieldDynamic
 class WindFieldDynamic: public WindField {
@@ -17,33 +22,153 @@ class WindFieldDynamic: public WindField {
 protected:
 	//! The folder containing the samples.
 	std::string mSamplesFolder;
-	//! Wind field snapshots.
-	WindFieldSnapshot *mWindFieldSnapshot[2];
+	//! The maximum number of snapshots kept in memory.
+	static const int mRingMax = 4;
+	//! Wind field snapshots, sorted by time (the current time lies between snapshots mRingSize / 2 - 1 and mRingSize / 2).
+	WindFieldSnapshot *mWindFieldSnapshot[mRingMax];
+	//! Whether a snapshot contains data (snapshots before the first and after the last sample do not).
+	bool mSnapshotValid[mRingMax];
+	//! The number of snapshots in use (2 for linear, 4 for cubic time interpolation).
+	int mRingSize;
 
-	//! The size of the file heap.
-	static const int mFileHeapMax = 3224;
-	//! The file heap.
-	double mFileHeap[mFileHeapMax];
-	//! The number of files in the heap.
-	int mFileHeapCount;
+	//! The snapshot times available in the samples folder.
+	WindFieldCatalog mCatalog;
+	//! The index of the next catalog entry to read.
+	int mCatalogNext;
+	//! The snapshot time corresponding to the beginning of the simulation.
+	double mStartTime;
 
-	//! Reads the next file.
+	//! The compressed snapshot sequence (see DataFileWriterWindSequence). If empty, the samples are read from the text files in the samples folder.
+	std::string mSequenceFile;
+	//! The reader of the compressed snapshot sequence.
+	DataFileReaderWindSequence *mSequence;
+
+	//! Whether the sequence is played in a loop.
+	bool mLoop;
+	//! The beginning of the loop window.
+	double mLoopStart;
+	//! The end of the loop window.
+	double mLoopEnd;
+	//! The duration of the cross-fade at the end of the loop window.
+	double mLoopFade;
+	//! The snapshots of the loop window (and the ones needed around it), sorted by time. These are read once and kept in memory.
+	std::vector<WindFieldSnapshot*> mResident;
+	//! The times of the resident snapshots.
+	std::vector<double> mResidentTimes;
+
+	//! The name of the shared memory segment (empty if the wind field is not shared).
+	std::string mSharedName;
+	//! The shared memory segment.
+	WindFieldSharedStore *mShared;
+	//! Returns the key of the settings that determine the shared data (samples with the modification time and size of the sequence file or of the catalog and cell centres, storage, interpolation, refinement around the regions and obstacles, and loop window), so that a segment written with other settings is not used.
+	unsigned long long GetSharedKey() const;
+	//! Uses the shared mesh for the snapshots of the ring.
+	void AttachSharedMesh();
+	//! Uses the shared loop window snapshots.
+	void AttachSharedWindow();
+
+	//! Reads the next file (or sequence frame) into the cell buffer, and resamples it on the grid of a snapshot. Returns false if there are no more files.
+	bool ReadSnapshot(WindFieldSnapshot *wfs);
+	//! Reads the snapshots of the loop window.
+	bool ReadLoopWindow();
+	//! Maps the simulation time onto the loop window.
+	double LoopTime(double time) const;
+	//! Reads the next file into the oldest snapshot, which then becomes the newest one. Returns false if there are no more files (the newest snapshot is then marked invalid).
 	bool ReadNextFile();
+	//! Reads files until the current time lies within the interpolation interval. Returns false at the end of the samples.
+	bool Advance(double time);
+	//! Computes the snapshot weights for the current time.
+	void UpdateWeights(double time);
+	//! Appends the snapshots of a stencil (see WindFieldTimeInterpolation) and their weights, multiplied by scale, to the blend list.
+	void AddBlend(const WindFieldSnapshot * const *stencil, const bool *valid, double time, double scale);
+	//! Appends the resident snapshots around time to the blend list.
+	void AddResidentBlend(double time, double scale);
 
-	//! The interpolation factor for combining the vectors of snapshot 1 and 2
-	double mTimeInterpolationFactor;
+	//! The time interpolation mode.
+	WindFieldTimeInterpolation::eMode mTimeInterpolation;
+	//! The maximum number of snapshots combined at a time (two stencils during a cross-fade).
+	static const int mBlendMax = 2 * mRingMax;
+	//! The snapshots combined at the current time.
+	const WindFieldSnapshot *mBlendSnapshots[mBlendMax];
+	//! The weights of the snapshots combined at the current time.
+	double mBlendWeights[mBlendMax];
+	//! The number of snapshots combined at the current time.
+	int mBlendCount;
+	//! The cell wind speeds of the file being read. They are shared by all snapshots, which only keep their resampled grid.
+	WindFieldSnapshot *mCellSnapshot;
+	//! The spatial interpolation mode of the snapshots.
+	WindFieldSnapshot::eInterpolation mInterpolation;
+	//! The storage format of the snapshots.
+	WindFieldSnapshot::eStorage mStorage;
+	//! The block size of the two-level grid layout (0 to store the full grid).
+	int mBlockSize;
+	//! The distance around obstacles and refinement regions within which blocks are refined.
+	double mRefinementMargin;
+	//! Regions (in addition to the obstacles) in which blocks are refined.
+	std::vector<Cube> mRefinementRegions;
 
 public:
 	//! Constructor.
 	WindFieldDynamic(Simulation *sim);
 	//! Destructor.
-	~WindFieldDynamic() {}
+	~WindFieldDynamic() {
+		delete mSequence;
+		for (int i = 0; i < mRingMax; i++) {
+			delete mWindFieldSnapshot[i];
+		}
+		delete mCellSnapshot;
+		for (unsigned int i = 0; i < mResident.size(); i++) {
+			delete mResident[i];
+		}
+		delete mShared;
+	}
 
 	//! Sets the folder containing the samples. The samples are supposed to be in a subfolder named after the corresponding simulation time.
 	bool SetFolder(const std::string &folder) {
 		mSamplesFolder = folder;
 		return true;
 	}
+	//! Sets the snapshot time at which the simulation starts. Earlier snapshots are skipped (compressed sequences are decoded up to the start time, since their frames are stored as differences). This must be called before the simulation starts.
+	void SetStartTime(double set) {
+		mStartTime = set;
+	}
+	//! Plays the snapshots between start and end in a loop. At the end of each pass, the wind field fades over the last fade seconds into the beginning of the window (fade must not exceed half the window). All snapshots of the window (and from the start time on, if this is earlier) are read at the beginning and kept in memory. This must be called before the simulation starts.
+	void SetLoop(double start, double end, double fade) {
+		mLoop = true;
+		mLoopStart = start;
+		mLoopEnd = end;
+		mLoopFade = fade;
+	}
+	//! Shares the mesh (grid geometry and index table) and the loop window with other processes through a named shared memory segment (see WindFieldSharedStore). The first process reads the samples, all others attach to its data and skip the cell centres file. This must be called before the simulation starts.
+	void SetSharedMemory(const std::string &name) {
+		mSharedName = name;
+	}
+	//! Reads the snapshots from a compressed sequence file instead of the text files in the samples folder. The cell centres are still read from the samples folder.
+	bool SetSequenceFile(const std::string &file) {
+		mSequenceFile = file;
+		return true;
+	}
+	//! Sets the spatial interpolation mode (nearest grid point or trilinear). This must be called before the simulation starts.
+	void SetInterpolation(WindFieldSnapshot::eInterpolation set) {
+		mInterpolation = set;
+	}
+	//! Sets the time interpolation mode (linear between 2 snapshots, or cubic over 4 snapshots). This must be called before the simulation starts.
+	void SetTimeInterpolation(WindFieldTimeInterpolation::eMode set) {
+		mTimeInterpolation = set;
+	}
+	//! Sets the storage format of the snapshots (double or quantized int16, which uses a quarter of the memory). This must be called before the simulation starts.
+	void SetStorage(WindFieldSnapshot::eStorage set) {
+		mStorage = set;
+	}
+	//! Stores the grid with a two-level layout (see WindFieldBlockTable): blocks of blocksize grid intervals are kept at full resolution within margin of the obstacles and of the refinement regions, and only their corners elsewhere. The index table is only computed for the stored grid points, which also shortens the start-up. This must be called before the simulation starts.
+	void SetRefinement(int blocksize, double margin) {
+		mBlockSize = blocksize;
+		mRefinementMargin = margin;
+	}
+	//! Adds a region (e.g. around an odor source) in which the grid is kept at full resolution.
+	void AddRefinementRegion(const Cube &region) {
+		mRefinementRegions.push_back(region);
+	}
 
 	// WindField methods.
 	void OnSimulationStart();
@@ -51,7 +176,13 @@ public:
 	void OnSimulationStep();
 	void OnWebotsPhysicsDraw() {}
 	Point3 GetWindSpeed(const Point3 &preal);
+	void GetWindSpeeds(const Point3 *in, Point3 *out, int n);
+	double GetResolution();
 	void WriteConfiguration(std::ostream &out);
+	//! Continues at the snapshot time stored in the checkpoint (the start time is adjusted accordingly). Compressed sequences can only be decoded forward, and are advanced from their current frame.
+	void Read(DataFileReader &f);
+	//! Writes the current snapshot time.
+	void Write(DataFileWriter &f);
 	
 	void windSnapshotMemoryAllocation(WindFieldSnapshot *wfs);
 };
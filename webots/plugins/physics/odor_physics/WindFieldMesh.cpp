@@ -0,0 +1,147 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#include <string.h>
+#include <vector>
+#include "WindFieldMesh.h"
+#define	THISCLASS WindFieldMesh
+
+THISCLASS::WindFieldMesh():
+		mReferences(0), mArraySize(), mOrigin(), mEnd(), mGridSize(), mGridSizeInv(), mCellCount(0), mCellCentres(NULL), mIndexTable(NULL), mBlocks(NULL), mSharedIndexTable(false) {
+}
+
+THISCLASS::~WindFieldMesh() {
+	FreeCells();
+	delete mBlocks;
+}
+
+void THISCLASS::SetGrid(const Point3 &origin, const Point3 &gridsize, const Point3Int &arraysize) {
+	mOrigin = origin;
+	mGridSize = gridsize;
+	mGridSizeInv = gridsize.DotInv();
+	mArraySize = arraysize;
+	mEnd = origin + gridsize.DotMultiply(Point3(arraysize.x - 1, arraysize.y - 1, arraysize.z - 1));
+}
+
+void THISCLASS::SetIndexTable(int *table) {
+	if (! mSharedIndexTable) {
+		delete [] mIndexTable;
+	}
+	mIndexTable = table;
+	mSharedIndexTable = false;
+}
+
+void THISCLASS::SetBlockTable(WindFieldBlockTable *blocks) {
+	// Map each sample to its cell (through the old index table, or directly if every grid point is a cell)
+	if (blocks) {
+		std::vector<Point3Int> points;
+		blocks->GetSamplePoints(points);
+		int *table = new int[points.size()];
+		for (unsigned int s = 0; s < points.size(); s++) {
+			int i = GridIndex(points[s]);
+			table[s] = mIndexTable ? mIndexTable[i] : i;
+		}
+		SetIndexTable(table);
+	}
+	delete mBlocks;
+	mBlocks = blocks;
+}
+
+void THISCLASS::FreeCells() {
+	delete [] mCellCentres;
+	mCellCentres = NULL;
+	SetIndexTable(NULL);
+}
+
+int THISCLASS::GridIndex(const Point3Int &p) const {
+	if (mBlocks) {
+		int index, dx, dy, dz;
+		Point3 t;
+		mBlocks->Stencil(p.x, p.y, p.z, false, index, dx, dy, dz, t);
+		return index;
+	}
+	return p.x + mArraySize.x * (p.y + mArraySize.y * p.z);
+}
+
+double THISCLASS::GetMinGridSize() const {
+	double size = 0;
+	if ((mArraySize.x > 1) && ((size == 0) || (mGridSize.x < size))) {
+		size = mGridSize.x;
+	}
+	if ((mArraySize.y > 1) && ((size == 0) || (mGridSize.y < size))) {
+		size = mGridSize.y;
+	}
+	if ((mArraySize.z > 1) && ((size == 0) || (mGridSize.z < size))) {
+		size = mGridSize.z;
+	}
+	return size;
+}
+
+size_t THISCLASS::GetMemorySize() const {
+	size_t size = sizeof(WindFieldMesh);
+	if (mCellCentres) {
+		size += sizeof(Point3) * mCellCount;
+	}
+	if (mIndexTable && (! mSharedIndexTable)) {
+		size += sizeof(int) * GetGridPointCount();
+	}
+	if (mBlocks) {
+		size += mBlocks->GetSharedSize();
+	}
+	return size;
+}
+
+// The block table (if any) follows the header, and the index table follows the block table.
+size_t THISCLASS::GetSharedSize() const {
+	return sizeof(tShared) + (mBlocks ? mBlocks->GetSharedSize() : 0) + (mIndexTable ? sizeof(int) * GetGridPointCount() : 0);
+}
+
+void THISCLASS::WriteShared(void *dst) const {
+	tShared *header = (tShared*)dst;
+	header->cellcount = mCellCount;
+	header->arraysize[0] = mArraySize.x;
+	header->arraysize[1] = mArraySize.y;
+	header->arraysize[2] = mArraySize.z;
+	header->indextable = (mIndexTable ? 1 : 0);
+	header->origin[0] = mOrigin.x;
+	header->origin[1] = mOrigin.y;
+	header->origin[2] = mOrigin.z;
+	header->end[0] = mEnd.x;
+	header->end[1] = mEnd.y;
+	header->end[2] = mEnd.z;
+	header->gridsize[0] = mGridSize.x;
+	header->gridsize[1] = mGridSize.y;
+	header->gridsize[2] = mGridSize.z;
+	header->blocks = (mBlocks ? (int)mBlocks->GetSharedSize() : 0);
+	char *data = (char*)(header + 1);
+	if (mBlocks) {
+		mBlocks->WriteShared(data);
+		data += header->blocks;
+	}
+	if (mIndexTable) {
+		memcpy(data, mIndexTable, sizeof(int) * GetGridPointCount());
+	}
+}
+
+void THISCLASS::AttachShared(const void *src) {
+	const tShared *header = (const tShared*)src;
+	FreeCells();
+	mCellCount = header->cellcount;
+	mArraySize = Point3Int(header->arraysize[0], header->arraysize[1], header->arraysize[2]);
+	mOrigin = Point3(header->origin[0], header->origin[1], header->origin[2]);
+	mEnd = Point3(header->end[0], header->end[1], header->end[2]);
+	mGridSize = Point3(header->gridsize[0], header->gridsize[1], header->gridsize[2]);
+	mGridSizeInv = mGridSize.DotInv();
+	const char *data = (const char*)(header + 1);
+	delete mBlocks;
+	mBlocks = NULL;
+	if (header->blocks) {
+		mBlocks = new WindFieldBlockTable();
+		mBlocks->ReadShared(data);
+		data += header->blocks;
+	}
+
+	// The index table is only read, and can therefore point into the shared memory
+	mIndexTable = (header->indextable ? (int*)data : NULL);
+	mSharedIndexTable = true;
+}
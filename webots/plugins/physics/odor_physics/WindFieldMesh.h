@@ -0,0 +1,165 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classWindFieldMesh
+#define classWindFieldMesh
+
+class WindFieldMesh;
+
+#include <stddef.h>
+#include "Point3.h"
+#include "Point3Int.h"
+#include "WindFieldBlockTable.h"
+
+//!	Geometry shared by the snapshots of a wind field: the regular grid, the cells and the mapping between them.
+/*!
+	All snapshots of a time series use the same mesh and only differ in their wind speeds. The mesh is therefore stored once, and reference counted: WindFieldSnapshot::SetMesh retains it, and the snapshot releases it when it is destroyed or gets another mesh. A mesh is deleted when its last snapshot releases it.
+	Modifying a mesh (e.g. SetBlockTable) affects all snapshots using it.
+*/
+class WindFieldMesh {
+
+protected:
+	//! The number of snapshots using this mesh.
+	int mReferences;
+
+	//! Layout of the shared mesh.
+	struct tShared {
+		int cellcount;
+		int arraysize[3];
+		int indextable;
+		int blocks;
+		double origin[3];
+		double end[3];
+		double gridsize[3];
+	};
+
+public:
+	//! Dimensions of the regular grid.
+	Point3Int mArraySize;
+	//! Origin of the regular grid.
+	Point3 mOrigin;
+	//! Last grid point.
+	Point3 mEnd;
+	//! Distance between grid points.
+	Point3 mGridSize;
+	//! Inverse of mGridSize (precomputed for the index computation).
+	Point3 mGridSizeInv;
+	//! Number of cells (measurements).
+	int mCellCount;
+	//! Centre of each cell (NULL if unknown).
+	Point3 *mCellCentres;
+	//! Nearest cell of each stored grid point (NULL if every grid point is a cell).
+	int *mIndexTable;
+	//! Two-level layout of the grid, or NULL if every grid point is stored.
+	WindFieldBlockTable *mBlocks;
+	//! Whether the index table is read-only memory shared with other processes (see AttachShared).
+	bool mSharedIndexTable;
+
+	//! Constructor. The mesh is not referenced by any snapshot yet.
+	WindFieldMesh();
+	//! Destructor.
+	~WindFieldMesh();
+
+	//! Adds a reference.
+	void Retain() {
+		mReferences++;
+	}
+	//! Removes a reference, and deletes the mesh if it was the last one.
+	void Release() {
+		mReferences--;
+		if (mReferences <= 0) {
+			delete this;
+		}
+	}
+	//! Returns the number of snapshots using this mesh.
+	int GetReferences() const {
+		return mReferences;
+	}
+
+	//! Sets the regular grid.
+	void SetGrid(const Point3 &origin, const Point3 &gridsize, const Point3Int &arraysize);
+	//! Replaces the index table (allocated with new[], or NULL), which is then owned by the mesh.
+	void SetIndexTable(int *table);
+	//! Replaces the block table (or NULL), which is then owned by the mesh. The index table is reduced to the stored grid points.
+	void SetBlockTable(WindFieldBlockTable *blocks);
+	//! Releases the cell centres and the index table, which are only needed to resample the cells.
+	void FreeCells();
+	//! Returns the number of stored grid points (samples of the block table, or all grid points).
+	int GetGridPointCount() const {
+		return mBlocks ? mBlocks->GetSampleCount() : mArraySize.Volume();
+	}
+	//! Returns the smallest grid spacing (ignoring axes with a single grid point), or 0 if the grid has a single point.
+	double GetMinGridSize() const;
+	//! Returns the number of bytes used by the mesh.
+	size_t GetMemorySize() const;
+
+	//! Computes the stored grid index (nearest point, or base point for trilinear interpolation), the offsets to the neighbouring grid points and the interpolation factors of a point. Returns false if the point is outside the grid.
+	inline bool GridStencil(const Point3 &preal, bool trilinear, int &index, int &dx, int &dy, int &dz, Point3 &t) const;
+	//! Returns the stored grid index of a regular grid point.
+	int GridIndex(const Point3Int &p) const;
+
+	//! Returns the number of bytes needed to share the mesh (grid geometry, number of cells, block table and index table).
+	size_t GetSharedSize() const;
+	//! Writes the mesh to shared memory.
+	void WriteShared(void *dst) const;
+	//! Uses a mesh written by WriteShared (possibly by another process). The index table is not copied, so the memory must stay valid. The cell centres are not shared.
+	void AttachShared(const void *src);
+};
+
+// Returns the nearest grid index along one axis (f is the continuous grid coordinate).
+static inline int NearestGridIndex(double f, int n) {
+	if (f <= 0) {
+		return 0;
+	}
+	int i = (int)(f + 0.5);
+	return (i < n) ? i : n - 1;
+}
+
+// Returns the lower grid index of the interpolation interval along one axis, and the interpolation factor t in [0, 1].
+static inline int LowerGridIndex(double f, int n, double &t) {
+	if ((n < 2) || (f <= 0)) {
+		t = 0;
+		return 0;
+	}
+	if (f >= n - 1) {
+		t = 1;
+		return n - 2;
+	}
+	int i = (int)f;
+	t = f - i;
+	return i;
+}
+
+inline bool WindFieldMesh::GridStencil(const Point3 &preal, bool trilinear, int &index, int &dx, int &dy, int &dz, Point3 &t) const {
+	// Continuous grid coordinates (positions below the origin are clamped, positions beyond the last cell are outside)
+	double fx = (preal.x - mOrigin.x) * mGridSizeInv.x;
+	double fy = (preal.y - mOrigin.y) * mGridSizeInv.y;
+	double fz = (preal.z - mOrigin.z) * mGridSizeInv.z;
+	if ((fx > mArraySize.x - 0.5) || (fy > mArraySize.y - 0.5) || (fz > mArraySize.z - 0.5)) {
+		return false;
+	}
+
+	// Two-level layout
+	if (mBlocks) {
+		mBlocks->Stencil(fx, fy, fz, trilinear, index, dx, dy, dz, t);
+		return true;
+	}
+
+	// Offsets from the base grid point to its neighbours
+	dx = (mArraySize.x > 1) ? 1 : 0;
+	dy = (mArraySize.y > 1) ? mArraySize.x : 0;
+	dz = (mArraySize.z > 1) ? mArraySize.x * mArraySize.y : 0;
+
+	if (! trilinear) {
+		index = NearestGridIndex(fx, mArraySize.x) + mArraySize.x * (NearestGridIndex(fy, mArraySize.y) + mArraySize.y * NearestGridIndex(fz, mArraySize.z));
+		return true;
+	}
+
+	int ix = LowerGridIndex(fx, mArraySize.x, t.x);
+	int iy = LowerGridIndex(fy, mArraySize.y, t.y);
+	int iz = LowerGridIndex(fz, mArraySize.z, t.z);
+	index = ix + mArraySize.x * (iy + mArraySize.y * iz);
+	return true;
+}
+
+#endif
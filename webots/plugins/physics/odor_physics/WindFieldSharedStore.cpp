@@ -0,0 +1,229 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#include "WindFieldSharedStore.h"
+#define THISCLASS WindFieldSharedStore
+
+#include <atomic>
+#include <sstream>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Segment header, followed by the block table and the blocks. The magic is written last when the segment is created, and ready when it is published.
+struct THISCLASS::tHeader {
+	std::atomic<int> magic;
+	int version;
+	std::atomic<int> ready;
+	int count;
+	long long size;
+	unsigned long long key;
+	int pid;
+};
+
+static const int cMagic = 0x4D485357; // WSHM
+static const int cVersion = 2;
+static const size_t cAlignment = 16;
+
+// Rounds up to the block alignment.
+static inline size_t Align(size_t size) {
+	return (size + cAlignment - 1) & ~(cAlignment - 1);
+}
+
+THISCLASS::WindFieldSharedStore():
+		mName(), mFd(-1), mCreator(false), mMemory(NULL), mSize(0), mPending() {
+
+}
+
+THISCLASS::~WindFieldSharedStore() {
+	// A creator that did not publish removes the segment, so that other processes do not wait for it
+	if (mCreator && (! mMemory)) {
+		shm_unlink(mName.c_str());
+	}
+	if (mMemory) {
+		munmap(mMemory, mSize);
+	}
+	if (mFd >= 0) {
+		close(mFd);
+	}
+}
+
+bool THISCLASS::Open(const std::string &name, unsigned long long key, double timeout) {
+	mName = (name[0] == '/' ? name : "/" + name);
+
+	for (int attempt = 0; attempt < 2; attempt++) {
+		// The first process creates the segment
+		mFd = shm_open(mName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+		if (mFd >= 0) {
+			mCreator = true;
+			if (Create(key)) {
+				return true;
+			}
+			shm_unlink(mName.c_str());
+			mCreator = false;
+			return false;
+		}
+		if (errno != EEXIST) {
+			return false;
+		}
+
+		// All other processes wait until the creator has published the data
+		mFd = shm_open(mName.c_str(), O_RDONLY, 0);
+		if (mFd < 0) {
+			return false;
+		}
+		eAttach result = Attach(key, timeout);
+		if (result != sAttachStale) {
+			return (result == sAttachOk);
+		}
+
+		// Replace a segment with other settings, or left behind by a crashed creator
+		close(mFd);
+		mFd = -1;
+		shm_unlink(mName.c_str());
+	}
+	return false;
+}
+
+bool THISCLASS::Create(unsigned long long key) {
+	if (ftruncate(mFd, sizeof(tHeader)) != 0) {
+		return false;
+	}
+	tHeader *header = (tHeader*)mmap(NULL, sizeof(tHeader), PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+	if (header == MAP_FAILED) {
+		return false;
+	}
+	header->version = cVersion;
+	header->ready.store(0, std::memory_order_relaxed);
+	header->count = 0;
+	header->size = sizeof(tHeader);
+	header->key = key;
+	header->pid = getpid();
+	header->magic.store(cMagic, std::memory_order_release);
+	munmap((void*)header, sizeof(tHeader));
+	return true;
+}
+
+THISCLASS::eAttach THISCLASS::Attach(unsigned long long key, double timeout) {
+	for (double waited = 0; waited <= timeout; waited += 0.01) {
+		struct stat st;
+		if ((fstat(mFd, &st) == 0) && (st.st_size >= (off_t)sizeof(tHeader))) {
+			const tHeader *header = (const tHeader*)mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, mFd, 0);
+			if (header == MAP_FAILED) {
+				return sAttachFailed;
+			}
+
+			// The creator may not have written the header yet
+			int magic = header->magic.load(std::memory_order_acquire);
+			if (magic != 0) {
+				if ((magic != cMagic) || (header->version != cVersion) || (header->key != key)) {
+					munmap((void*)header, st.st_size);
+					return sAttachStale;
+				}
+				if (header->ready.load(std::memory_order_acquire) && (st.st_size >= header->size)) {
+					mMemory = (void*)header;
+					mSize = st.st_size;
+					return sAttachOk;
+				}
+				if ((kill(header->pid, 0) != 0) && (errno == ESRCH)) {
+					munmap((void*)header, st.st_size);
+					return sAttachStale;
+				}
+			}
+			munmap((void*)header, st.st_size);
+		}
+		usleep(10000);
+	}
+	return sAttachFailed;
+}
+
+void *THISCLASS::Add(size_t size) {
+	mPending.push_back(std::vector<char>(size));
+	return (size > 0 ? &mPending.back()[0] : NULL);
+}
+
+bool THISCLASS::Publish() {
+	if ((! mCreator) || mMemory) {
+		return false;
+	}
+
+	// Layout
+	int count = (int)mPending.size();
+	size_t size = Align(sizeof(tHeader) + count * sizeof(tBlock));
+	std::vector<tBlock> blocks(count);
+	for (int i = 0; i < count; i++) {
+		blocks[i].offset = size;
+		blocks[i].size = mPending[i].size();
+		size += Align(mPending[i].size());
+	}
+
+	// Map the segment and copy the data
+	void *memory = MAP_FAILED;
+	if (ftruncate(mFd, size) == 0) {
+		memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+	}
+	if (memory == MAP_FAILED) {
+		shm_unlink(mName.c_str());
+		mCreator = false;
+		return false;
+	}
+	tHeader *header = (tHeader*)memory;
+	header->count = count;
+	header->size = size;
+	if (count > 0) {
+		memcpy((void*)(header + 1), &blocks[0], count * sizeof(tBlock));
+	}
+	for (int i = 0; i < count; i++) {
+		if (! mPending[i].empty()) {
+			memcpy((char*)memory + blocks[i].offset, &mPending[i][0], mPending[i].size());
+		}
+	}
+	mPending.clear();
+
+	mMemory = memory;
+	mSize = size;
+	header->ready.store(1, std::memory_order_release);
+	return true;
+}
+
+int THISCLASS::GetCount() const {
+	return (mMemory ? ((const tHeader*)mMemory)->count : 0);
+}
+
+const void *THISCLASS::Get(int i) const {
+	const tBlock *blocks = (const tBlock*)((const tHeader*)mMemory + 1);
+	return (const char*)mMemory + blocks[i].offset;
+}
+
+size_t THISCLASS::GetSize(int i) const {
+	const tBlock *blocks = (const tBlock*)((const tHeader*)mMemory + 1);
+	return blocks[i].size;
+}
+
+unsigned long long THISCLASS::GetKey(const std::string &settings) {
+	unsigned long long hash = 14695981039346656037ULL;
+	for (unsigned int i = 0; i < settings.size(); i++) {
+		hash ^= (unsigned char)settings[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+std::string THISCLASS::GetFileStamp(const std::string &filename) {
+	struct stat st;
+	if (stat(filename.c_str(), &st) != 0) {
+		return "";
+	}
+	std::ostringstream stamp;
+	stamp << (long long)st.st_mtime << " " << (long long)st.st_size;
+	return stamp.str();
+}
+
+void THISCLASS::Remove(const std::string &name) {
+	std::string n = (name[0] == '/' ? name : "/" + name);
+	shm_unlink(n.c_str());
+}
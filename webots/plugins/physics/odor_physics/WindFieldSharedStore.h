@@ -0,0 +1,87 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classWindFieldSharedStore
+#define classWindFieldSharedStore
+
+class WindFieldSharedStore;
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+//!	Read-only wind data shared between processes through a named POSIX shared memory segment.
+/*!
+	The first process opening a segment becomes its creator: it adds the data blocks (see WindFieldSnapshot::WriteShared) and publishes them. All other processes attach to the segment read-only, and wait until it has been published.
+	The segment outlives the processes, so that later simulations attach immediately. It appears as /dev/shm/<name> on Linux.
+	The header holds a key of the settings the data was created with (see WindFieldDynamic), and the process ID of the creator. A segment with another key, or whose creator died before publishing, is removed and created again.
+*/
+class WindFieldSharedStore {
+
+protected:
+	//! The segment header.
+	struct tHeader;
+	//! A block entry.
+	struct tBlock {
+		long long offset;
+		long long size;
+	};
+
+	//! The name of the segment.
+	std::string mName;
+	//! The file descriptor of the segment.
+	int mFd;
+	//! Whether this process created the segment.
+	bool mCreator;
+	//! The mapped segment.
+	void *mMemory;
+	//! The size of the mapped segment.
+	size_t mSize;
+	//! The blocks added by the creator (before publishing).
+	std::vector<std::vector<char> > mPending;
+
+	//! The result of Attach.
+	enum eAttach {
+		sAttachOk,
+		sAttachFailed,
+		sAttachStale
+	};
+	//! Writes the header of a newly created segment (with ready = 0). Returns false on error.
+	bool Create(unsigned long long key);
+	//! Waits at most timeout seconds until the segment has been published. Returns sAttachStale if the segment was created with another key, or if its creator died before publishing.
+	eAttach Attach(unsigned long long key, double timeout);
+
+public:
+	//! Constructor.
+	WindFieldSharedStore();
+	//! Destructor. Unmaps the segment (but does not remove it).
+	~WindFieldSharedStore();
+
+	//! Creates or attaches to the segment. The key identifies the settings of the data (see GetKey), and a segment with another key is replaced. An attaching process waits at most timeout seconds for the creator to publish the data. Returns false on error or timeout.
+	bool Open(const std::string &name, unsigned long long key, double timeout = 60);
+	//! Returns true if this process created the segment, and must therefore add and publish the data.
+	bool IsCreator() const {
+		return mCreator;
+	}
+
+	//! Adds a block of the given size (creator only), and returns a pointer to write its content to.
+	void *Add(size_t size);
+	//! Publishes the added blocks (creator only). Returns false on error.
+	bool Publish();
+
+	//! Returns the number of blocks (after publishing or attaching).
+	int GetCount() const;
+	//! Returns a block (after publishing or attaching).
+	const void *Get(int i) const;
+	//! Returns the size of a block.
+	size_t GetSize(int i) const;
+
+	//! Removes a segment.
+	static void Remove(const std::string &name);
+	//! Returns a key (64-bit FNV-1a hash) of a text describing the settings of the data.
+	static unsigned long long GetKey(const std::string &settings);
+	//! Returns the modification time and the size of a file as text (or an empty string if the file does not exist). Adding this to the settings of GetKey replaces the segment when the file is regenerated.
+	static std::string GetFileStamp(const std::string &filename);
+};
+
+#endif
@@ -2,6 +2,8 @@
 // Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
 
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <fstream>
 #include <iostream>
 #include <chrono>
@@ -9,7 +11,7 @@
 #include <algorithm>
 #include <cstdlib>
 #include "WindFieldSnapshot.h"
-#include "TextFileReaderDouble.h"
+#include "TextFileReaderWindGrid.h"
 #include "DataFileReader.h"
 #include "DataFileWriter.h"
 #define	THISCLASS WindFieldSnapshot
@@ -18,278 +20,448 @@ using namespace std;
 using namespace std::chrono;
 
 THISCLASS::WindFieldSnapshot():
-		mTime(0), mWind(NULL), mArraySize(), mOrigin(), mGridSize() {
+		mTime(0), mWind(NULL), mMesh(new WindFieldMesh()), mGridWind(NULL), mGridWindCount(0), mInterpolation(sInterpolationNearest),
+		mStorage(sStorageDouble), mGridWindQ(NULL), mQuantizationStep(), mQuantizationErrorMax(0), mQuantizationErrorRMS(0), mSharedGrid(false) {
 
+	mMesh->Retain();
 }
 
 THISCLASS::~WindFieldSnapshot() {
-	free(mWind);
-	AllocateArray(Point3Int(0, 0, 0));
-	free(mCellCentres);
+	delete [] mWind;
+	mMesh->Release();
+	FreeGrid();
+}
+
+void THISCLASS::FreeGrid() {
+	if (! mSharedGrid) {
+		delete [] mGridWind;
+		delete [] mGridWindQ;
+	}
+	mGridWind = NULL;
+	mGridWindQ = NULL;
+	mGridWindCount = 0;
+	mSharedGrid = false;
+}
+
+void THISCLASS::FreeCells() {
+	delete [] mWind;
+	mWind = NULL;
+	if (mMesh->GetReferences() == 1) {
+		mMesh->FreeCells();
+	}
 }
 
 void THISCLASS::WindFieldSnapshotCopy(WindFieldSnapshot &W1){
 	mTime = W1.mTime;
-	mArraySize = W1.mArraySize;
-	mOrigin = W1.mOrigin;	
-	mEnd = W1.mEnd;
-	mGridSize = W1.mGridSize;
-	mCellNbr = W1.mCellNbr;
-	
-	// mCellCentres
-	if(W1.mCellCentres != NULL){
-		mCellCentres = (Point3*) malloc (mCellNbr * sizeof(Point3));
-		for(int i=0; i<mCellNbr; i++)
-			mCellCentres[i] = W1.mCellCentres[i];
-	}
-	// mIndexTable
-	if(W1.mIndexTable != NULL){
-		int indexNumber = mArraySize.x * mArraySize.y * mArraySize.z;
-		mIndexTable = (int*) malloc (indexNumber * sizeof(int));
-		for(int i=0; i<indexNumber; i++)
-			mIndexTable[i] = W1.mIndexTable[i];
-	}
-	// mWind
-	AllocateArray(mCellNbr);
-}
+	mInterpolation = W1.mInterpolation;
+	mStorage = W1.mStorage;
 
-void THISCLASS::AllocateArray(const Point3Int &arraysize) {
-	//std::cout << "arraysize = " << arraysize << std::endl;
-	/*if (arraysize == mArraySize) {
-		return;
-	}*/
-	// Delete old array
-	if (mWind) {
-		delete [] mWind;
-		mWind = NULL;
-	}
-	// Create new array
-	//int cc = mArraySize.Volume();
-	int cc = arraysize.Volume(); //Fa
-	//std::cout << "cc=" << cc << std::endl;
-	if (cc > 0) {
-		mArraySize = arraysize;
-		//mWind = new Point3[cc];
-		mWind = (Point3 *)malloc(cc*sizeof(Point3));
-		//sizeof(double)=8; sizeof(Point3)=24; sizeof(Point3*)=8; sizeof(Point3[cc])=24*cc
-	}
-	std::cout << "Wind Field Memory allocated : " << cc << std::endl;
+	// The mesh is shared, only the resampled grid is per snapshot
+	SetMesh(W1.mMesh, false);
 }
 
-void THISCLASS::AllocateArray(const int &arraysize) { //Fa
-	//std::cout << "(FA) arraysize = " << arraysize << std::endl;
-	/*if (arraysize == mArraySize.Volume()) {
-		return;
-	}*/
-	// Delete old array
-	if (mWind) {
-		delete [] mWind;
-		mWind = NULL;
-	}
-	// Create new array
-	//int cc = mArraySize.Volume();
-	int cc = arraysize; //Fa
-	//std::cout << "cc=" << cc << std::endl;
-	if (cc > 0) {
-		//mArraySize = arraysize;
-		//mWind = new Point3[cc];
-		mWind = (Point3*) malloc (cc * sizeof(Point3));
-		//sizeof(double)=8; sizeof(Point3)=24; sizeof(Point3*)=8; sizeof(Point3[cc])=24*cc
-	}
-	std::cout << "Wind Field Memory allocated : " << cc << std::endl;
+void THISCLASS::SetMesh(WindFieldMesh *mesh, bool cells) {
+	mesh->Retain();
+	mMesh->Release();
+	mMesh = mesh;
+	AllocateArray(cells ? mMesh->mCellCount : 0);
 }
 
-int THISCLASS::XYZToI(const Point3 &p) const {
-	//int i = 0;
-	//double distance = 0;
-	//double minDistance = mCellCentres[0].Distance(mCellCentres[mCellNbr-1]); 
-	//minDistance initialized to the longest distance possible
-	//int closest = -1;
-	
-	//safety measures
-	//std::cout << "p : " << p << std::endl;
-	if ((p.x > mEnd.x+mGridSize.x/2) || (p.y > mEnd.y+mGridSize.y/2) || (p.z > mEnd.z+mGridSize.z/2)){
-		//std::cout << "filament out of borders!" << std::endl;
-		return -1;
-	}
-	
-	/*//find the closest point
-	for (i=0; i<mCellNbr; i++){
-		distance = p.Distance(mCellCentres[i]);
-		if (distance < minDistance){
-			minDistance = distance;
-			closest = i;
-		}
-		if (minDistance == 0)
-			break;
-	}*/
-	
-	//find the index
-	int ix,iy,iz, idx;
-	ix = round((p.x - mOrigin.x) / mGridSize.x); // + mGridSize.x/2
-	if(ix < 0) ix =0;
-	iy = round((p.y - mOrigin.y) / mGridSize.y);
-	if(iy < 0) iy =0;
-	iz = round((p.z - mOrigin.z) / mGridSize.z);
-	if(iz < 0) iz =0;
-	//std::cout << "p : " << p << " ix : " << ix << " iy : " << iy << " iz : " << iz << std::endl;
-	idx = mIndexTable[ix + mArraySize.x * iy + mArraySize.x * mArraySize.y * iz];
-	
-	//if (idx != closest)
-	//	std::cout << "p : " << p << " closest : " << mCellCentres[closest] << " idx : " << mCellCentres[idx] << std::endl;
-	//return closest;
-	return idx;
+void THISCLASS::AllocateArray(int count) {
+	delete [] mWind;
+	mWind = NULL;
+	if (count > 0) {
+		mWind = new Point3[count];
+	}
 }
 
-void THISCLASS::ReadTextFile(const std::string filename) {
-	TextFileReaderDouble f(filename);
+bool THISCLASS::ReadTextFile(const std::string filename) {
+	TextFileReaderWindGrid f(filename);
+	if (f.Error()) {
+		return false;
+	}
+	return f.Read(this);
 }
 
-void THISCLASS::ReadBinaryFile(const std::string filename) { //never used
+bool THISCLASS::ReadBinaryFile(const std::string filename) {
 	DataFileReader f(filename);
+	if (f.Error()) {
+		return false;
+	}
 
 	Point3Int arraysize;
+	Point3 origin;
+	Point3 gridsize;
 	arraysize.Read(f);
-	AllocateArray(arraysize);
-	mOrigin.Read(f);
-	mGridSize.Read(f);
-	f.mFile.read((char*)mWind, sizeof(Point3)*mArraySize.Volume());
+	origin.Read(f);
+	gridsize.Read(f);
+	if ((arraysize.x < 1) || (arraysize.y < 1) || (arraysize.z < 1)) {
+		return false;
+	}
+	AllocateRegularGrid(origin, gridsize, arraysize);
+	int count = mMesh->mCellCount;
+	f.mFile.read((char*)mWind, sizeof(Point3)*count);
+	bool ok = (f.mFile.gcount() == (std::streamsize)(sizeof(Point3)*count));
 	f.Close();
+	ResampleGrid();
+	return ok;
 }
 
-void THISCLASS::WriteBinaryFile(const std::string filename) { //never used
+void THISCLASS::WriteBinaryFile(const std::string filename) {
 	// Note that we don't store the time in the file. Timing information comes from the filename or from the folder structure.
+	// The resampled regular grid is written, so that the file can be read back without the mesh.
 	DataFileWriter f(filename);
-	mArraySize.Write(f);
-	mOrigin.Write(f);
-	mGridSize.Write(f);
-	f.mFile.write((char*)mWind, sizeof(Point3)*mArraySize.Volume());
+	Point3Int arraysize = mMesh->mArraySize;
+	arraysize.Write(f);
+	mMesh->mOrigin.Write(f);
+	mMesh->mGridSize.Write(f);
+	if (mMesh->mBlocks || mGridWindQ) {
+		for (int iz = 0; iz < arraysize.z; iz++) {
+			for (int iy = 0; iy < arraysize.y; iy++) {
+				for (int ix = 0; ix < arraysize.x; ix++) {
+					Point3 w = GetWindSpeed(Point3Int(ix, iy, iz));
+					f.mFile.write((char*)&w, sizeof(Point3));
+				}
+			}
+		}
+	} else {
+		f.mFile.write((char*)mGridWind, sizeof(Point3)*mGridWindCount);
+	}
 	f.Close();
 }
 
+void THISCLASS::AllocateRegularGrid(const Point3 &origin, const Point3 &gridsize, const Point3Int &arraysize) {
+	// Every grid point is a cell, so we don't need an index table
+	WindFieldMesh *mesh = new WindFieldMesh();
+	mesh->SetGrid(origin, gridsize, arraysize);
+	mesh->mCellCount = arraysize.Volume();
+	SetMesh(mesh);
+	for (int i = 0; i < mesh->mCellCount; i++) {
+		mWind[i] = Point3(0, 0, 0);
+	}
+}
+
+void THISCLASS::ResampleGrid(const WindFieldSnapshot &cells) {
+	mQuantizationErrorMax = 0;
+	mQuantizationErrorRMS = 0;
+
+	// (Re)allocate the grid if necessary (a shared grid is replaced by an own grid)
+	int cc = mMesh->GetGridPointCount();
+	bool quantized = (mStorage == sStorageInt16);
+	if ((cc != mGridWindCount) || (quantized != (mGridWindQ != NULL)) || mSharedGrid) {
+		FreeGrid();
+		if (cc > 0) {
+			if (quantized) {
+				mGridWindQ = new short[3 * cc];
+			} else {
+				mGridWind = new Point3[cc];
+			}
+			mGridWindCount = cc;
+		}
+	}
+	const Point3 *wind = cells.mWind;
+	if ((mGridWindCount == 0) || (! wind) || (cells.mMesh != mMesh)) {
+		return;
+	}
+	if (quantized) {
+		QuantizeGrid(wind);
+		return;
+	}
+
+	// Copy the wind speed of the nearest cell to each grid point
+	const int *indextable = mMesh->mIndexTable;
+	if (indextable) {
+		for (int i = 0; i < cc; i++) {
+			mGridWind[i] = wind[indextable[i]];
+		}
+	} else {
+		for (int i = 0; i < cc; i++) {
+			mGridWind[i] = wind[i];
+		}
+	}
+}
+
+// Quantizes one component.
+static inline short Quantize(double v, double inv) {
+	return (short)lrint(v * inv);
+}
+
+void THISCLASS::QuantizeGrid(const Point3 *wind) {
+	// The step is chosen such that the largest cell wind speed of each component maps to +-32767
+	Point3 vmax(0, 0, 0);
+	for (int i = 0; i < mMesh->mCellCount; i++) {
+		vmax.x = std::max(vmax.x, fabs(wind[i].x));
+		vmax.y = std::max(vmax.y, fabs(wind[i].y));
+		vmax.z = std::max(vmax.z, fabs(wind[i].z));
+	}
+	mQuantizationStep.x = (vmax.x > 0) ? vmax.x / 32767 : 1;
+	mQuantizationStep.y = (vmax.y > 0) ? vmax.y / 32767 : 1;
+	mQuantizationStep.z = (vmax.z > 0) ? vmax.z / 32767 : 1;
+	Point3 inv = mQuantizationStep.DotInv();
+
+	// Encode the nearest cell of each grid point, and measure the error against the double data
+	double sum2 = 0;
+	const int *indextable = mMesh->mIndexTable;
+	for (int i = 0; i < mGridWindCount; i++) {
+		const Point3 &w = wind[indextable ? indextable[i] : i];
+		short *q = mGridWindQ + 3 * i;
+		q[0] = Quantize(w.x, inv.x);
+		q[1] = Quantize(w.y, inv.y);
+		q[2] = Quantize(w.z, inv.z);
+		double e2 = (Point3(q[0], q[1], q[2]).DotMultiply(mQuantizationStep) - w).Length2();
+		sum2 += e2;
+		mQuantizationErrorMax = std::max(mQuantizationErrorMax, e2);
+	}
+	mQuantizationErrorMax = sqrt(mQuantizationErrorMax);
+	mQuantizationErrorRMS = sqrt(sum2 / mGridWindCount);
+}
+
+size_t THISCLASS::GetMemorySize() const {
+	size_t size = 0;
+	if (mWind) {
+		size += sizeof(Point3) * mMesh->mCellCount;
+	}
+	if (! mSharedGrid) {
+		size += (mGridWindQ ? 3 * sizeof(short) : sizeof(Point3)) * mGridWindCount;
+	}
+	return size;
+}
+
+struct THISCLASS::tSharedGrid {
+	double time;
+	int arraysize[3];
+	int interpolation;
+	int storage;
+	double origin[3];
+	double gridsize[3];
+	double step[3];
+	double errormax;
+	double errorrms;
+	int blocks;
+};
+
+size_t THISCLASS::GetSharedGridSize() const {
+	size_t data = (mGridWindQ ? 3 * sizeof(short) : sizeof(Point3)) * mGridWindCount;
+	const WindFieldBlockTable *blocks = mMesh->mBlocks;
+	return sizeof(tSharedGrid) + (blocks ? blocks->GetSharedSize() : 0) + data;
+}
+
+void THISCLASS::WriteSharedGrid(void *dst) const {
+	tSharedGrid *header = (tSharedGrid*)dst;
+	const WindFieldMesh *mesh = mMesh;
+	header->time = mTime;
+	header->arraysize[0] = mesh->mArraySize.x;
+	header->arraysize[1] = mesh->mArraySize.y;
+	header->arraysize[2] = mesh->mArraySize.z;
+	header->interpolation = mInterpolation;
+	header->storage = (mGridWindQ ? sStorageInt16 : sStorageDouble);
+	header->origin[0] = mesh->mOrigin.x;
+	header->origin[1] = mesh->mOrigin.y;
+	header->origin[2] = mesh->mOrigin.z;
+	header->gridsize[0] = mesh->mGridSize.x;
+	header->gridsize[1] = mesh->mGridSize.y;
+	header->gridsize[2] = mesh->mGridSize.z;
+	header->step[0] = mQuantizationStep.x;
+	header->step[1] = mQuantizationStep.y;
+	header->step[2] = mQuantizationStep.z;
+	header->errormax = mQuantizationErrorMax;
+	header->errorrms = mQuantizationErrorRMS;
+	header->blocks = (mesh->mBlocks ? (int)mesh->mBlocks->GetSharedSize() : 0);
+	char *data = (char*)(header + 1);
+	if (mesh->mBlocks) {
+		mesh->mBlocks->WriteShared(data);
+		data += header->blocks;
+	}
+	if (mGridWindQ) {
+		memcpy(data, mGridWindQ, 3 * sizeof(short) * mGridWindCount);
+	} else if (mGridWind) {
+		memcpy(data, mGridWind, sizeof(Point3) * mGridWindCount);
+	}
+}
+
+void THISCLASS::AttachSharedGrid(const void *src) {
+	const tSharedGrid *header = (const tSharedGrid*)src;
+	FreeGrid();
+	mTime = header->time;
+	mInterpolation = (eInterpolation)header->interpolation;
+	mStorage = (eStorage)header->storage;
+	mQuantizationStep = Point3(header->step[0], header->step[1], header->step[2]);
+	mQuantizationErrorMax = header->errormax;
+	mQuantizationErrorRMS = header->errorrms;
+
+	// New mesh with the grid geometry only (no cells)
+	WindFieldMesh *mesh = new WindFieldMesh();
+	mesh->SetGrid(Point3(header->origin[0], header->origin[1], header->origin[2]), Point3(header->gridsize[0], header->gridsize[1], header->gridsize[2]), Point3Int(header->arraysize[0], header->arraysize[1], header->arraysize[2]));
+	const char *data = (const char*)(header + 1);
+	if (header->blocks) {
+		mesh->mBlocks = new WindFieldBlockTable();
+		mesh->mBlocks->ReadShared(data);
+		data += header->blocks;
+	}
+	SetMesh(mesh, false);
+
+	// The lookups only read the grid, which can therefore point into the shared memory
+	if (mStorage == sStorageInt16) {
+		mGridWindQ = (short*)data;
+	} else {
+		mGridWind = (Point3*)data;
+	}
+	mGridWindCount = mesh->GetGridPointCount();
+	mSharedGrid = true;
+}
+
+// Grid accessor for the double storage.
+struct GridDouble {
+	const Point3 *mData;
+	GridDouble(const Point3 *data): mData(data) {}
+	Point3 operator[](int i) const {
+		return mData[i];
+	}
+};
+
+// Grid accessor for the int16 storage (decodes the grid point).
+struct GridInt16 {
+	const short *mData;
+	Point3 mStep;
+	GridInt16(const short *data, const Point3 &step): mData(data), mStep(step) {}
+	Point3 operator[](int i) const {
+		const short *q = mData + 3 * i;
+		return Point3(q[0] * mStep.x, q[1] * mStep.y, q[2] * mStep.z);
+	}
+};
+
 Point3 THISCLASS::GetWindSpeed(const Point3Int &p) const {
-//std::chrono::high_resolution_clock::time_point t1 = high_resolution_clock::now();
-	int i = XYZToI(p);
-//std::chrono::high_resolution_clock::time_point t2 = high_resolution_clock::now();
-//std::cout << "XYZToI executation time : " << std::chrono::duration_cast<microseconds>(t2-t1).count() << std::endl;
-	//std::cout << "p=" << p << " i=" << i << " wind=" << mWind[i] <<  std::endl;
-	if (i < 0) {
+	const Point3Int &arraysize = mMesh->mArraySize;
+	if ((mGridWindCount == 0) || (p.x < 0) || (p.y < 0) || (p.z < 0) || (p.x >= arraysize.x) || (p.y >= arraysize.y) || (p.z >= arraysize.z)) {
 		return Point3(-100, -100, -100);
 	}
-	/*if((mWind[i].y > 1) | (mWind[i].z > 1))
-		std::cout << "position: " << mCellCentres[i] << "	wind: " << mWind[i] << std::endl;*/
-	return mWind[i];
+	int i = mMesh->GridIndex(p);
+	if (mGridWindQ) {
+		return GridInt16(mGridWindQ, mQuantizationStep)[i];
+	}
+	return mGridWind[i];
 }
 
+// Trilinear interpolation from the base grid point index, with constant offsets to the other 7 corners. G is one of the grid accessors above.
+template <class G> static inline Point3 Trilinear(const G &w, int index, int dx, int dy, int dz, const Point3 &t) {
+	Point3 w000 = w[index];
+	Point3 w00 = w000 + (w[index + dx] - w000) * t.x;
+	Point3 w010 = w[index + dy];
+	Point3 w10 = w010 + (w[index + dy + dx] - w010) * t.x;
+	Point3 w001 = w[index + dz];
+	Point3 w01 = w001 + (w[index + dz + dx] - w001) * t.x;
+	Point3 w011 = w[index + dz + dy];
+	Point3 w11 = w011 + (w[index + dz + dy + dx] - w011) * t.x;
+	Point3 w0 = w00 + (w10 - w00) * t.y;
+	Point3 w1 = w01 + (w11 - w01) * t.y;
+	return w0 + (w1 - w0) * t.z;
+}
 
-Point3 THISCLASS::GetWindSpeed(const Point3 &preal) const {
-	int closest = 0, closestOp;
-	//int i = 0;
-	//double distance = 0.0, minDistance = mCellCentres[0].Distance(mCellCentres[mCellNbr-1]); 
-	
-	//safety measures
-	/*if ((preal.x > mEnd.x) || (preal.y > mEnd.y) || (preal.z > mEnd.z))
-		return Point3(-100, -100, -100);*/
-	
-	//find the closest points
-	/*for (i=0; i<mCellNbr; i++){
-		distance = preal.Distance(mCellCentres[i]);
-		if (distance < minDistance){
-			minDistance = distance;
-			closest = i;
+template <class G> inline void THISCLASS::LookupGrid(const G &w, bool trilinear, const Point3 *in, Point3 *out, int n) const {
+	const WindFieldMesh &mesh = *mMesh;
+	int index, dx, dy, dz;
+	Point3 t;
+	if (! trilinear) {
+		for (int i = 0; i < n; i++) {
+			out[i] = mesh.GridStencil(in[i], false, index, dx, dy, dz, t) ? w[index] : Point3(-100, -100, -100);
 		}
-	}*/
-	closest = XYZToI(preal);
-	
-	if (closest < 0) {
-		//std::cout << "closest < 0" << std::endl;
+		return;
+	}
+	for (int i = 0; i < n; i++) {
+		out[i] = mesh.GridStencil(in[i], true, index, dx, dy, dz, t) ? Trilinear(w, index, dx, dy, dz, t) : Point3(-100, -100, -100);
+	}
+}
+
+Point3 THISCLASS::GetWindSpeed(const Point3 &preal) const {
+	int index, dx, dy, dz;
+	Point3 t;
+	if ((mGridWindCount == 0) || (! mMesh->GridStencil(preal, mInterpolation == sInterpolationTrilinear, index, dx, dy, dz, t))) {
 		return Point3(-100, -100, -100);
 	}
-	
-	//find the opposit point
-	Point3 pOp;
-	if (preal.x > mCellCentres[closest].x)
-		pOp.x = mCellCentres[closest].x + mGridSize.x;
-	else
-		pOp.x = mCellCentres[closest].x - mGridSize.x;
-	if (preal.y > mCellCentres[closest].y)
-		pOp.y = mCellCentres[closest].y + mGridSize.y;
-	else
-		pOp.y = mCellCentres[closest].y - mGridSize.y;
-	if (preal.z > mCellCentres[closest].z)
-		pOp.z = mCellCentres[closest].z + mGridSize.z;
-	else
-		pOp.z = mCellCentres[closest].z - mGridSize.z;
-	
-	//find the index of pOp
-	/*minDistance = mCellCentres[0].Distance(mCellCentres[mCellNbr-1]); 
-	for (i=0; i<mCellNbr; i++){
-		distance = pOp.Distance(mCellCentres[i]);
-		if (distance < minDistance){
-			minDistance = distance;
-			closestOp = i;
+	if (mGridWindQ) {
+		GridInt16 w(mGridWindQ, mQuantizationStep);
+		return (mInterpolation == sInterpolationNearest) ? w[index] : Trilinear(w, index, dx, dy, dz, t);
+	}
+	GridDouble w(mGridWind);
+	return (mInterpolation == sInterpolationNearest) ? w[index] : Trilinear(w, index, dx, dy, dz, t);
+}
+
+void THISCLASS::GetWindSpeeds(const Point3 *in, Point3 *out, int n) const {
+	if (mGridWindCount == 0) {
+		for (int i = 0; i < n; i++) {
+			out[i] = Point3(-100, -100, -100);
 		}
-	}*/
-	closestOp = XYZToI(pOp);
-	if (closestOp < 0) {
-		//std::cout << "closestOp < 0 " << std::endl;
-		return Point3(-100, -100, -100);
+		return;
+	}
+
+	bool trilinear = (mInterpolation == sInterpolationTrilinear);
+	if (mGridWindQ) {
+		LookupGrid(GridInt16(mGridWindQ, mQuantizationStep), trilinear, in, out, n);
+	} else {
+		LookupGrid(GridDouble(mGridWind), trilinear, in, out, n);
+	}
+}
+
+Point3 THISCLASS::GridWindSpeed(int index, int dx, int dy, int dz, const Point3 &t) const {
+	if (mGridWindQ) {
+		GridInt16 w(mGridWindQ, mQuantizationStep);
+		return (mInterpolation == sInterpolationNearest) ? w[index] : Trilinear(w, index, dx, dy, dz, t);
+	}
+	GridDouble w(mGridWind);
+	return (mInterpolation == sInterpolationNearest) ? w[index] : Trilinear(w, index, dx, dy, dz, t);
+}
+
+void THISCLASS::GetWeightedWindSpeeds(const WindFieldSnapshot * const *snapshots, const double *weights, int count, const Point3 *in, Point3 *out, int n) {
+	// All snapshots share the grid of the first one
+	const WindFieldSnapshot *wfs = snapshots[0];
+	for (int j = 0; j < count; j++) {
+		if (snapshots[j]->mGridWindCount == 0) {
+			for (int i = 0; i < n; i++) {
+				out[i] = Point3(-100, -100, -100);
+			}
+			return;
+		}
+	}
+
+	const WindFieldMesh &mesh = *wfs->mMesh;
+	bool trilinear = (wfs->mInterpolation == sInterpolationTrilinear);
+	int index, dx, dy, dz;
+	Point3 t;
+	for (int i = 0; i < n; i++) {
+		if (! mesh.GridStencil(in[i], trilinear, index, dx, dy, dz, t)) {
+			out[i] = Point3(-100, -100, -100);
+			continue;
+		}
+		Point3 w = snapshots[0]->GridWindSpeed(index, dx, dy, dz, t) * weights[0];
+		for (int j = 1; j < count; j++) {
+			w += snapshots[j]->GridWindSpeed(index, dx, dy, dz, t) * weights[j];
+		}
+		out[i] = w;
 	}
-	Point3 wind = Point3(0,0,0), wtmp;
-/*
-	Point3 p = preal; //Fa 
-	Point3 p1 = mCellCentres[closest];
-	Point3 p2 = mCellCentres[closestOp];
-	Point3 pdiff1 = ((Point3)p2 - p).Abs();
-	Point3 pdiff2 = (p - (Point3)p1).Abs();
-	//std::cout << "p = " << p << "   p1 = " << p1 << "   p2 = " << p2 << std::endl;
-	//std::cout << "pdiff1 = " << pdiff1 << "   pdiff2 = " << pdiff2 << std::endl;
-	
-	wtmp = mWind[closest] * pdiff1.x * pdiff1.y * pdiff1.z;
-	wind += wtmp;
-	//std::cout << "wind1 = " << wtmp << "  wind = " << wind << " p = " << p1 << std::endl;
-	
-	wtmp = mWind[XYZToI(Point3(p1.x, p1.y, p2.z))] * pdiff1.x * pdiff1.y * pdiff2.z;
-	wind += wtmp;
-	//std::cout << "wind2 = " << wtmp << "  wind = " << wind << " p = " << Point3(p1.x, p1.y, p2.z) << std::endl;
-	
-	wtmp = mWind[XYZToI(Point3(p1.x, p2.y, p1.z))] * pdiff1.x * pdiff2.y * pdiff1.z;
-	wind += wtmp;
-	//std::cout << "wind3 = " << wtmp << "  wind = " << wind << " p = " << Point3(p1.x, p2.y, p1.z) << std::endl;
-	
-	wtmp = mWind[XYZToI(Point3(p1.x, p2.y, p2.z))] * pdiff1.x * pdiff2.y * pdiff2.z;
-	wind += wtmp;
-	//std::cout << "wind4 = " << wtmp << "  wind = " << wind << " p = " << Point3(p1.x, p2.y, p2.z) << std::endl;
-	
-	wtmp = mWind[XYZToI(Point3(p2.x, p1.y, p1.z))] * pdiff2.x * pdiff1.y * pdiff1.z;
-	wind += wtmp;
-	//std::cout << "wind5 = " << wtmp << "  wind = " << wind << " p = " << Point3(p2.x, p1.y, p1.z) << std::endl;
-	
-	wtmp = mWind[XYZToI(Point3(p2.x, p1.y, p2.z))] * pdiff2.x * pdiff1.y * pdiff2.z;
-	wind += wtmp;
-	//std::cout << "wind6 = " << wtmp << "  wind = " << wind << " p = " << Point3(p2.x, p1.y, p2.z) << std::endl;
-	
-	wtmp = mWind[XYZToI(Point3(p2.x, p2.y, p1.z))] * pdiff2.x * pdiff2.y * pdiff1.z;
-	wind += wtmp;
-	//std::cout << "wind7 = " << wtmp << "  wind = " << wind << " p = " << Point3(p2.x, p2.y, p1.z) << std::endl;
-	
-	wtmp = mWind[closestOp] * pdiff2.x * pdiff2.y * pdiff2.z;
-	wind += wtmp;
-	//std::cout << "wind8 = " << wtmp << "  wind = " << wind << " p = " << p2 << std::endl;
-
-	
-	wind = wind / (mGridSize.x * mGridSize.y * mGridSize.z);
-*/
-	wind = mWind[closest];
-	//std::cout << "wind = " << wind << std::endl;
-	return wind;
 }
 
 void THISCLASS::WriteConfiguration(std::ostream &out) {
 	out << "<WindFieldSnapshot>" << std::endl;
 	out << "\t<Time>" << mTime << "</Time>" << std::endl;
-	out << "\t<ArraySize>" << mArraySize << "</ArraySize>" << std::endl;
-	out << "\t<Origin>" << mOrigin << "</Origin>" << std::endl;
-	out << "\t<GridSize>" << mGridSize << "</GridSize>" << std::endl;
+	out << "\t<ArraySize>" << mMesh->mArraySize << "</ArraySize>" << std::endl;
+	out << "\t<Origin>" << mMesh->mOrigin << "</Origin>" << std::endl;
+	out << "\t<GridSize>" << mMesh->mGridSize << "</GridSize>" << std::endl;
+	const WindFieldBlockTable *blocks = mMesh->mBlocks;
+	if (blocks) {
+		out << "\t<BlockSize>" << blocks->GetBlockSize() << "</BlockSize>" << std::endl;
+		out << "\t<FineBlocks>" << blocks->GetFineCount() << " / " << blocks->GetBlockCount() << "</FineBlocks>" << std::endl;
+		out << "\t<StoredGridPoints>" << blocks->GetSampleCount() << " / " << mMesh->mArraySize.Volume() << "</StoredGridPoints>" << std::endl;
+	}
+	out << "\t<MeshMemory>" << mMesh->GetMemorySize() << " bytes, shared by " << mMesh->GetReferences() << " snapshots</MeshMemory>" << std::endl;
+	out << "\t<WindMemory>" << GetMemorySize() << " bytes</WindMemory>" << std::endl;
+	out << "\t<Interpolation>" << (mInterpolation == sInterpolationTrilinear ? "trilinear" : "nearest") << "</Interpolation>" << std::endl;
+	if (mStorage == sStorageInt16) {
+		out << "\t<Storage>int16</Storage>" << std::endl;
+		out << "\t<QuantizationStep>" << mQuantizationStep << "</QuantizationStep>" << std::endl;
+		out << "\t<QuantizationErrorMax>" << mQuantizationErrorMax << "</QuantizationErrorMax>" << std::endl;
+		out << "\t<QuantizationErrorRMS>" << mQuantizationErrorRMS << "</QuantizationErrorRMS>" << std::endl;
+	} else {
+		out << "\t<Storage>double</Storage>" << std::endl;
+	}
 	out << "</WindFieldSnapshot>" << std::endl;
 }
@@ -7,41 +7,70 @@
 class WindFieldSnapshot;
 
 #include <string>
+#include <stddef.h>
 #include "Point3.h"
 #include "Point3Int.h"
+#include "WindFieldMesh.h"
 
 //! WindFieldSnapshot
 class WindFieldSnapshot {
 	friend class WindFieldDynamic;
 	friend class WindFieldStatic;
 	friend class TextFileReaderOpenFOAMSamples;
+	friend class DataFileReaderWindSequence;
+
+public:
+	//! Interpolation modes used by GetWindSpeed.
+	enum eInterpolation {
+		sInterpolationNearest = 0,		//!< Wind speed of the nearest grid point.
+		sInterpolationTrilinear,		//!< Trilinear interpolation between the 8 surrounding grid points.
+	};
+	//! Storage formats of the resampled grid.
+	enum eStorage {
+		sStorageDouble = 0,				//!< One double per component (24 bytes per grid point).
+		sStorageInt16,					//!< One 16-bit integer per component, scaled per snapshot (6 bytes per grid point).
+	};
 
 protected:
 	//! Time.
 	double mTime;
-	//! Wind speeds.
+	//! Wind speeds of the cells (mMesh->mCellCount elements).
 	Point3 *mWind;
-	//! Dimensions of the wind speed array.
-	Point3Int mArraySize;
-	//! Origin of the wind speed grid.
-	Point3 mOrigin;	
-	//! End of the wind speed grid.
-	Point3 mEnd;
-	//! Distance between grid points.
-	Point3 mGridSize;
-	//  Index of nearest cell centre for every mGridSize, between mOrigin and mEnd (Fa)
-	int *mIndexTable;	//size = mArraySize.x * mArraySize.y * mArraySize.z
-	//  Center of all the cells containing one measurement (Fa)
-	Point3 *mCellCentres;
-	//  number of cells/measurements (Fa)
-	int mCellNbr;
-
-	//! Allocates the wind array.
-	void AllocateArray(const Point3Int &arraysize);
-	void AllocateArray(const int &arraysize);
-
-	//! Translates XYZ coordinates to an array index. If the coordinate is outside the current wind field, -1 is returned.
-	int XYZToI(const Point3 &p) const;
+	//! The mesh (grid geometry and cells), which may be shared with other snapshots.
+	WindFieldMesh *mMesh;
+	//! Wind speeds resampled on the regular grid (one per stored grid point, x varies fastest).
+	Point3 *mGridWind;
+	//! Number of allocated grid points in mGridWind.
+	int mGridWindCount;
+	//! Interpolation mode.
+	eInterpolation mInterpolation;
+	//! Storage format of the resampled grid.
+	eStorage mStorage;
+	//! Quantized wind speeds on the regular grid (3 components per grid point), used with sStorageInt16 instead of mGridWind.
+	short *mGridWindQ;
+	//! Wind speed represented by one quantization step, for each component.
+	Point3 mQuantizationStep;
+	//! Largest error (norm of the difference vector) introduced by the quantization.
+	double mQuantizationErrorMax;
+	//! Root mean square error introduced by the quantization.
+	double mQuantizationErrorRMS;
+	//! Whether the grid (mGridWind or mGridWindQ) is read-only memory shared with other processes (see AttachSharedGrid).
+	bool mSharedGrid;
+
+	//! Layout of the shared grid.
+	struct tSharedGrid;
+	//! Releases the resampled grid.
+	void FreeGrid();
+
+	//! Allocates the cell wind speeds.
+	void AllocateArray(int count);
+
+	//! Quantizes cell wind speeds onto the regular grid (sStorageInt16).
+	void QuantizeGrid(const Point3 *wind);
+	//! Returns the (interpolated) wind speed at a stencil computed by WindFieldMesh::GridStencil.
+	inline Point3 GridWindSpeed(int index, int dx, int dy, int dz, const Point3 &t) const;
+	//! Looks up n points on the grid accessed through w (double or int16 storage).
+	template <class G> inline void LookupGrid(const G &w, bool trilinear, const Point3 *in, Point3 *out, int n) const;
 
 public:
 	//! Constructor.
@@ -49,13 +78,19 @@ public:
 	//! Destructor.
 	~WindFieldSnapshot();
 
-	//! Copy
+	//! Copies the settings of another snapshot, and uses its mesh without own cell wind speeds (the grid is resampled from the cells of another snapshot, see ResampleGrid).
 	void WindFieldSnapshotCopy(WindFieldSnapshot &);
+	//! Uses a mesh (retaining it), and allocates the cell wind speeds unless cells is false (for snapshots resampled from the cells of another snapshot, see ResampleGrid).
+	void SetMesh(WindFieldMesh *mesh, bool cells = true);
+	//! Returns the mesh.
+	WindFieldMesh *GetMesh() const {
+		return mMesh;
+	}
 
-	//! Reads wind speed information from a text file.
-	void ReadTextFile(const std::string filename);
-	//! Reads wind speed information from a binary file.
-	void ReadBinaryFile(const std::string filename);
+	//! Reads wind speed information from a text file (see TextFileReaderWindGrid). Returns false if the file could not be read.
+	bool ReadTextFile(const std::string filename);
+	//! Reads wind speed information from a binary file written by WriteBinaryFile. Returns false if the file could not be read.
+	bool ReadBinaryFile(const std::string filename);
 	//! Writes wind speed information to a binary file.
 	void WriteBinaryFile(const std::string filename);
 
@@ -65,36 +100,89 @@ public:
 	}
 	//! Returns array size.
 	Point3Int GetArraySize() const {
-		return mArraySize;
+		return mMesh->mArraySize;
 	}
 	//! Returns the origin of the wind speed grid.
 	Point3 GetOrigin() const {
-		return mOrigin;
+		return mMesh->mOrigin;
 	}
 	//! Returns the distance between grid points.
 	Point3 GetGridSize() const {
-		return mGridSize;
+		return mMesh->mGridSize;
 	}
 
 	//! Sets the time.
 	void SetTime(double set) {
 		mTime = set;
 	}
-	//! Sets array size.
-	void SetArraySize(const Point3Int &set) {
-		mArraySize = set;
+	//! Sets the interpolation mode.
+	void SetInterpolation(eInterpolation set) {
+		mInterpolation = set;
+	}
+	//! Returns the interpolation mode.
+	eInterpolation GetInterpolation() const {
+		return mInterpolation;
+	}
+	//! Sets the storage format of the resampled grid. This takes effect with the next call to ResampleGrid.
+	void SetStorage(eStorage set) {
+		mStorage = set;
 	}
-	//! Sets the origin of the wind speed grid.
-	void SetOrigin(const Point3 &set) {
-		mOrigin = set;
+	//! Returns the storage format of the resampled grid.
+	eStorage GetStorage() const {
+		return mStorage;
 	}
-	//! Sets the distance between grid points.
-	void SetGridSize(const Point3 &set) {
-		mGridSize = set;
+	//! Returns the largest and the root mean square error of the quantized grid with respect to the double data (zero with sStorageDouble).
+	void GetQuantizationError(double &max, double &rms) const {
+		max = mQuantizationErrorMax;
+		rms = mQuantizationErrorRMS;
 	}
 
-	//! Returns the wind speed at a specific point.
+	//! Sets up a regular grid in which every grid point is a cell (no index table). The cell wind speeds are then set with SetCellWindSpeed.
+	void AllocateRegularGrid(const Point3 &origin, const Point3 &gridsize, const Point3Int &arraysize);
+	//! Returns the number of cells.
+	int GetCellCount() const {
+		return mMesh->mCellCount;
+	}
+	//! Sets the wind speed of one cell. Call ResampleGrid after modifying cells.
+	void SetCellWindSpeed(int i, const Point3 &set) {
+		mWind[i] = set;
+	}
+	//! Returns the wind speed of one cell.
+	Point3 GetCellWindSpeed(int i) const {
+		return mWind[i];
+	}
+	//! Resamples the cell wind speeds on the regular grid. This must be called whenever the cell wind speeds have changed.
+	void ResampleGrid() {
+		ResampleGrid(*this);
+	}
+	//! Resamples the cell wind speeds of another snapshot using the same mesh on the regular grid of this snapshot. Several snapshots can thus share one cell buffer, and only keep their grid.
+	void ResampleGrid(const WindFieldSnapshot &cells);
+	//! Releases the cell wind speeds and (if no other snapshot uses it) the cell part of the mesh, which are only needed by ResampleGrid. Call this once the grid has been resampled for the last time.
+	void FreeCells();
+	//! Returns the number of bytes allocated for the wind speeds of this snapshot (cells and own grid, without the mesh).
+	size_t GetMemorySize() const;
+	//! Stores the regular grid with a two-level layout (see WindFieldBlockTable), which takes ownership of blocks. This modifies the mesh, and thus all snapshots using it. Call ResampleGrid afterwards.
+	void SetBlockTable(WindFieldBlockTable *blocks) {
+		mMesh->SetBlockTable(blocks);
+	}
+	//! Returns the block table, or NULL if all grid points are stored.
+	const WindFieldBlockTable *GetBlockTable() const {
+		return mMesh->mBlocks;
+	}
+
+	//! Returns the number of bytes needed to share the resampled grid.
+	size_t GetSharedGridSize() const;
+	//! Writes the resampled grid (with its geometry) to shared memory.
+	void WriteSharedGrid(void *dst) const;
+	//! Uses a resampled grid written by WriteSharedGrid (possibly by another process) instead of the own grid, with a new mesh holding only the grid geometry. The memory must stay valid and is not modified. Only the lookup methods may be used afterwards.
+	void AttachSharedGrid(const void *src);
+
+	//! Returns the wind speed at a specific point (using the selected interpolation mode), or (-100, -100, -100) if the point is outside the wind field.
 	Point3 GetWindSpeed(const Point3 &preal) const;
+	//! Returns the wind speed at n points (out[i] is the wind speed at in[i]).
+	void GetWindSpeeds(const Point3 *in, Point3 *out, int n) const;
+	//! Returns the weighted sum of the wind speeds of several snapshots at n points. All snapshots must use the same grid and interpolation mode, so that the grid index of each point is computed only once.
+	static void GetWeightedWindSpeeds(const WindFieldSnapshot * const *snapshots, const double *weights, int count, const Point3 *in, Point3 *out, int n);
 	//! Returns the wind speed at one of the grid points.
 	Point3 GetWindSpeed(const Point3Int &p) const;
 
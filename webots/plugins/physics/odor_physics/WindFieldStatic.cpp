@@ -6,103 +6,102 @@
 #include <fstream>
 #include <sstream>
 #include "WindFieldStatic.h"
-#include "TextFileReaderOpenFOAMSamples.h"
+#include "DataFileReader.h"
+#include "ObstacleList.h"
 #define	THISCLASS WindFieldStatic
 
+unsigned long long THISCLASS::GetSharedKey(const std::string &file) const {
+	std::ostringstream settings;
+	settings.precision(17);
+	settings << file << " " << WindFieldSharedStore::GetFileStamp(file) << "\n" << mWindFieldSnapshot.GetStorage() << " " << mInterpolation << " " << mBlockSize << " " << mRefinementMargin;
+	std::vector<Cube> regions(mRefinementRegions);
+	if (mSimulation->mObstacleList) {
+		mSimulation->mObstacleList->GetCubes(regions);
+	}
+	for (unsigned int i = 0; i < regions.size(); i++) {
+		settings << " " << regions[i];
+	}
+	return WindFieldSharedStore::GetKey(settings.str());
+}
+
 bool THISCLASS::SetFile(const std::string &file) {
-	/* //Thomas
-	TextFileReaderOpenFOAMSamples tfr(file);
-	if (tfr.Error()) {
+	// Attach to the wind field of another process
+	if (! mSharedName.empty()) {
+		delete mShared;
+		mShared = new WindFieldSharedStore();
+		if (! mShared->Open(mSharedName, GetSharedKey(file))) {
+			std::cout << "Unable to use the shared wind field " << mSharedName << ", reading " << file << std::endl;
+			delete mShared;
+			mShared = NULL;
+		} else if ((! mShared->IsCreator()) && (mShared->GetCount() == 1)) {
+			mWindFieldSnapshot.AttachSharedGrid(mShared->Get(0));
+			mInterpolation = mWindFieldSnapshot.GetInterpolation();
+			return true;
+		}
+	}
+
+	// Binary files (written by WindFieldSnapshot::WriteBinaryFile) start with the SIM2 header
+	DataFileReader bf(file);
+	if (bf.Error() == DataFileReader::ERROR_FILE) {
+		std::cout << "unable to open the file " << file << std::endl;
+		return false;
+	}
+	bool binary = (bf.Error() == 0);
+	bf.Close();
+
+	mWindFieldSnapshot.SetInterpolation(mInterpolation);
+	bool ok = binary ? mWindFieldSnapshot.ReadBinaryFile(file) : mWindFieldSnapshot.ReadTextFile(file);
+	if (! ok) {
+		std::cout << "Unable to read the wind map " << file << std::endl;
+		delete mShared;
+		mShared = NULL;
 		return false;
 	}
-	tfr.Read(&mWindFieldSnapshot);
-	return true;
-	*/
 
-	//Fa
-	int size = 0;
-	int counter = 0;
+	// A text file header may override the interpolation mode
+	mInterpolation = mWindFieldSnapshot.GetInterpolation();
 
-	//open the file
-	//FILE * pFile = fopen (file.c_str(),"r");
-	std::ifstream mFile;
-	mFile.open(file.c_str(), std::ios::in);
-	// if the file exists
-	if(mFile.is_open()){
-		//extract the size and allocate memory
-		std::string line;	
-		std::getline(mFile, line);
-		std::istringstream iss(line);
-		iss >> size;
-		mWindFieldSnapshot.AllocateArray(size);
+	// Two-level layout: keep the stored grid points only
+	if (mBlockSize > 0) {
+		std::vector<Cube> regions(mRefinementRegions);
+		if (mSimulation->mObstacleList) {
+			mSimulation->mObstacleList->GetCubes(regions);
+		}
+		WindFieldBlockTable *blocks = new WindFieldBlockTable();
+		blocks->Build(mWindFieldSnapshot.GetOrigin(), mWindFieldSnapshot.GetGridSize(), mWindFieldSnapshot.GetArraySize(), mBlockSize, regions, mRefinementMargin);
+		mWindFieldSnapshot.SetBlockTable(blocks);
+		mWindFieldSnapshot.ResampleGrid();
+	}
 
-		// read the file line by line
-		while (std::getline(mFile, line)){
-			//std::cout << "line " << line << std::endl;
-			
-			// read one line
-			std::istringstream iss(line);
-			//std::cout << iss.str() << std::endl;
+	// The cells are not needed any more, as a static field is never resampled (only the grid remains, with 24 or 6 bytes per stored grid point)
+	mWindFieldSnapshot.FreeCells();
 
-			// seperate x, y and z
-			double a, b ,c;
-    		if (!(iss >> a >> b >> c)) 
-    			continue; // in case of useless lines
-    		
-    		// x
-    		mWindFieldSnapshot.mWind[counter].x = a; 
-    		// y
-    		mWindFieldSnapshot.mWind[counter].y = b;
-    		// z
-    		mWindFieldSnapshot.mWind[counter].z = c;
-    		
-    		// std::cout << "x=" << mWindFieldSnapshot.mWind[counter].x 
-    		// 			<< " y=" << mWindFieldSnapshot.mWind[counter].y 
-    		// 			<< " z=" << mWindFieldSnapshot.mWind[counter].z << std::endl;
-    		counter++;
+	// Publish the wind field for other processes, and use the shared copy
+	if (mShared && mShared->IsCreator()) {
+		mWindFieldSnapshot.WriteSharedGrid(mShared->Add(mWindFieldSnapshot.GetSharedGridSize()));
+		if (mShared->Publish()) {
+			mWindFieldSnapshot.AttachSharedGrid(mShared->Get(0));
 		}
-    } else{
-    	std::cout << "unable to open the file " << std::endl;
-    	return false;
-    }
+	}
+	return true;
+}
 
-    // make sure all of the elements are read
-    if(counter == size)
-    	return true;
-    else{
-    	std::cout << "Number of elements in file "<< file <<" incorrect" << std::endl;
-    	return false;
-    }
-    //Fa
+void THISCLASS::SetInterpolation(WindFieldSnapshot::eInterpolation set) {
+	mInterpolation = set;
+	mWindFieldSnapshot.SetInterpolation(set);
 }
 
 Point3 THISCLASS::GetWindSpeed(const Point3 &preal) {
-	//return mWindFieldSnapshot.GetWindSpeed(preal);
-	//printf("Inside WindFieldStatic::GetWindSpeed\n");
+	return mWindFieldSnapshot.GetWindSpeed(preal);
+}
 
-	//Fa
-	int index;
-	int nbins[3] = {100,64,19};						//HARD CODED /!\ //
-	float resolution[3] = {0.1586,0.0632,0.095};		//HARD CODED /!\ //
-	
-	//convert position to indices.
-	int indices[3];
-	indices[0] = (int)(preal.x / resolution[0]); 
-	indices[1] = (int)(preal.y / resolution[1]); 
-	indices[2] = (int)(preal.z / resolution[2]); 
-	
-	//convert indices to single index
-	index = indices[1] + indices[0]*nbins[1] + indices[2]*nbins[1]*nbins[0];
-	//if the index is not incorrect, return the corresponding wind value
-	if(index >= nbins[0] * nbins[1] * nbins[2] || index < 0){
-		// std::cout << "Dangerous ERROR in WindFieldStatic::GetWindSpeed. index >= " <<  mWindFieldSnapshot.mArraySize.x * mWindFieldSnapshot.mArraySize.y * mWindFieldSnapshot.mArraySize.z << std::endl;
-		// std::cout << "position (" << preal << ") -> indices " << indices[0] << " " <<indices[1] << " " << indices[2] << " index " << index << std::endl;
-		return Point3(-100, -100, -100);
-	}else{
-		//printf("position %f %f %f, indices %d %d %d, index %d, wind %f %f %f\n", preal.x, preal.y, preal.z, indices[0], indices[1], indices[2], index, mWindFieldSnapshot.mWind[index].x, mWindFieldSnapshot.mWind[index].y, mWindFieldSnapshot.mWind[index].z);
-		return mWindFieldSnapshot.mWind[index];
-	}
-	//Fa
+void THISCLASS::GetWindSpeeds(const Point3 *in, Point3 *out, int n) {
+	mWindFieldSnapshot.GetWindSpeeds(in, out, n);
+}
+
+double THISCLASS::GetResolution() {
+	const WindFieldMesh *mesh = mWindFieldSnapshot.GetMesh();
+	return (mesh ? mesh->GetMinGridSize() : 0);
 }
 
 void THISCLASS::WriteConfiguration(std::ostream &out) {
@@ -11,8 +11,10 @@ class WindFieldStatic;
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
 #include "WindField.h"
 #include "WindFieldSnapshot.h"
+#include "WindFieldSharedStore.h"
 
 //!	WindFieldStatic
 class WindFieldStatic: public WindField {
@@ -20,15 +22,52 @@ class WindFieldStatic: public WindField {
 protected:
 	//! Wind field snapshots.
 	WindFieldSnapshot mWindFieldSnapshot;
+	//! Interpolation mode.
+	WindFieldSnapshot::eInterpolation mInterpolation;
+	//! The name of the shared memory segment (empty if the wind field is not shared).
+	std::string mSharedName;
+	//! The shared memory segment.
+	WindFieldSharedStore *mShared;
+	//! The block size of the two-level grid layout (0 to store the full grid).
+	int mBlockSize;
+	//! The distance around obstacles and refinement regions within which blocks are refined.
+	double mRefinementMargin;
+	//! Regions (in addition to the obstacles) in which blocks are refined.
+	std::vector<Cube> mRefinementRegions;
+
+	//! Returns the key of the settings that determine the shared data (file with its modification time and size, storage, interpolation, and refinement around the regions and obstacles), so that a segment written with other settings is not used.
+	unsigned long long GetSharedKey(const std::string &file) const;
 
 public:
 	//! Constructor.
-	WindFieldStatic(Simulation *sim): WindField(sim) {}
+	WindFieldStatic(Simulation *sim): WindField(sim), mInterpolation(WindFieldSnapshot::sInterpolationNearest), mSharedName(), mShared(NULL), mBlockSize(0), mRefinementMargin(0), mRefinementRegions() {}
 	//! Destructor.
-	~WindFieldStatic() {}
+	~WindFieldStatic() {
+		delete mShared;
+	}
 
-	//! Reads a static wind field.
+	//! Reads a static wind field from a text file (see TextFileReaderWindGrid) or from a binary file.
 	bool SetFile(const std::string &file);
+	//! Sets the interpolation mode. The "interpolation" entry of a text file header takes precedence.
+	void SetInterpolation(WindFieldSnapshot::eInterpolation set);
+	//! Shares the wind field with other processes through a named shared memory segment (see WindFieldSharedStore). The first process reads the file, all others attach to its data. This must be called before SetFile.
+	void SetSharedMemory(const std::string &name) {
+		mSharedName = name;
+	}
+	//! Sets the storage format of the wind field. This must be called before SetFile.
+	void SetStorage(WindFieldSnapshot::eStorage set) {
+		mWindFieldSnapshot.SetStorage(set);
+	}
+
+	//! Stores the grid with a two-level layout (see WindFieldBlockTable): blocks of blocksize grid intervals are kept at full resolution within margin of the obstacles and of the refinement regions, and only their corners elsewhere. This must be called before SetFile.
+	void SetRefinement(int blocksize, double margin) {
+		mBlockSize = blocksize;
+		mRefinementMargin = margin;
+	}
+	//! Adds a region (e.g. around an odor source) in which the grid is kept at full resolution. This must be called before SetFile.
+	void AddRefinementRegion(const Cube &region) {
+		mRefinementRegions.push_back(region);
+	}
 
 	// WindField methods
 	void OnSimulationStart() {}
@@ -36,6 +75,8 @@ public:
 	void OnSimulationStep() {}
 	void OnWebotsPhysicsDraw() {}
 	Point3 GetWindSpeed(const Point3 &preal);
+	void GetWindSpeeds(const Point3 *in, Point3 *out, int n);
+	double GetResolution();
 	void WriteConfiguration(std::ostream &out);
 };
 
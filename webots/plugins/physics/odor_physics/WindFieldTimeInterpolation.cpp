@@ -0,0 +1,55 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#include "WindFieldTimeInterpolation.h"
+#define THISCLASS WindFieldTimeInterpolation
+
+void THISCLASS::Weights(eMode mode, const double *times, const bool *valid, double time, double *weights) {
+	for (int i = 0; i < 4; i++) {
+		weights[i] = 0;
+	}
+	if (! valid[1]) {
+		weights[2] = 1;
+		return;
+	}
+
+	// Position within the interval [t1, t2]
+	double d = times[2] - times[1];
+	double s = (d > 0 ? (time - times[1]) / d : 1);
+	s = (s < 0 ? 0 : (s > 1 ? 1 : s));
+	if (mode == sModeLinear) {
+		weights[1] = 1 - s;
+		weights[2] = s;
+		return;
+	}
+
+	// Hermite basis functions
+	double s2 = s * s;
+	double s3 = s2 * s;
+	double h00 = 2 * s3 - 3 * s2 + 1;
+	double h10 = s3 - 2 * s2 + s;
+	double h01 = -2 * s3 + 3 * s2;
+	double h11 = s3 - s2;
+	weights[1] = h00;
+	weights[2] = h01;
+
+	// Tangent at t1 (scaled to the unit interval): d * (p2 - p0) / (t2 - t0), or p2 - p1 if p0 is missing
+	if (valid[0] && (times[2] > times[0])) {
+		double a = d / (times[2] - times[0]);
+		weights[0] -= h10 * a;
+		weights[2] += h10 * a;
+	} else {
+		weights[1] -= h10;
+		weights[2] += h10;
+	}
+
+	// Tangent at t2: d * (p3 - p1) / (t3 - t1), or p2 - p1 if p3 is missing
+	if (valid[3] && (times[3] > times[1])) {
+		double b = d / (times[3] - times[1]);
+		weights[1] -= h11 * b;
+		weights[3] += h11 * b;
+	} else {
+		weights[1] -= h11;
+		weights[2] += h11;
+	}
+}
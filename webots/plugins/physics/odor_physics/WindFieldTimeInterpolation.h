@@ -0,0 +1,27 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classWindFieldTimeInterpolation
+#define classWindFieldTimeInterpolation
+
+class WindFieldTimeInterpolation;
+
+//!	Computes the weights for interpolating wind snapshots in time.
+/*!
+	The interpolation uses a stencil of 4 snapshots: the time lies between snapshots 1 and 2, and snapshots 0 and 3 (if available) are used to estimate the time derivatives for the cubic interpolation.
+	The snapshot times do not need to be equally spaced.
+*/
+class WindFieldTimeInterpolation {
+
+public:
+	//! Time interpolation modes.
+	enum eMode {
+		sModeLinear = 0,	//!< Linear interpolation between snapshots 1 and 2.
+		sModeCubic,			//!< Cubic Hermite interpolation between snapshots 1 and 2, with Catmull-Rom tangents (one-sided if snapshot 0 or 3 is missing).
+	};
+
+	//! Computes the weights of the 4 snapshots of the stencil at time. Missing snapshots (valid[i] == false) get weight 0. If snapshot 1 is missing, snapshot 2 gets weight 1. The time is clamped to the interval between snapshots 1 and 2.
+	static void Weights(eMode mode, const double *times, const bool *valid, double time, double *weights);
+};
+
+#endif
@@ -0,0 +1,150 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#include <iostream>
+#include <cmath>
+#include "WindFieldTurbulent.h"
+#include "RandomMersenneTwister.h"
+#define	THISCLASS WindFieldTurbulent
+
+THISCLASS::WindFieldTurbulent(Simulation *sim):
+		WindField(sim), mMeanWind(0, 0, 0), mIntensity(0.1), mLengthScale(1), mTimeScale(5), mModeCount(64), mSeed(1),
+		mKx(), mKy(), mKz(), mAx(), mAy(), mAz(), mBx(), mBy(), mBz(), mOmega(), mPhase() {
+}
+
+void THISCLASS::OnSimulationStart() {
+	CreateModes();
+	UpdatePhases();
+}
+
+void THISCLASS::OnSimulationStep() {
+	UpdatePhases();
+}
+
+void THISCLASS::CreateModes() {
+	int n = (mModeCount > 0 ? mModeCount : 0);
+	mKx.resize(n);
+	mKy.resize(n);
+	mKz.resize(n);
+	mAx.resize(n);
+	mAy.resize(n);
+	mAz.resize(n);
+	mBx.resize(n);
+	mBy.resize(n);
+	mBz.resize(n);
+	mOmega.resize(n);
+	mPhase.resize(n);
+	if (n == 0) {
+		return;
+	}
+
+	// The wave numbers cover 0.1/L to 10/L in logarithmic steps
+	RandomMersenneTwister rmt((RandomMersenneTwister::uint32)mSeed);
+	double length = (mLengthScale > 0 ? mLengthScale : 1);
+	double kmin = 0.1 / length;
+	double dlogk = log(100.0) / n;
+	double wsum = 0;
+	for (int i = 0; i < n; i++) {
+		double k = kmin * exp((i + 0.5) * dlogk);
+
+		// Random direction, uniform on the sphere
+		double dz = rmt.randExc() * 2 - 1;
+		double phi = rmt.randExc() * 2 * M_PI;
+		double r = sqrt(1 - dz * dz);
+		Point3 d(r * cos(phi), r * sin(phi), dz);
+
+		// Orthonormal basis (e1, e2) of the plane perpendicular to d
+		Point3 e1 = (fabs(d.x) < 0.9 ? Point3(1, 0, 0) : Point3(0, 1, 0));
+		e1 = e1 - d * (e1 * d);
+		e1 = e1 / e1.Length();
+		Point3 e2(d.y * e1.z - d.z * e1.y, d.z * e1.x - d.x * e1.z, d.x * e1.y - d.y * e1.x);
+
+		// Two random unit vectors in that plane (scaled below)
+		double alpha = rmt.randExc() * 2 * M_PI;
+		double beta = rmt.randExc() * 2 * M_PI;
+		Point3 a = e1 * cos(alpha) + e2 * sin(alpha);
+		Point3 b = e1 * cos(beta) + e2 * sin(beta);
+
+		// Von Karman energy spectrum E(k) ~ (kL)^4 / (1 + (kL)^2)^(17/6), integrated over the shell (dk = k dlogk)
+		double kl = k * length;
+		double w = pow(kl, 4) / pow(1 + kl * kl, 17.0 / 6.0) * k * dlogk;
+		wsum += w;
+
+		mKx[i] = k * d.x;
+		mKy[i] = k * d.y;
+		mKz[i] = k * d.z;
+		mAx[i] = a.x * sqrt(w);
+		mAy[i] = a.y * sqrt(w);
+		mAz[i] = a.z * sqrt(w);
+		mBx[i] = b.x * sqrt(w);
+		mBy[i] = b.y * sqrt(w);
+		mBz[i] = b.z * sqrt(w);
+
+		// Small eddies decorrelate faster (Kolmogorov scaling of the eddy turnover time)
+		double sign = (rmt.randInt() & 1 ? 1 : -1);
+		mOmega[i] = (mTimeScale > 0 ? sign * pow(kl, 2.0 / 3.0) / mTimeScale : 0);
+	}
+
+	// Each mode contributes |a|^2/2 + |b|^2/2 to the mean of |u'|^2, which should be 3 * intensity^2
+	double scale = sqrt(3 * mIntensity * mIntensity / wsum);
+	for (int i = 0; i < n; i++) {
+		mAx[i] *= scale;
+		mAy[i] *= scale;
+		mAz[i] *= scale;
+		mBx[i] *= scale;
+		mBy[i] *= scale;
+		mBz[i] *= scale;
+	}
+}
+
+void THISCLASS::UpdatePhases() {
+	double t = mSimulation->mSimulationTime;
+	for (unsigned int i = 0; i < mPhase.size(); i++) {
+		double advection = mKx[i] * mMeanWind.x + mKy[i] * mMeanWind.y + mKz[i] * mMeanWind.z;
+		mPhase[i] = fmod((mOmega[i] - advection) * t, 2 * M_PI);
+	}
+}
+
+Point3 THISCLASS::GetWindSpeed(const Point3 &preal) {
+	Point3 out;
+	GetWindSpeeds(&preal, &out, 1);
+	return out;
+}
+
+void THISCLASS::GetWindSpeeds(const Point3 *in, Point3 *out, int n) {
+	for (int j = 0; j < n; j++) {
+		out[j] = mMeanWind;
+	}
+
+	// Modes in the outer loop, such that the inner loop only has constant coefficients
+	int modes = mPhase.size();
+	for (int i = 0; i < modes; i++) {
+		double kx = mKx[i], ky = mKy[i], kz = mKz[i], phase = mPhase[i];
+		double ax = mAx[i], ay = mAy[i], az = mAz[i];
+		double bx = mBx[i], by = mBy[i], bz = mBz[i];
+		for (int j = 0; j < n; j++) {
+			double theta = kx * in[j].x + ky * in[j].y + kz * in[j].z + phase;
+			double c = cos(theta);
+			double s = sin(theta);
+			out[j].x += ax * c + bx * s;
+			out[j].y += ay * c + by * s;
+			out[j].z += az * c + bz * s;
+		}
+	}
+}
+
+// The smallest eddies have the wave number 10/L (see CreateModes).
+double THISCLASS::GetResolution() {
+	return (mLengthScale > 0 ? mLengthScale : 1) / 10;
+}
+
+void THISCLASS::WriteConfiguration(std::ostream &out) {
+	out << "<WindFieldTurbulent>" << std::endl;
+	out << "\t<MeanWind>" << mMeanWind << "</MeanWind>" << std::endl;
+	out << "\t<Intensity>" << mIntensity << "</Intensity>" << std::endl;
+	out << "\t<LengthScale>" << mLengthScale << "</LengthScale>" << std::endl;
+	out << "\t<TimeScale>" << mTimeScale << "</TimeScale>" << std::endl;
+	out << "\t<Modes>" << mModeCount << "</Modes>" << std::endl;
+	out << "\t<Seed>" << mSeed << "</Seed>" << std::endl;
+	out << "</WindFieldTurbulent>" << std::endl;
+}
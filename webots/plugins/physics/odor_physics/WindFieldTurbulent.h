@@ -0,0 +1,97 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+#ifndef classWindFieldTurbulent
+#define classWindFieldTurbulent
+
+class WindFieldTurbulent;
+
+#include <vector>
+#include "WindField.h"
+
+//!	WindFieldTurbulent
+/*!
+	Synthetic turbulent wind field: a constant mean wind plus a sum of random Fourier modes,
+
+		u(x, t) = U + sum_n a_n cos(k_n . (x - U t) + w_n t) + b_n sin(k_n . (x - U t) + w_n t)
+
+	with a_n and b_n perpendicular to k_n, which makes every mode (and hence the field) divergence-free.
+	The turbulent structures are carried along by the mean wind (frozen turbulence) and decorrelate with the time scale.
+	The wave numbers are spread logarithmically around 1/L and weighted with a von Karman spectrum, and the amplitudes are scaled such that each velocity component has the requested standard deviation.
+	The field is evaluated analytically, and needs neither files nor a grid.
+*/
+class WindFieldTurbulent: public WindField {
+
+protected:
+	//! The mean wind speed.
+	Point3 mMeanWind;
+	//! The standard deviation of each wind component (m/s).
+	double mIntensity;
+	//! The integral length scale (m).
+	double mLengthScale;
+	//! The time scale (s) on which the turbulence decorrelates in a frame moving with the mean wind.
+	double mTimeScale;
+	//! The number of Fourier modes.
+	int mModeCount;
+	//! The seed for the random modes.
+	unsigned long mSeed;
+
+	//! Wave vectors of the modes (kx, ky, kz).
+	std::vector<double> mKx, mKy, mKz;
+	//! Cosine amplitudes of the modes.
+	std::vector<double> mAx, mAy, mAz;
+	//! Sine amplitudes of the modes.
+	std::vector<double> mBx, mBy, mBz;
+	//! Angular frequencies of the modes.
+	std::vector<double> mOmega;
+	//! Phase offsets of the modes at the current time (updated in OnSimulationStep).
+	std::vector<double> mPhase;
+
+	//! Draws the random modes.
+	void CreateModes();
+	//! Updates the phase offsets to the current simulation time.
+	void UpdatePhases();
+
+public:
+	//! Constructor.
+	WindFieldTurbulent(Simulation *sim);
+	//! Destructor.
+	~WindFieldTurbulent() {}
+
+	//! Sets the mean wind speed.
+	void SetMeanWind(const Point3 &ws) {
+		mMeanWind = ws;
+	}
+	//! Sets the standard deviation of each wind component (m/s).
+	void SetIntensity(double intensity) {
+		mIntensity = intensity;
+	}
+	//! Sets the integral length scale (m).
+	void SetLengthScale(double length) {
+		mLengthScale = length;
+	}
+	//! Sets the time scale (s) on which the turbulence decorrelates.
+	void SetTimeScale(double time) {
+		mTimeScale = time;
+	}
+	//! Sets the number of Fourier modes. More modes give a smoother spectrum, but each lookup costs O(modes).
+	void SetModeCount(int count) {
+		mModeCount = count;
+	}
+	//! Sets the seed of the random modes. Simulations with the same seed and parameters see the same wind.
+	void SetSeed(unsigned long seed) {
+		mSeed = seed;
+	}
+
+	// WindField methods
+	void OnSimulationStart();
+	void OnSimulationEnd() {}
+	void OnSimulationStep();
+	void OnWebotsPhysicsDraw() {}
+	Point3 GetWindSpeed(const Point3 &preal);
+	void GetWindSpeeds(const Point3 *in, Point3 *out, int n);
+	double GetResolution();
+	void WriteConfiguration(std::ostream &out);
+};
+
+#endif
@@ -6,8 +6,10 @@
 #include <assert.h>
 
 #include "Simulation.h"
+#include "SimulationHostWebots.h"
 #include "FilamentSourceConstant.h"
 #include "WindFieldConstant.h"
+#include "WindFieldTurbulent.h"
 #include "WindFieldDynamic.h"
 #include "WindFieldStatic.h"
 #include "ObstacleList.h"
@@ -19,6 +21,7 @@
 #include "OdorModel.h"
 #include <fstream>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -29,6 +32,9 @@ static const int source_odor_count_max = 16;
 static const int sensor_odor_count_max = 9;
 static const int sensor_wind_count_max = 9;
 static bool save_odor_profile = false; // if this is true, then the odor profile will be saved to disk after 20 seconds
+static std::string checkpoint_save; // if not empty, a checkpoint is written to this file once the simulation time reaches checkpoint_save_time
+static double checkpoint_save_time = 0;
+static double simulation_time_offset = 0; // the simulation time of the loaded checkpoint (Webots starts at 0)
 
 Simulation *simulation;
 
@@ -39,9 +45,8 @@ void webots_physics_init() {
 	simulation->mSimulationTimeStep = 0.032;
 	simulation->mSimulationTime = dWebotsGetTime() / 1000.;
 
-	// Store world and space (in case we need that somewhere)
-	//simulation->mWebotsInterface.mWorldID = w;
-	//simulation->mWebotsInterface.mSpaceID = s;
+	// Positions and sensor values go through Webots
+	simulation->mHost = new SimulationHostWebots();
 
 	// Read parameters from the environment
 	char *windsensor_noise_stddev=getenv("WINDSENSOR_NOISE_STDDEV");
@@ -51,8 +56,29 @@ void webots_physics_init() {
 	char source_radius[10]; //char *source_radius=getenv("SOURCE_RADIUS");
 	char *FReleaseAmount=getenv("FReleaseAmount");
 	char *FWindSpeed=getenv("FWindSpeed");
+	char *filament_integrator=getenv("FILAMENT_INTEGRATOR");
+	char *filament_courant=getenv("FILAMENT_COURANT");
+	char *filament_check_segments=getenv("FILAMENT_CHECK_SEGMENTS");
+	char *filament_retire_outside_arena=getenv("FILAMENT_RETIRE_OUTSIDE_ARENA");
+	char *odor_update_period=getenv("ODOR_UPDATE_PERIOD");
+	char *sensor_interpolation=getenv("SENSOR_INTERPOLATION");
+	char *counter_interval=getenv("COUNTER_INTERVAL");
+	char *step_timing=getenv("STEP_TIMING");
+	char *obstacle_distance_resolution=getenv("OBSTACLE_DISTANCE_RESOLUTION");
+	char *checkpoint_load=getenv("CHECKPOINT_LOAD");
+	char *checkpoint_save_file=getenv("CHECKPOINT_SAVE");
+	char *checkpoint_save_at=getenv("CHECKPOINT_SAVE_TIME");
 	float wind_x, wind_y;
 	float FR_filamentAmount, FR_filamentWidth, FR_releaseAmount;
+	float turbulence_intensity, turbulence_length;
+	simulation->mOdorUpdatePeriod = (odor_update_period ? strtod(odor_update_period, 0) : 0); // e.g. 0.16 to update the plume every 5th physics step
+	simulation->mSensorInterpolation = (sensor_interpolation ? atoi(sensor_interpolation) != 0 : false);
+	simulation->mCounterInterval = (counter_interval ? atoi(counter_interval) : 0); // append the event counters to results/counters.csv every n odor updates (off by default)
+	if (step_timing && (atoi(step_timing) != 0)) { // write the wall time per subsystem to results/timing.csv
+		simulation->mTiming = new SimulationTiming();
+	}
+	checkpoint_save = (checkpoint_save_file ? checkpoint_save_file : ""); // e.g. results/checkpoint.bin, written once the plume is established
+	checkpoint_save_time = (checkpoint_save_at ? strtod(checkpoint_save_at, 0) : 12.8); // the 200 steps the static sensor network controller waits for
 	
 	//FR
 	if(access("../../../data/plugin_parameters/FILAMENT_STDDEV.txt", F_OK) != -1 ){
@@ -116,6 +142,22 @@ void webots_physics_init() {
 		fclose(sim_param_file);
 	} else
 		FR_releaseAmount = 20;
+	if(access("../../../data/plugin_parameters/turbulence_intensity.txt", F_OK) != -1 ){
+		FILE* sim_param_file = fopen("../../../data/plugin_parameters/turbulence_intensity.txt", "r");
+		int ok = 0;
+		ok = fscanf(sim_param_file, "%f", &turbulence_intensity);
+		if(ok) printf("turbulence_intensity : %f\n", turbulence_intensity);
+		fclose(sim_param_file);
+	} else
+		turbulence_intensity = 0;
+	if(access("../../../data/plugin_parameters/turbulence_length.txt", F_OK) != -1 ){
+		FILE* sim_param_file = fopen("../../../data/plugin_parameters/turbulence_length.txt", "r");
+		int ok = 0;
+		ok = fscanf(sim_param_file, "%f", &turbulence_length);
+		if(ok) printf("turbulence_length : %f\n", turbulence_length);
+		fclose(sim_param_file);
+	} else
+		turbulence_length = 1;
 	//FR end
 
 	printf("_______________________%s %s\n", FReleaseAmount, FWindSpeed);
@@ -139,15 +181,36 @@ void webots_physics_init() {
 	// 200 is the number of filaments. Should be the same as the number in the webots supervisor
 	new FilamentList(simulation, (filament_n ? strtol(filament_n, 0, 0) : 2400));
 // Fa
-	// Add a constant wind field
+	// Add a constant wind field (or a synthetic turbulent wind field with the same mean, if a turbulence intensity is given)
 	new ObstacleList(simulation);
-	WindFieldConstant *wf = new WindFieldConstant(simulation);
-	wf->SetWindSpeed(Point3(-(FWindSpeed ? strtof(FWindSpeed, 0) : 0.9), 0.0f, 0.0f)); // XXX: constant? // (X,Z,Y) !!!
-	wf->SetWindSpeed(Point3(-wind_x, -wind_y, 0.0f));
+	//simulation->mObstacleList->SetLookup(ObstacleList::sLookupBVH); // for large or sparse obstacle maps
+	if (access("../../../data/test_map.environment", F_OK) != -1) { // outer boundary of the arena
+		simulation->mObstacleList->ReadBoundaryFile("../../../data/test_map.environment");
+	}
+	if (access("../../../data/obstacle_list.txt", F_OK) != -1) { // the same obstacles as in the controllers, as columns from below the floor to well above the plume
+		simulation->mObstacleList->ReadObstacleListFile("../../../data/obstacle_list.txt", -1, 2);
+	}
+	if (obstacle_distance_resolution) { // e.g. 0.02 to reflect filaments off the obstacles and the arena walls
+		double resolution = strtod(obstacle_distance_resolution, 0);
+		simulation->mObstacleList->SetDistanceField(resolution, 4 * resolution);
+	}
+	if (turbulence_intensity > 0) {
+		WindFieldTurbulent *wf = new WindFieldTurbulent(simulation);
+		wf->SetMeanWind(Point3(-wind_x, -wind_y, 0.0f));
+		wf->SetIntensity(turbulence_intensity);
+		wf->SetLengthScale(turbulence_length);
+		wf->WriteConfiguration(std::cout);
+	} else {
+		WindFieldConstant *wf = new WindFieldConstant(simulation);
+		wf->SetWindSpeed(Point3(-(FWindSpeed ? strtof(FWindSpeed, 0) : 0.9), 0.0f, 0.0f)); // XXX: constant? // (X,Z,Y) !!!
+		wf->SetWindSpeed(Point3(-wind_x, -wind_y, 0.0f));
+	}
 
-	// Add a static wind field
+	// Add a static wind field (text file with a grid header, legacy text file or binary file, see TextFileReaderWindGrid)
 	// new ObstacleList(simulation);
 	// WindFieldStatic *wf = new WindFieldStatic(simulation);
+	// wf->SetInterpolation(WindFieldSnapshot::sInterpolationTrilinear);
+	// wf->SetSharedMemory("odor_wind_map"); // share the grid with other simulations on this machine
 	// if(access("../../../data/plugin_parameters/wind_map.txt", F_OK) != -1 ){
 	// 	wf->SetFile("../../../data/plugin_parameters/wind_map.txt");
 	// 	wf->WriteConfiguration(std::cout);
@@ -159,6 +222,15 @@ void webots_physics_init() {
     new ObstacleList(simulation);
     WindFieldDynamic *wf = new WindFieldDynamic(simulation);
     wf->SetFolder("/home/ercolani/Documents/OpenFoam/plugin/OpenFoam_to_test/37_NoSlip");
+    wf->SetInterpolation(WindFieldSnapshot::sInterpolationTrilinear); // or sInterpolationNearest
+    wf->SetStorage(WindFieldSnapshot::sStorageInt16); // or sStorageDouble
+    wf->SetTimeInterpolation(WindFieldTimeInterpolation::sModeCubic); // or sModeLinear
+    //wf->SetStartTime(60); // start one minute into the recorded sequence
+    //wf->SetLoop(30, 300, 10); // replay 30 s to 300 s in a loop, with a 10 s cross-fade
+    //wf->SetSequenceFile("/home/ercolani/Documents/OpenFoam/plugin/OpenFoam_to_test/37_NoSlip.wseq"); // compressed samples (see tools/wind_compress)
+    //wf->SetSharedMemory("odor_wind_37_NoSlip"); // share the mesh and loop window with other simulations on this machine
+    //wf->SetRefinement(8, 0.3); // full resolution only within 30 cm of the obstacles and refinement regions, every 8th grid point elsewhere
+    //wf->AddRefinementRegion(Cube(Point3(0, 0, 0), Point3(0.5, 0.5, 0.5))); // e.g. around the odor source
 	// "/home/rahbar/OpenFOAM/rahbar-v3.0+/run/PitzDaily_newTest_Obstacle_diffY_newBoundary_newObstacle_morePoint_lowSpeed"
 	// "/disal/rahbar/OpenFOAM_data/Wind0.1_Mesh15_ObstacleBig_Timestep0.16"
 	*/
@@ -169,6 +241,10 @@ void webots_physics_init() {
 	FilamentPropagation *fp = new FilamentPropagation(simulation);
 	fp->mConfiguration.mStdDev = (filament_stddev ? strtof(filament_stddev, 0) : 0.2); //0.02
 	fp->mConfiguration.mFilamentGrowthGamma = (filament_growth_gamma ? strtof(filament_growth_gamma, 0) : 4e-7);
+	fp->mConfiguration.mIntegrator = ((filament_integrator && (strcmp(filament_integrator, "midpoint") == 0)) ? FilamentPropagation::sIntegratorMidpoint : FilamentPropagation::sIntegratorEuler);
+	fp->mConfiguration.mCourantNumber = (filament_courant ? strtod(filament_courant, 0) : 0); // e.g. 0.5 to move at most half a grid cell per substep
+	fp->mConfiguration.mCheckSegments = (filament_check_segments ? atoi(filament_check_segments) != 0 : false);
+	fp->mConfiguration.mRetireOutsideArena = (filament_retire_outside_arena ? atoi(filament_retire_outside_arena) != 0 : false);
 
 	//printf("Running with stddev=%f gamma=%f\n", fp->mConfiguration.mStdDev, fp->mConfiguration.mFilamentGrowthGamma);
 
@@ -235,6 +311,15 @@ void webots_physics_init() {
 	// Initialize everything
 	simulation->OnSimulationStart();
 
+	// Warm start: continue from a checkpoint (e.g. with an established plume)
+	if (checkpoint_load) {
+		double webots_time = simulation->mSimulationTime;
+		if (simulation->ReadCheckpoint(checkpoint_load)) {
+			simulation_time_offset = simulation->mSimulationTime - webots_time;
+			std::cout << "Continuing from checkpoint " << checkpoint_load << " at t=" << simulation->mSimulationTime << std::endl;
+		}
+	}
+
 	// Write configuration
 	std::ofstream file((simulation->mResultsFolder + "/configuration.xml").c_str());
 	file << "<?xml version=\"1.0\" ?>" << std::endl;
@@ -250,12 +335,20 @@ void webots_physics_init() {
 
 void webots_physics_step() {
 	// Run one timestep of the simulation
-	double simulation_time = dWebotsGetTime() / 1000.;
+	double simulation_time = dWebotsGetTime() / 1000. + simulation_time_offset;
 	simulation->mSimulationTimeStep = simulation_time - simulation->mSimulationTime;
 	simulation->mSimulationTime = simulation_time;
 	//std::cout << simulation->mSimulationTime << std::endl;
 	simulation->OnSimulationStep();
 
+	// Write the checkpoint
+	if ((! checkpoint_save.empty()) && (simulation->mSimulationTime >= checkpoint_save_time)) {
+		if (simulation->WriteCheckpoint(checkpoint_save)) {
+			std::cout << "Checkpoint written to " << checkpoint_save << " at t=" << simulation->mSimulationTime << std::endl;
+		}
+		checkpoint_save.clear();
+	}
+
 	// Store an odor profile after 20 seconds
   if (save_odor_profile) {
     if ((simulation->mSimulationTime - 20. > 0) && (simulation->mSimulationTime - 20. < 0.064)) {
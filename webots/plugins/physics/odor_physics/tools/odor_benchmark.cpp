@@ -0,0 +1,392 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+// Microbenchmarks of the plume hot paths on synthetic inputs: OdorModel::GetConcentration, FilamentPropagation::OnSimulationStep, WindFieldSnapshot::GetWindSpeed, ObstacleList::GetObstacle, TextFileReaderOpenFOAMSamples::Read and GasMap2D::runKernelAlgorithm.
+// Each benchmark is repeated until it has run for at least the minimum time, and the fastest of 3 repetitions is reported as ns/op and items/s.
+// The results can be saved as JSON (one benchmark per line), and compared against such a file: benchmarks that are slower than the baseline by more than the threshold are reported as regressions (exit code 2).
+//
+// Usage: odor_benchmark [--filter text] [--min-time seconds] [--json file] [--baseline file] [--threshold fraction]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "Simulation.h"
+#include "ObstacleList.h"
+#include "WindFieldConstant.h"
+#include "WindFieldSnapshot.h"
+#include "FilamentList.h"
+#include "FilamentPropagation.h"
+#include "OdorModel.h"
+#include "TextFileReaderOpenFOAMSamples.h"
+#include "../../../../controllers/static_sensor_network_controller/gasMap2D.h"
+
+// A benchmark result.
+struct tResult {
+	std::string name;
+	double nsperop;
+	double itemspersecond;
+};
+
+// Command line options.
+static std::string filter;
+static double mintime = 0.2;
+static std::vector<tResult> results;
+
+// Returns true if the benchmark should run.
+static bool Selected(const std::string &name) {
+	return filter.empty() || (name.find(filter) != std::string::npos);
+}
+
+// Runs an operation (which processes items items) until it took at least mintime, 3 times, and records the fastest run.
+template <typename tOperation>
+static void Measure(const std::string &name, double items, tOperation operation) {
+	double best = -1;
+	for (int repetition = 0; repetition < 3; repetition++) {
+		long long ops = 1;
+		while (1) {
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (long long i = 0; i < ops; i++) {
+				operation();
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			if (seconds >= mintime) {
+				double ns = seconds * 1e9 / ops;
+				best = ((best < 0) || (ns < best) ? ns : best);
+				break;
+			}
+			// Aim for 1.5 times the minimum time (at most 100 times more operations)
+			double factor = (seconds > 0 ? 1.5 * mintime / seconds : 100);
+			ops = (long long)(ops * (factor > 100 ? 100 : (factor < 2 ? 2 : factor)));
+		}
+	}
+
+	tResult result = {name, best, items * 1e9 / best};
+	results.push_back(result);
+	printf("%-72s %14.1f ns/op %12.4g items/s\n", name.c_str(), result.nsperop, result.itemspersecond);
+	fflush(stdout);
+}
+
+// Fills a filament list with n filaments in a 4 m x 2 m x 0.5 m volume.
+static void FillFilaments(FilamentList *fl, int n, std::mt19937 &generator) {
+	std::uniform_real_distribution<double> ux(0, 4), uy(0, 2), uz(0, 0.5), uw(0.02, 0.2);
+	fl->SetCount(n);
+	for (int i = 0; i < n; i++) {
+		Filament *f = fl->AddFilament();
+		f->mPosition = Point3(ux(generator), uy(generator), uz(generator));
+		f->mWidth = uw(generator);
+		f->mAmount = 8.3e2;
+		f->mOdorType = 0;
+	}
+}
+
+static void BenchmarkOdorModel() {
+	const int counts[] = {1000, 10000, 100000};
+	const double radii[] = {0.1, 0.5, 1};
+	for (int c = 0; c < 3; c++) {
+		for (int r = 0; r < 3; r++) {
+			char name[128];
+			sprintf(name, "OdorModel::GetConcentration/filaments:%d/radius:%g", counts[c], radii[r]);
+			if (! Selected(name)) {
+				continue;
+			}
+
+			Simulation sim;
+			std::mt19937 generator(1);
+			FilamentList *fl = new FilamentList(&sim, 0);
+			FillFilaments(fl, counts[c], generator);
+			OdorModel *om = new OdorModel(&sim);
+			om->mCutRadius = radii[r];
+
+			std::uniform_real_distribution<double> ux(0, 4), uy(0, 2), uz(0, 0.5);
+			std::vector<Point3> points(1024);
+			for (unsigned int i = 0; i < points.size(); i++) {
+				points[i] = Point3(ux(generator), uy(generator), uz(generator));
+			}
+			unsigned int next = 0;
+			double sum = 0;
+			Measure(name, counts[c], [&]() {
+				sum += om->GetConcentration(points[next++ & 1023], 0);
+			});
+			if (sum < 0) {
+				printf("(checksum %g)\n", sum);
+			}
+			delete om;
+			delete fl;
+		}
+	}
+}
+
+static void BenchmarkFilamentPropagation() {
+	const int counts[] = {1000, 10000, 100000};
+	for (int c = 0; c < 3; c++) {
+		char name[128];
+		sprintf(name, "FilamentPropagation::OnSimulationStep/filaments:%d", counts[c]);
+		if (! Selected(name)) {
+			continue;
+		}
+
+		Simulation sim;
+		sim.mSimulationTimeStep = 0.032;
+		std::mt19937 generator(1);
+		ObstacleList *ol = new ObstacleList(&sim);
+		WindFieldConstant *wf = new WindFieldConstant(&sim);
+		wf->SetWindSpeed(Point3(0.5, 0.1, 0));
+		FilamentList *fl = new FilamentList(&sim, 0);
+		FillFilaments(fl, counts[c], generator);
+		FilamentPropagation *fp = new FilamentPropagation(&sim);
+		fp->mConfiguration.mStdDev = 0.1;
+		fp->mConfiguration.mFilamentGrowthGamma = 0;
+		Measure(name, counts[c], [&]() {
+			fp->OnSimulationStep();
+		});
+		delete fp;
+		delete fl;
+		delete wf;
+		delete ol;
+	}
+}
+
+static void BenchmarkWindFieldSnapshot() {
+	// Synthetic wind field with the size of the arena grid (100 x 64 x 19)
+	WindFieldSnapshot wfs;
+	Point3Int arraysize(100, 64, 19);
+	Point3 gridsize(0.1586, 0.0632, 0.095);
+	wfs.AllocateRegularGrid(Point3(0, 0, 0), gridsize, arraysize);
+	for (int i = 0; i < wfs.GetCellCount(); i++) {
+		wfs.SetCellWindSpeed(i, Point3(sin(i * 0.001), cos(i * 0.002), 0.01 * (i % 7)));
+	}
+
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<double> ux(0, gridsize.x * (arraysize.x - 1));
+	std::uniform_real_distribution<double> uy(0, gridsize.y * (arraysize.y - 1));
+	std::uniform_real_distribution<double> uz(0, gridsize.z * (arraysize.z - 1));
+	std::vector<Point3> points(1 << 16);
+	for (unsigned int i = 0; i < points.size(); i++) {
+		points[i] = Point3(ux(generator), uy(generator), uz(generator));
+	}
+
+	const char *storages[] = {"double", "int16"};
+	const char *interpolations[] = {"nearest", "trilinear"};
+	for (int s = 0; s < 2; s++) {
+		for (int m = 0; m < 2; m++) {
+			char name[128];
+			sprintf(name, "WindFieldSnapshot::GetWindSpeed/storage:%s/interpolation:%s", storages[s], interpolations[m]);
+			if (! Selected(name)) {
+				continue;
+			}
+
+			wfs.SetStorage((WindFieldSnapshot::eStorage)s);
+			wfs.ResampleGrid();
+			wfs.SetInterpolation(m == 0 ? WindFieldSnapshot::sInterpolationNearest : WindFieldSnapshot::sInterpolationTrilinear);
+			unsigned int next = 0;
+			Point3 sum(0, 0, 0);
+			Measure(name, 1, [&]() {
+				sum += wfs.GetWindSpeed(points[next++ & 0xffff]);
+			});
+			if (sum.x != sum.x) {
+				printf("(checksum %g)\n", sum.x);
+			}
+		}
+	}
+}
+
+static void BenchmarkObstacleList() {
+	const int counts[] = {10, 100, 1000};
+	const char *lookups[] = {"voxels", "bvh"};
+	for (int c = 0; c < 3; c++) {
+		for (int l = 0; l < 2; l++) {
+			char name[128];
+			sprintf(name, "ObstacleList::GetObstacle/obstacles:%d/lookup:%s", counts[c], lookups[l]);
+			if (! Selected(name)) {
+				continue;
+			}
+
+			// Random boxes of 5 cm to 30 cm in a 10 m x 4 m x 1 m room
+			Simulation sim;
+			ObstacleList *ol = new ObstacleList(&sim);
+			ol->SetLookup((ObstacleList::eLookup)l);
+			std::mt19937 generator(1);
+			std::uniform_real_distribution<double> ux(0, 10), uy(0, 4), uz(0, 1), us(0.05, 0.3);
+			for (int i = 0; i < counts[c]; i++) {
+				Point3 a(ux(generator), uy(generator), uz(generator));
+				ol->AddObstacle()->mCube = Cube(a, a + Point3(us(generator), us(generator), us(generator)));
+			}
+			std::vector<Point3> points(1 << 16);
+			for (unsigned int i = 0; i < points.size(); i++) {
+				points[i] = Point3(ux(generator), uy(generator), uz(generator));
+			}
+			ol->GetObstacle(points[0]);
+
+			unsigned int next = 0;
+			int hits = 0;
+			Measure(name, 1, [&]() {
+				hits += (ol->GetObstacle(points[next++ & 0xffff]) != 0);
+			});
+			if (hits < 0) {
+				printf("(checksum %d)\n", hits);
+			}
+			delete ol;
+		}
+	}
+}
+
+static void BenchmarkOpenFOAMSamples() {
+	const char *name = "TextFileReaderOpenFOAMSamples::Read/vectors:121600";
+	if (! Selected(name)) {
+		return;
+	}
+
+	// Synthetic samples file with the size of the arena grid (100 x 64 x 19)
+	char filename[] = "/tmp/odor_benchmark_XXXXXX";
+	int fd = mkstemp(filename);
+	if (fd < 0) {
+		printf("Unable to create a temporary file\n");
+		return;
+	}
+	close(fd);
+	int count = 100 * 64 * 19;
+	FILE *file = fopen(filename, "w");
+	fprintf(file, "FoamFile\n{\n    class       vectorField;\n}\n\n%d\n(\n", count);
+	for (int i = 0; i < count; i++) {
+		fprintf(file, "(%.6g %.6g %.6g)\n", sin(i * 0.001), cos(i * 0.002), 0.01 * (i % 7));
+	}
+	fprintf(file, ")\n");
+	fclose(file);
+
+	WindFieldSnapshot wfs;
+	wfs.AllocateRegularGrid(Point3(0, 0, 0), Point3(0.1586, 0.0632, 0.095), Point3Int(100, 64, 19));
+	Measure(name, count, [&]() {
+		TextFileReaderOpenFOAMSamples reader(filename);
+		reader.Read(&wfs);
+	});
+	unlink(filename);
+}
+
+static void BenchmarkGasMap2D() {
+	const double radii[] = {0.5, 1};
+	for (int r = 0; r < 2; r++) {
+		char name[128];
+		sprintf(name, "GasMap2D::runKernelAlgorithm/rco:%g", radii[r]);
+		if (! Selected(name)) {
+			continue;
+		}
+
+		GasMap2D *map = new GasMap2D(0.2, 0.3, 1, 0.5, radii[r]);
+		std::mt19937 generator(1);
+		std::uniform_real_distribution<double> ux(map_x_min, map_x_max), uy(map_y_min, map_y_max), uc(0, 100);
+		// Position has a user-declared copy constructor but no assignment operator, so the positions are copy-constructed
+		std::vector<Position> positions;
+		std::vector<float> odors(1024);
+		positions.reserve(odors.size());
+		for (unsigned int i = 0; i < odors.size(); i++) {
+			positions.push_back(Position(ux(generator), uy(generator)));
+			odors[i] = uc(generator);
+		}
+		unsigned int next = 0;
+		Measure(name, 1, [&]() {
+			unsigned int i = next++ & 1023;
+			map->runKernelAlgorithm(positions[i], odors[i]);
+		});
+		delete map;
+	}
+}
+
+// Writes the results as JSON, one benchmark per line.
+static bool WriteJSON(const std::string &filename) {
+	std::ofstream out(filename.c_str());
+	if (! out.is_open()) {
+		return false;
+	}
+	out << "{\n\t\"benchmarks\": [\n";
+	for (unsigned int i = 0; i < results.size(); i++) {
+		char line[512];
+		sprintf(line, "\t\t{\"name\": \"%s\", \"ns_per_op\": %.6g, \"items_per_second\": %.6g}%s\n", results[i].name.c_str(), results[i].nsperop, results[i].itemspersecond, (i + 1 < results.size() ? "," : ""));
+		out << line;
+	}
+	out << "\t]\n}\n";
+	return out.good();
+}
+
+// Reads the ns/op of each benchmark from a file written by WriteJSON.
+static bool ReadJSON(const std::string &filename, std::map<std::string, double> &baseline) {
+	std::ifstream in(filename.c_str());
+	if (! in.is_open()) {
+		return false;
+	}
+	std::string line;
+	while (std::getline(in, line)) {
+		char name[256];
+		double nsperop;
+		const char *start = strstr(line.c_str(), "{\"name\"");
+		if (start && (sscanf(start, "{\"name\": \"%255[^\"]\", \"ns_per_op\": %lf", name, &nsperop) == 2)) {
+			baseline[name] = nsperop;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char *argv[]) {
+	std::string json;
+	std::string baselinefile;
+	double threshold = 0.1;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if ((arg == "--filter") && (i + 1 < argc)) {
+			filter = argv[++i];
+		} else if ((arg == "--min-time") && (i + 1 < argc)) {
+			mintime = atof(argv[++i]);
+		} else if ((arg == "--json") && (i + 1 < argc)) {
+			json = argv[++i];
+		} else if ((arg == "--baseline") && (i + 1 < argc)) {
+			baselinefile = argv[++i];
+		} else if ((arg == "--threshold") && (i + 1 < argc)) {
+			threshold = atof(argv[++i]);
+		} else {
+			fprintf(stderr, "Usage: %s [--filter text] [--min-time seconds] [--json file] [--baseline file] [--threshold fraction]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	BenchmarkOdorModel();
+	BenchmarkFilamentPropagation();
+	BenchmarkWindFieldSnapshot();
+	BenchmarkObstacleList();
+	BenchmarkOpenFOAMSamples();
+	BenchmarkGasMap2D();
+
+	if ((! json.empty()) && (! WriteJSON(json))) {
+		fprintf(stderr, "Unable to write %s\n", json.c_str());
+		return 1;
+	}
+
+	// Compare with the baseline
+	if (baselinefile.empty()) {
+		return 0;
+	}
+	std::map<std::string, double> baseline;
+	if (! ReadJSON(baselinefile, baseline)) {
+		fprintf(stderr, "Unable to read %s\n", baselinefile.c_str());
+		return 1;
+	}
+	int regressions = 0;
+	printf("\nComparison with %s (threshold %.0f%%):\n", baselinefile.c_str(), threshold * 100);
+	for (unsigned int i = 0; i < results.size(); i++) {
+		std::map<std::string, double>::const_iterator it = baseline.find(results[i].name);
+		if (it == baseline.end()) {
+			printf("%-72s %14s\n", results[i].name.c_str(), "new");
+			continue;
+		}
+		double change = results[i].nsperop / it->second - 1;
+		bool regression = (change > threshold);
+		regressions += regression;
+		printf("%-72s %+13.1f%%%s\n", results[i].name.c_str(), change * 100, (regression ? " REGRESSION" : (change < -threshold ? " faster" : "")));
+	}
+	return (regressions > 0 ? 2 : 0);
+}
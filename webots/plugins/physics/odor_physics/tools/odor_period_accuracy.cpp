@@ -0,0 +1,136 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+// Checks that the odor update period (Simulation::mOdorUpdatePeriod) is only a performance setting, and does not change the plume physics.
+// A puff of filaments is released at the origin in a constant wind and propagated for a fixed time, once with an odor update at every physics step and once with each of the given periods.
+// The spread of the puff (standard deviation of the filament positions) and the mean filament width are compared with the run without period. The exit code is 1 if a difference exceeds the tolerance.
+// A wind sensor with a running average starts at zero in the same wind, and its step response is compared as well (at a time where all periods end with an odor update).
+//
+// Usage: odor_period_accuracy [tolerance=0.03]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "Simulation.h"
+#include "SimulationHostHeadless.h"
+#include "ObstacleList.h"
+#include "WindFieldConstant.h"
+#include "FilamentList.h"
+#include "FilamentPropagation.h"
+#include "OdorModel.h"
+#include "FilamentSourceList.h"
+#include "SensorList.h"
+#include "SensorWind.h"
+
+// Physics step and propagation time.
+static const double sTimeStep = 0.032;
+static const int sSteps = 400;
+// Puff size.
+static const int sFilaments = 20000;
+static const double sInitialWidth = 0.01;
+// Running average factor of the wind sensor, and physics step at which its value is taken (a multiple of all periods).
+static const double sRunningAverageFactor = 0.9;
+static const int sSensorSteps = 40;
+
+// Statistics of the puff at the end of a run.
+struct tPuff {
+	Point3 spread;
+	double width;
+	double sensor;
+};
+
+// Propagates the puff for sSteps physics steps with the given odor update period, and returns its statistics.
+static tPuff Run(double period) {
+	SimulationHostHeadless host;
+	Simulation sim;
+	sim.mHost = &host;
+	sim.mRandom.Seed(1);
+	sim.mSimulationTimeStep = sTimeStep;
+	sim.mSimulationTime = 0;
+	sim.mOdorUpdatePeriod = period;
+
+	new ObstacleList(&sim);
+	WindFieldConstant *wf = new WindFieldConstant(&sim);
+	wf->SetWindSpeed(Point3(0.5, 0, 0));
+	new FilamentList(&sim, sFilaments);
+	FilamentPropagation *fp = new FilamentPropagation(&sim);
+	fp->mConfiguration.mStdDev = 0.2;
+	fp->mConfiguration.mFilamentGrowthGamma = 1e-4;
+	new OdorModel(&sim);
+	new FilamentSourceList(&sim);
+	SensorList *sensorlist = new SensorList(&sim);
+	SensorWind *sw = new SensorWind(&sim);
+	sw->mWebotsInterface.mGeometryID = host.AddObject(Point3(0, 0, 0));
+	sw->mWebotsInterface.mChannel = 0;
+	sw->mConfiguration.mNoiseStdDev = 0;
+	sw->mConfiguration.mRunningAverageFactor = sRunningAverageFactor;
+	sensorlist->AddSensor(sw);
+	sim.OnSimulationStart();
+
+	// Release the puff
+	FilamentList *fl = sim.mFilamentList;
+	for (int i = 0; i < fl->GetCount(); i++) {
+		Filament *f = fl->AddFilament();
+		f->mPosition = Point3(0, 0, 0);
+		f->mPrevPosition = f->mPosition;
+		f->mAmount = 1;
+		f->mWidth = sInitialWidth;
+	}
+
+	double sensor = 0;
+	for (int s = 1; s <= sSteps; s++) {
+		double time = s * sTimeStep;
+		sim.mSimulationTimeStep = time - sim.mSimulationTime;
+		sim.mSimulationTime = time;
+		sim.OnSimulationStep();
+		if (s == sSensorSteps) {
+			int size = 0;
+			const Point3 *wind = (const Point3 *)host.GetData(0, size);
+			sensor = (size == sizeof(Point3) ? wind->x : 0.);
+		}
+	}
+
+	// Statistics
+	Point3 sum(0, 0, 0);
+	Point3 sum2(0, 0, 0);
+	double width = 0;
+	int count = 0;
+	for (int i = 0; i < fl->GetCount(); i++) {
+		Filament *f = fl->Get(i);
+		if (! f->mExists) {
+			continue;
+		}
+		sum += f->mPosition;
+		sum2 += Point3(f->mPosition.x * f->mPosition.x, f->mPosition.y * f->mPosition.y, f->mPosition.z * f->mPosition.z);
+		width += f->mWidth;
+		count++;
+	}
+	Point3 mean = sum / count;
+	tPuff puff;
+	puff.spread = Point3(sqrt(sum2.x / count - mean.x * mean.x), sqrt(sum2.y / count - mean.y * mean.y), sqrt(sum2.z / count - mean.z * mean.z));
+	puff.width = width / count;
+	puff.sensor = sensor;
+	return puff;
+}
+
+int main(int argc, char *argv[]) {
+	double tolerance = (argc > 1 ? strtod(argv[1], 0) : 0.03);
+	double periods[] = {0.16, 0.32, 0.64};
+
+	tPuff reference = Run(0);
+	printf("period  spread x  spread y  spread z  width     sensor\n");
+	printf("%6.2f  %8.5f  %8.5f  %8.5f  %8.5f  %8.5f\n", 0., reference.spread.x, reference.spread.y, reference.spread.z, reference.width, reference.sensor);
+	bool ok = true;
+	for (unsigned int i = 0; i < sizeof(periods) / sizeof(periods[0]); i++) {
+		tPuff puff = Run(periods[i]);
+		printf("%6.2f  %8.5f  %8.5f  %8.5f  %8.5f  %8.5f\n", periods[i], puff.spread.x, puff.spread.y, puff.spread.z, puff.width, puff.sensor);
+		double errors[] = {puff.spread.x / reference.spread.x - 1, puff.spread.y / reference.spread.y - 1, puff.spread.z / reference.spread.z - 1, puff.width / reference.width - 1, puff.sensor / reference.sensor - 1};
+		for (unsigned int j = 0; j < sizeof(errors) / sizeof(errors[0]); j++) {
+			if (fabs(errors[j]) > tolerance) {
+				ok = false;
+			}
+		}
+	}
+	printf("%s (tolerance %g)\n", (ok ? "passed" : "FAILED"), tolerance);
+	return (ok ? 0 : 1);
+}
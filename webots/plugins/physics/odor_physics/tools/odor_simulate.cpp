@@ -0,0 +1,471 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+// Runs an odor simulation without Webots, as fast as possible, and reports the throughput and the final sensor values.
+// Sources and sensors stay at the positions given in the configuration file, which contains one "key value ..." entry per line (# starts a comment):
+//
+//   steps 10000                  number of physics steps
+//   timestep 0.032               physics step (s)
+//   odor_update_period 0         see Simulation::mOdorUpdatePeriod
+//   filaments 2400               size of the filament list
+//   wind 0.9 0 0                 constant wind (m/s)
+//   turbulence 0.1 1             turbulence intensity and length scale (adds turbulence to the constant wind)
+//   stddev 0.2                   filament random walk
+//   gamma 4e-7                   filament growth
+//   integrator euler             euler or midpoint
+//   courant 0                    see FilamentPropagation::mConfiguration
+//   environment arena.txt        outer boundary of the arena (see ArenaGeometry)
+//   obstacles obstacles.txt      obstacles (see ObstacleList::ReadTextFile)
+//   distance_resolution 0.02     reflect filaments off obstacles and walls
+//   source 0 0.1 0 [release] [radius]
+//   odor_sensor 1 0.1 0
+//   wind_sensor 1 0.1 0
+//   results results              folder for configuration.xml, counters.csv and timing.csv
+//   counter_interval 100         see Simulation::mCounterInterval (single realization only)
+//   timing 0                     1 to time each subsystem (single realization only)
+//   series_interval 1            write the sensor values to series.csv every n steps (0 to disable)
+//   seed 1                       seed of the random numbers (the first realization uses seed, the second seed + 1, ...)
+//   realizations 1               number of independent plume realizations, with shared wind and obstacles (see SimulationEnsemble)
+//   threads 0                    threads stepping the realizations (0 for one per core)
+//   checkpoint_save file 400     write a checkpoint after n steps (single realization only, see Simulation::WriteCheckpoint)
+//   checkpoint_load file         continue from a checkpoint, e.g. with an established plume (single realization only)
+//
+// Usage: odor_simulate config [steps]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Simulation.h"
+#include "SimulationEnsemble.h"
+#include "SimulationHostHeadless.h"
+#include "ObstacleList.h"
+#include "WindFieldConstant.h"
+#include "WindFieldTurbulent.h"
+#include "FilamentList.h"
+#include "FilamentPropagation.h"
+#include "OdorModel.h"
+#include "FilamentSourceList.h"
+#include "FilamentSourceConstant.h"
+#include "SensorList.h"
+#include "SensorOdor.h"
+#include "SensorWind.h"
+
+// Channels of the sensors (the same as in the odor_physics plugin).
+static const int sensor_odor_count_max = 9;
+static const int sensor_wind_count_max = 9;
+
+// A source read from the configuration file.
+struct tSource {
+	Point3 position;
+	double release;
+	double radius;
+};
+
+// The configuration file (with the defaults of the odor_physics plugin).
+struct tConfiguration {
+	int steps;
+	double timestep;
+	double odor_update_period;
+	int filaments;
+	Point3 wind;
+	double turbulence_intensity;
+	double turbulence_length;
+	double stddev;
+	double gamma;
+	std::string integrator;
+	double courant;
+	std::string environment;
+	std::string obstacles;
+	double distance_resolution;
+	std::vector<tSource> sources;
+	std::vector<Point3> odor_sensors;
+	std::vector<Point3> wind_sensors;
+	std::string results;
+	int counter_interval;
+	bool timing;
+	int series_interval;
+	long seed;
+	int realizations;
+	int threads;
+	std::string checkpoint_save;
+	int checkpoint_save_step;
+	std::string checkpoint_load;
+
+	tConfiguration(): steps(10000), timestep(0.032), odor_update_period(0), filaments(2400), wind(0.9, 0, 0), turbulence_intensity(0), turbulence_length(1), stddev(0.2), gamma(4e-7), integrator("euler"), courant(0), environment(), obstacles(), distance_resolution(0), sources(), odor_sensors(), wind_sensors(), results("results"), counter_interval(100), timing(false), series_interval(1), seed(-1), realizations(1), threads(0), checkpoint_save(), checkpoint_save_step(0), checkpoint_load() {}
+};
+
+// Reads the configuration file. Returns false (after printing a message) if the file cannot be read or contains an invalid entry.
+static bool ReadConfiguration(const char *filename, tConfiguration &c) {
+	std::ifstream file(filename);
+	if (! file.is_open()) {
+		fprintf(stderr, "Unable to read %s\n", filename);
+		return false;
+	}
+	std::string line;
+	int linenumber = 0;
+	while (std::getline(file, line)) {
+		linenumber++;
+		std::string::size_type comment = line.find('#');
+		if (comment != std::string::npos) {
+			line.erase(comment);
+		}
+		std::istringstream in(line);
+		std::string key;
+		if (! (in >> key)) {
+			continue;
+		}
+
+		bool ok = true;
+		if (key == "steps") {
+			in >> c.steps;
+		} else if (key == "timestep") {
+			in >> c.timestep;
+		} else if (key == "odor_update_period") {
+			in >> c.odor_update_period;
+		} else if (key == "filaments") {
+			in >> c.filaments;
+		} else if (key == "wind") {
+			in >> c.wind.x >> c.wind.y >> c.wind.z;
+		} else if (key == "turbulence") {
+			in >> c.turbulence_intensity >> c.turbulence_length;
+		} else if (key == "stddev") {
+			in >> c.stddev;
+		} else if (key == "gamma") {
+			in >> c.gamma;
+		} else if (key == "integrator") {
+			in >> c.integrator;
+			ok = (c.integrator == "euler") || (c.integrator == "midpoint");
+		} else if (key == "courant") {
+			in >> c.courant;
+		} else if (key == "environment") {
+			in >> c.environment;
+		} else if (key == "obstacles") {
+			in >> c.obstacles;
+		} else if (key == "distance_resolution") {
+			in >> c.distance_resolution;
+		} else if (key == "source") {
+			tSource source = {Point3(), 20, 0.02};
+			in >> source.position.x >> source.position.y >> source.position.z;
+			ok = ! in.fail();
+			if (ok && (! (in >> source.release).fail())) {
+				in >> source.radius;
+			}
+			in.clear();	// release and radius are optional
+			c.sources.push_back(source);
+		} else if (key == "odor_sensor") {
+			Point3 position;
+			in >> position.x >> position.y >> position.z;
+			c.odor_sensors.push_back(position);
+		} else if (key == "wind_sensor") {
+			Point3 position;
+			in >> position.x >> position.y >> position.z;
+			c.wind_sensors.push_back(position);
+		} else if (key == "results") {
+			in >> c.results;
+		} else if (key == "counter_interval") {
+			in >> c.counter_interval;
+		} else if (key == "timing") {
+			int value = 0;
+			in >> value;
+			c.timing = (value != 0);
+		} else if (key == "series_interval") {
+			in >> c.series_interval;
+		} else if (key == "seed") {
+			in >> c.seed;
+			ok = (c.seed >= 0);
+		} else if (key == "realizations") {
+			in >> c.realizations;
+			ok = (c.realizations >= 1);
+		} else if (key == "threads") {
+			in >> c.threads;
+		} else if (key == "checkpoint_save") {
+			in >> c.checkpoint_save >> c.checkpoint_save_step;
+		} else if (key == "checkpoint_load") {
+			in >> c.checkpoint_load;
+		} else {
+			fprintf(stderr, "%s:%d: unknown key '%s'\n", filename, linenumber, key.c_str());
+			return false;
+		}
+		if ((! ok) || in.fail()) {
+			fprintf(stderr, "%s:%d: invalid value for '%s'\n", filename, linenumber, key.c_str());
+			return false;
+		}
+	}
+	if ((c.odor_sensors.size() > (unsigned int)sensor_odor_count_max) || (c.wind_sensors.size() > (unsigned int)sensor_wind_count_max)) {
+		fprintf(stderr, "At most %d odor sensors and %d wind sensors are supported\n", sensor_odor_count_max, sensor_wind_count_max);
+		return false;
+	}
+	if ((c.realizations > 1) && ((! c.checkpoint_save.empty()) || (! c.checkpoint_load.empty()))) {
+		fprintf(stderr, "Checkpoints are only supported with a single realization\n");
+		return false;
+	}
+	return true;
+}
+
+// Adds the obstacle list and the wind field to a simulation.
+static bool AddEnvironment(Simulation *sim, const tConfiguration &c) {
+	ObstacleList *ol = new ObstacleList(sim);
+	if ((! c.environment.empty()) && (! ol->ReadBoundaryFile(c.environment))) {
+		fprintf(stderr, "Unable to read %s\n", c.environment.c_str());
+		return false;
+	}
+	if (! c.obstacles.empty()) {
+		ol->ReadTextFile(c.obstacles);
+	}
+	if (c.distance_resolution > 0) {
+		ol->SetDistanceField(c.distance_resolution, 4 * c.distance_resolution);
+	}
+	if (c.turbulence_intensity > 0) {
+		WindFieldTurbulent *wf = new WindFieldTurbulent(sim);
+		wf->SetMeanWind(c.wind);
+		wf->SetIntensity(c.turbulence_intensity);
+		wf->SetLengthScale(c.turbulence_length);
+	} else {
+		WindFieldConstant *wf = new WindFieldConstant(sim);
+		wf->SetWindSpeed(c.wind);
+	}
+	return true;
+}
+
+// Adds the filament list, the propagation and odor models, the sources and the sensors to a simulation.
+static void AddPlume(Simulation *sim, SimulationHostHeadless *host, const tConfiguration &c) {
+	sim->mHost = host;
+	sim->mSimulationTimeStep = c.timestep;
+	sim->mSimulationTime = 0;
+	sim->mOdorUpdatePeriod = c.odor_update_period;
+	sim->mResultsFolder = c.results;
+
+	new FilamentList(sim, c.filaments);
+
+	FilamentPropagation *fp = new FilamentPropagation(sim);
+	fp->mConfiguration.mStdDev = c.stddev;
+	fp->mConfiguration.mFilamentGrowthGamma = c.gamma;
+	fp->mConfiguration.mIntegrator = (c.integrator == "midpoint" ? FilamentPropagation::sIntegratorMidpoint : FilamentPropagation::sIntegratorEuler);
+	fp->mConfiguration.mCourantNumber = c.courant;
+
+	OdorModel *om = new OdorModel(sim);
+	om->mCutRadius = 1;
+
+	FilamentSourceList *filamentsourcelist = new FilamentSourceList(sim);
+	SensorList *sensorlist = new SensorList(sim);
+	for (unsigned int i = 0; i < c.sources.size(); i++) {
+		FilamentSourceConstant *fs = new FilamentSourceConstant(sim);
+		fs->mWebotsInterface.mGeometryID = host->AddObject(c.sources[i].position);
+		fs->mConfiguration.mRadius = c.sources[i].radius;
+		fs->mConfiguration.mFilamentAmount = 8.3e2;
+		fs->mConfiguration.mFilamentWidth = 0.08;
+		fs->mConfiguration.mFilamentOdorType = 0;
+		fs->mConfiguration.mReleaseAmount = c.sources[i].release;
+		filamentsourcelist->AddFilamentSource(fs);
+	}
+	for (unsigned int i = 0; i < c.odor_sensors.size(); i++) {
+		SensorOdor *s = new SensorOdor(sim);
+		s->mWebotsInterface.mGeometryID = host->AddObject(c.odor_sensors[i]);
+		s->mWebotsInterface.mChannel = i;
+		s->mConfiguration.mOdorType = 0;
+		s->mConfiguration.mNoiseStdDev = 0;
+		s->mConfiguration.mRunningAverageFactor = 0.0;
+		sensorlist->AddSensor(s);
+	}
+	for (unsigned int i = 0; i < c.wind_sensors.size(); i++) {
+		SensorWind *s = new SensorWind(sim);
+		s->mWebotsInterface.mGeometryID = host->AddObject(c.wind_sensors[i]);
+		s->mWebotsInterface.mChannel = i + sensor_odor_count_max;
+		s->mConfiguration.mNoiseStdDev = 0;
+		s->mConfiguration.mRunningAverageFactor = 0.0;
+		sensorlist->AddSensor(s);
+	}
+}
+
+// Returns the last values sent by the sensors (odor sensors, followed by x, y and z of each wind sensor).
+static void GetSensorValues(const SimulationHostHeadless *host, const tConfiguration &c, std::vector<double> &values) {
+	values.clear();
+	for (unsigned int i = 0; i < c.odor_sensors.size(); i++) {
+		int size = 0;
+		const double *value = (const double *)host->GetData(i, size);
+		values.push_back(size == sizeof(double) ? value[0] : 0.);
+	}
+	for (unsigned int i = 0; i < c.wind_sensors.size(); i++) {
+		int size = 0;
+		const Point3 *value = (const Point3 *)host->GetData(i + sensor_odor_count_max, size);
+		Point3 wind = (size == sizeof(Point3) ? *value : Point3(0, 0, 0));
+		values.push_back(wind.x);
+		values.push_back(wind.y);
+		values.push_back(wind.z);
+	}
+}
+
+// Appends the sensor values of a realization to the series file.
+static void WriteSeriesLine(FILE *file, int realization, int step, double time, const std::vector<double> &values) {
+	fprintf(file, "%d,%d,%g", realization, step, time);
+	for (unsigned int i = 0; i < values.size(); i++) {
+		fprintf(file, ",%g", values[i]);
+	}
+	fprintf(file, "\n");
+}
+
+// Returns the number of existing filaments.
+static int CountFilaments(FilamentList *fl) {
+	int alive = 0;
+	for (int i = 0; i < fl->GetCount(); i++) {
+		if (fl->Get(i)->mExists) {
+			alive++;
+		}
+	}
+	return alive;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s config [steps]\n", argv[0]);
+		return 1;
+	}
+	tConfiguration c;
+	if (! ReadConfiguration(argv[1], c)) {
+		return 1;
+	}
+	if (argc > 2) {
+		c.steps = atoi(argv[2]);
+	}
+
+	// Results
+	mkdir(c.results.c_str(), 0755);
+	FILE *series = 0;
+	if (c.series_interval > 0) {
+		series = fopen((c.results + "/series.csv").c_str(), "w");
+		if (! series) {
+			fprintf(stderr, "Unable to create %s/series.csv\n", c.results.c_str());
+			return 1;
+		}
+		fprintf(series, "realization,step,time");
+		for (unsigned int i = 0; i < c.odor_sensors.size(); i++) {
+			fprintf(series, ",odor_%d", i);
+		}
+		for (unsigned int i = 0; i < c.wind_sensors.size(); i++) {
+			fprintf(series, ",wind_%d_x,wind_%d_y,wind_%d_z", i, i, i);
+		}
+		fprintf(series, "\n");
+	}
+	std::ofstream configuration((c.results + "/configuration.xml").c_str());
+	configuration << "<?xml version=\"1.0\" ?>" << std::endl;
+	configuration << "<OdorPhysics>" << std::endl;
+
+	// Set up the simulation (or the ensemble) in the same way as the odor_physics plugin. In an ensemble, simulation only holds the shared obstacle list and wind field.
+	Simulation simulation;
+	std::vector<SimulationHostHeadless*> hosts;
+	SimulationEnsemble *ensemble = 0;
+	if (c.realizations == 1) {
+		simulation.mCounterInterval = c.counter_interval;
+		if (c.timing) {
+			simulation.mTiming = new SimulationTiming();
+		}
+		if (c.seed >= 0) {
+			simulation.mRandom.Seed(c.seed);
+		}
+		hosts.push_back(new SimulationHostHeadless());
+		if (! AddEnvironment(&simulation, c)) {
+			return 1;
+		}
+		AddPlume(&simulation, hosts[0], c);
+		simulation.OnSimulationStart();
+		if ((! c.checkpoint_load.empty()) && (! simulation.ReadCheckpoint(c.checkpoint_load))) {
+			return 1;
+		}
+		simulation.WriteConfiguration(configuration);
+	} else {
+		// Each realization has its own random number stream (the counters of all realizations are summed when the ensemble ends)
+		simulation.mSimulationTimeStep = c.timestep;
+		if (! AddEnvironment(&simulation, c)) {
+			return 1;
+		}
+		ensemble = new SimulationEnsemble(&simulation, c.threads);
+		for (int k = 0; k < c.realizations; k++) {
+			Simulation *sim = new Simulation();
+			sim->mRandom.Seed((c.seed >= 0 ? c.seed : 1) + k);
+			hosts.push_back(new SimulationHostHeadless());
+			AddPlume(sim, hosts[k], c);
+			ensemble->AddRealization(sim);
+		}
+		ensemble->OnSimulationStart();
+		ensemble->WriteConfiguration(configuration);
+	}
+	configuration << "</OdorPhysics>" << std::endl;
+
+	// Run (after a checkpoint, the steps are numbered from the step of the checkpoint on)
+	int first = (int)floor(simulation.mSimulationTime / c.timestep + 0.5);
+	std::vector<double> values;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < c.steps; i++) {
+		double time = (first + i + 1) * c.timestep;
+		if (ensemble) {
+			ensemble->OnSimulationStep(time, c.timestep);
+		} else {
+			simulation.mSimulationTimeStep = c.timestep;
+			simulation.mSimulationTime = time;
+			simulation.OnSimulationStep();
+			if ((! c.checkpoint_save.empty()) && (first + i + 1 == c.checkpoint_save_step) && (! simulation.WriteCheckpoint(c.checkpoint_save))) {
+				return 1;
+			}
+		}
+		if (series && ((first + i + 1) % c.series_interval == 0)) {
+			for (unsigned int k = 0; k < hosts.size(); k++) {
+				GetSensorValues(hosts[k], c, values);
+				WriteSeriesLine(series, k, first + i + 1, time, values);
+			}
+		}
+	}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	if (ensemble) {
+		ensemble->OnSimulationEnd();
+	} else {
+		simulation.OnSimulationEnd();
+	}
+	if (series) {
+		fclose(series);
+	}
+
+	// Throughput (over all realizations)
+	double seconds = std::chrono::duration<double>(end - start).count();
+	int count = hosts.size();
+	int alive = 0;
+	int slots = 0;
+	std::vector<double> mean;
+	for (int k = 0; k < count; k++) {
+		FilamentList *fl = (ensemble ? ensemble->Get(k)->mFilamentList : simulation.mFilamentList);
+		alive += CountFilaments(fl);
+		slots += fl->GetCount();
+		GetSensorValues(hosts[k], c, values);
+		mean.resize(values.size(), 0);
+		for (unsigned int j = 0; j < values.size(); j++) {
+			mean[j] += values[j] / count;
+		}
+	}
+	printf("realizations        %d\n", count);
+	printf("threads             %d\n", (ensemble ? ensemble->GetThreadCount() : 1));
+	printf("steps               %d\n", c.steps);
+	printf("simulated time      %.3f s\n", c.steps * c.timestep);
+	printf("wall time           %.3f s\n", seconds);
+	printf("steps/s             %.1f\n", (double)c.steps * count / seconds);
+	printf("real time factor    %.1f\n", c.steps * c.timestep * count / seconds);
+	printf("filament slots/s    %.4g\n", (double)c.steps * slots / seconds);
+	printf("filaments alive     %d / %d\n", alive, slots);
+
+	// Final sensor values (mean over all realizations)
+	for (unsigned int i = 0; i < c.odor_sensors.size(); i++) {
+		printf("odor_sensor %d       %g\n", i, mean[i]);
+	}
+	for (unsigned int i = 0; i < c.wind_sensors.size(); i++) {
+		int j = c.odor_sensors.size() + 3 * i;
+		printf("wind_sensor %d       %g %g %g\n", i, mean[j], mean[j + 1], mean[j + 2]);
+	}
+	return 0;
+}
@@ -0,0 +1,115 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+// Compresses the OpenFOAM samples of a folder (one subfolder per simulation time, each containing a file U) into a wind sequence file for WindFieldDynamic::SetSequenceFile.
+// The file is decoded again afterwards to report the compression ratio and the largest error.
+//
+// Usage: wind_compress samples_folder output.wseq [step=0.0001] [keyframe_interval=32]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "WindFieldSnapshot.h"
+#include "WindFieldCatalog.h"
+#include "TextFileReaderOpenFOAMSamples.h"
+#include "DataFileWriterWindSequence.h"
+#include "DataFileReaderWindSequence.h"
+
+// Returns the size of a file in bytes.
+static long long FileSize(const std::string &file) {
+	struct stat st;
+	if (stat(file.c_str(), &st) != 0) {
+		return 0;
+	}
+	return st.st_size;
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s samples_folder output.wseq [step=0.0001] [keyframe_interval=32]\n", argv[0]);
+		return 1;
+	}
+	std::string folder(argv[1]);
+	std::string output(argv[2]);
+	double step = (argc > 3 ? atof(argv[3]) : 0.0001);
+	int keyframeinterval = (argc > 4 ? atoi(argv[4]) : 32);
+
+	// Collect the sample times
+	WindFieldCatalog catalog;
+	if (! catalog.Scan(folder)) {
+		fprintf(stderr, "Unable to access the samples folder %s\n", folder.c_str());
+		return 1;
+	}
+	std::vector<std::pair<double, std::string> > times;
+	for (int i = 0; i < catalog.GetCount(); i++) {
+		std::string file = folder + "/" + catalog.GetEntry(i).name + "/U";
+		if (FileSize(file) > 0) {
+			times.push_back(std::make_pair(catalog.GetEntry(i).time, file));
+		}
+	}
+	if (times.empty()) {
+		fprintf(stderr, "No samples found in %s\n", folder.c_str());
+		return 1;
+	}
+
+	// The snapshot is only used as a container for the cell wind speeds
+	int cellcount = TextFileReaderOpenFOAMSamples::VectorCount(times[0].second);
+	if (cellcount <= 0) {
+		fprintf(stderr, "Unable to read the number of cells from %s\n", times[0].second.c_str());
+		return 1;
+	}
+	WindFieldSnapshot wfs;
+	wfs.AllocateRegularGrid(Point3(0, 0, 0), Point3(1, 1, 1), Point3Int(cellcount, 1, 1));
+
+	// Encode
+	std::vector<std::vector<Point3> > originals;
+	long long textbytes = 0;
+	DataFileWriterWindSequence writer(output, cellcount, step, keyframeinterval);
+	if (writer.Error()) {
+		fprintf(stderr, "Unable to create %s\n", output.c_str());
+		return 1;
+	}
+	std::vector<Point3> wind(cellcount);
+	for (unsigned int k = 0; k < times.size(); k++) {
+		TextFileReaderOpenFOAMSamples tfr(times[k].second);
+		tfr.Read(&wfs);
+		for (int i = 0; i < cellcount; i++) {
+			wind[i] = wfs.GetCellWindSpeed(i);
+		}
+		writer.WriteFrame(times[k].first, &wind[0]);
+		textbytes += FileSize(times[k].second);
+		originals.push_back(wind);
+	}
+	writer.Close();
+
+	// Decode and compare
+	DataFileReaderWindSequence reader(output);
+	double errormax = 0;
+	double time;
+	unsigned int frames = 0;
+	while ((frames < originals.size()) && reader.ReadFrame(time, &wind[0])) {
+		for (int i = 0; i < cellcount; i++) {
+			Point3 diff = wind[i] - originals[frames][i];
+			errormax = std::max(errormax, std::max(fabs(diff.x), std::max(fabs(diff.y), fabs(diff.z))));
+		}
+		frames++;
+	}
+	if (frames != originals.size()) {
+		fprintf(stderr, "Decoding failed after %u frames\n", frames);
+		return 1;
+	}
+
+	long long filebytes = FileSize(output);
+	long long rawbytes = (long long)times.size() * cellcount * sizeof(Point3);
+	printf("frames:            %d (%d cells each)\n", writer.GetFrameCount(), cellcount);
+	printf("text samples:      %lld bytes\n", textbytes);
+	printf("raw doubles:       %lld bytes\n", rawbytes);
+	printf("sequence file:     %lld bytes (%.1fx smaller than text, %.1fx smaller than raw)\n", filebytes, (double)textbytes / filebytes, (double)rawbytes / filebytes);
+	printf("largest error:     %g (step %g)\n", errormax, step);
+	return 0;
+}
@@ -0,0 +1,93 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+// Measures the cost of a WindFieldSnapshot::GetWindSpeed lookup for each interpolation mode and storage format, both for single and batched (GetWindSpeeds) lookups.
+// The memory per grid point is reported for a snapshot that only keeps its grid (as the snapshots of WindFieldDynamic, which share one cell buffer, and WindFieldStatic after FreeCells).
+//
+// Usage: wind_interpolation_benchmark [lookups]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "WindFieldSnapshot.h"
+
+// Runs the lookups and returns the time per lookup in nanoseconds.
+static double Run(const WindFieldSnapshot &wfs, const std::vector<Point3> &positions, int lookups, Point3 &checksum) {
+	int count = positions.size();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < lookups; i++) {
+		checksum += wfs.GetWindSpeed(positions[i % count]);
+	}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / lookups;
+}
+
+// Runs the lookups in batches and returns the time per lookup in nanoseconds.
+static double RunBatched(const WindFieldSnapshot &wfs, const std::vector<Point3> &positions, int lookups, Point3 &checksum) {
+	int count = positions.size();
+	std::vector<Point3> wind(count);
+	int batches = (lookups + count - 1) / count;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int b = 0; b < batches; b++) {
+		wfs.GetWindSpeeds(&positions[0], &wind[0], count);
+		checksum += wind[b % count];
+	}
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / ((double)batches * count);
+}
+
+int main(int argc, char *argv[]) {
+	int lookups = (argc > 1 ? atoi(argv[1]) : 10000000);
+
+	// Synthetic wind field with the size of the arena grid (100 x 64 x 19)
+	WindFieldSnapshot wfs;
+	Point3Int arraysize(100, 64, 19);
+	Point3 gridsize(0.1586, 0.0632, 0.095);
+	wfs.AllocateRegularGrid(Point3(0, 0, 0), gridsize, arraysize);
+	for (int i = 0; i < wfs.GetCellCount(); i++) {
+		wfs.SetCellWindSpeed(i, Point3(sin(i * 0.001), cos(i * 0.002), 0.01 * (i % 7)));
+	}
+	wfs.ResampleGrid();
+
+	// Random positions inside the grid
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<double> ux(0, gridsize.x * (arraysize.x - 1));
+	std::uniform_real_distribution<double> uy(0, gridsize.y * (arraysize.y - 1));
+	std::uniform_real_distribution<double> uz(0, gridsize.z * (arraysize.z - 1));
+	std::vector<Point3> positions(1 << 16);
+	for (unsigned int i = 0; i < positions.size(); i++) {
+		positions[i] = Point3(ux(generator), uy(generator), uz(generator));
+	}
+
+	Point3 checksum;
+	printf("lookups:   %d\n", lookups);
+	const char *storage_names[2] = {"double", "int16"};
+	for (int storage = 0; storage < 2; storage++) {
+		wfs.SetStorage((WindFieldSnapshot::eStorage)storage);
+		wfs.ResampleGrid();
+
+		// Snapshot resampled from the cells of wfs, without own cells
+		WindFieldSnapshot grid;
+		grid.SetMesh(wfs.GetMesh(), false);
+		grid.SetStorage((WindFieldSnapshot::eStorage)storage);
+		grid.ResampleGrid(wfs);
+		double memory = (double)grid.GetMemorySize() / wfs.GetMesh()->GetGridPointCount();
+		wfs.SetInterpolation(WindFieldSnapshot::sInterpolationNearest);
+		double nearest = Run(wfs, positions, lookups, checksum);
+		double nearest_batched = RunBatched(wfs, positions, lookups, checksum);
+		wfs.SetInterpolation(WindFieldSnapshot::sInterpolationTrilinear);
+		double trilinear = Run(wfs, positions, lookups, checksum);
+		double trilinear_batched = RunBatched(wfs, positions, lookups, checksum);
+
+		double error_max, error_rms;
+		wfs.GetQuantizationError(error_max, error_rms);
+		printf("%s storage (max error %g, rms error %g):\n", storage_names[storage], error_max, error_rms);
+		printf("  memory:    %.1f bytes/grid point (cells: %.1f bytes/cell, shared)\n", memory, (double)(wfs.GetMemorySize() - grid.GetMemorySize()) / wfs.GetCellCount());
+		printf("  nearest:   %.2f ns/lookup (batched: %.2f ns/lookup)\n", nearest, nearest_batched);
+		printf("  trilinear: %.2f ns/lookup (batched: %.2f ns/lookup)\n", trilinear, trilinear_batched);
+	}
+	printf("(checksum %g)\n", checksum.x + checksum.y + checksum.z);
+	return 0;
+}
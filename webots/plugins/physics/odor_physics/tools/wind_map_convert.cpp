@@ -0,0 +1,25 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+// Converts a text wind map (see TextFileReaderWindGrid) into the binary format read by WindFieldStatic::SetFile, which loads much faster.
+//
+// Usage: wind_map_convert input.txt output.bin
+
+#include <stdio.h>
+#include "WindFieldSnapshot.h"
+
+int main(int argc, char *argv[]) {
+	if (argc != 3) {
+		fprintf(stderr, "Usage: %s input.txt output.bin\n", argv[0]);
+		return 1;
+	}
+
+	WindFieldSnapshot wfs;
+	if (! wfs.ReadTextFile(argv[1])) {
+		fprintf(stderr, "Unable to read %s\n", argv[1]);
+		return 1;
+	}
+	wfs.WriteBinaryFile(argv[2]);
+	wfs.WriteConfiguration(std::cout);
+	return 0;
+}
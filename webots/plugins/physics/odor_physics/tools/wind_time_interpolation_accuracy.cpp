@@ -0,0 +1,140 @@
+// Copyright (c) 2005-2008, Thomas Lochmatter, thomas.lochmatter@epfl.ch
+// Documentation: http://en.wikibooks.org/wiki/Webots_Odor_Simulation
+
+// Estimates how much less often the CFD output could be written when using cubic instead of linear time interpolation (WindFieldDynamic::SetTimeInterpolation).
+// Only every k-th snapshot of a recorded sequence is kept, and the snapshots in between are reconstructed with linear and cubic interpolation and compared with the recorded ones.
+//
+// Usage: wind_time_interpolation_accuracy samples_folder|sequence.wseq [max_stride=4]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "WindFieldSnapshot.h"
+#include "WindFieldCatalog.h"
+#include "WindFieldTimeInterpolation.h"
+#include "TextFileReaderOpenFOAMSamples.h"
+#include "DataFileReaderWindSequence.h"
+
+// Recorded sequence.
+static std::vector<double> sTimes;
+static std::vector<std::vector<Point3> > sFrames;
+
+// Reads all frames of a compressed sequence.
+static bool ReadSequence(const std::string &file) {
+	DataFileReaderWindSequence reader(file);
+	if (reader.Error()) {
+		return false;
+	}
+	std::vector<Point3> wind(reader.GetCellCount());
+	double time;
+	while (reader.ReadFrame(time, wind.empty() ? NULL : &wind[0])) {
+		sTimes.push_back(time);
+		sFrames.push_back(wind);
+	}
+	return true;
+}
+
+// Reads all samples of a folder.
+static bool ReadFolder(const std::string &folder) {
+	WindFieldCatalog catalog;
+	if (! catalog.Scan(folder)) {
+		return false;
+	}
+	WindFieldSnapshot wfs;
+	int cellcount = -1;
+	for (int i = 0; i < catalog.GetCount(); i++) {
+		std::string file = folder + "/" + catalog.GetEntry(i).name + "/U";
+		if (cellcount < 0) {
+			cellcount = TextFileReaderOpenFOAMSamples::VectorCount(file);
+			if (cellcount <= 0) {
+				continue;
+			}
+			wfs.AllocateRegularGrid(Point3(0, 0, 0), Point3(1, 1, 1), Point3Int(cellcount, 1, 1));
+		}
+		TextFileReaderOpenFOAMSamples tfr(file);
+		if (tfr.Error()) {
+			continue;
+		}
+		tfr.Read(&wfs);
+		std::vector<Point3> wind(cellcount);
+		for (int c = 0; c < cellcount; c++) {
+			wind[c] = wfs.GetCellWindSpeed(c);
+		}
+		sTimes.push_back(catalog.GetEntry(i).time);
+		sFrames.push_back(wind);
+	}
+	return true;
+}
+
+// Reconstructs the held-out frames for one stride and mode, and returns the RMS and largest error (norm of the difference vector).
+static void Evaluate(int stride, WindFieldTimeInterpolation::eMode mode, double &rms, double &max) {
+	int count = (int)sFrames.size();
+	double sum2 = 0;
+	long long n = 0;
+	max = 0;
+	for (int j = 0; j < count; j++) {
+		int a = j - j % stride;
+		int b = a + stride;
+		if ((j == a) || (b >= count)) {
+			continue;
+		}
+
+		// Stencil of kept frames
+		int index[4] = {a - stride, a, b, b + stride};
+		double times[4];
+		bool valid[4];
+		for (int i = 0; i < 4; i++) {
+			valid[i] = (index[i] >= 0) && (index[i] < count);
+			times[i] = (valid[i] ? sTimes[index[i]] : 0);
+		}
+		double weights[4];
+		WindFieldTimeInterpolation::Weights(mode, times, valid, sTimes[j], weights);
+
+		// Compare
+		for (unsigned int c = 0; c < sFrames[j].size(); c++) {
+			Point3 w(0, 0, 0);
+			for (int i = 0; i < 4; i++) {
+				if (valid[i] && (weights[i] != 0)) {
+					w += sFrames[index[i]][c] * weights[i];
+				}
+			}
+			double e2 = (w - sFrames[j][c]).Length2();
+			sum2 += e2;
+			max = std::max(max, e2);
+			n++;
+		}
+	}
+	rms = (n > 0 ? sqrt(sum2 / n) : 0);
+	max = sqrt(max);
+}
+
+int main(int argc, char *argv[]) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s samples_folder|sequence.wseq [max_stride=4]\n", argv[0]);
+		return 1;
+	}
+	std::string input(argv[1]);
+	int maxstride = (argc > 2 ? atoi(argv[2]) : 4);
+
+	if (! ReadSequence(input) && ! ReadFolder(input)) {
+		fprintf(stderr, "Unable to read %s\n", input.c_str());
+		return 1;
+	}
+	if (sFrames.size() < 3) {
+		fprintf(stderr, "At least 3 snapshots are needed\n");
+		return 1;
+	}
+	double interval = (sTimes.back() - sTimes.front()) / (sTimes.size() - 1);
+	printf("snapshots: %d (%d cells, mean interval %g s)\n", (int)sFrames.size(), (int)sFrames[0].size(), interval);
+	printf("stride  interval    linear rms  linear max   cubic rms   cubic max\n");
+	for (int stride = 2; stride <= maxstride; stride++) {
+		double lrms, lmax, crms, cmax;
+		Evaluate(stride, WindFieldTimeInterpolation::sModeLinear, lrms, lmax);
+		Evaluate(stride, WindFieldTimeInterpolation::sModeCubic, crms, cmax);
+		printf("%6d  %8.4g  %10.4g  %10.4g  %10.4g  %10.4g\n", stride, interval * stride, lrms, lmax, crms, cmax);
+	}
+	return 0;
+}